@@ -0,0 +1,42 @@
+#!/usr/bin/env bash
+# Copyright Dan Price 2026.
+
+# Checks the stem cache end to end: rendering songs/hello.json twice must play the second render from the cache, and
+# rendering it again after changing a part's volume must miss. Run from the repo root so the song's presets resolve:
+#   scripts/check_stem_cache.sh build/json2wav
+
+set -eu
+
+json2wav="$(realpath "${1:-build/json2wav}")"
+repo="$(pwd)"
+work="$(mktemp -d)"
+trap 'rm -rf "$work"' EXIT
+
+cp "$repo/songs/hello.json" "$work/hello.json"
+ln -s "$repo/presets" "$work/presets"
+cd "$work"
+
+# Prints "hits misses" for each render of a --bench run
+stems()
+{
+	"$json2wav" --bench --seed 1 --cache stems "$@" |
+		sed -E 's/.*"stemHits":([0-9]+),"stemMisses":([0-9]+).*/\1 \2/'
+}
+
+fail()
+{
+	echo "check_stem_cache: $1" >&2
+	exit 1
+}
+
+runs="$(stems --runs 2 hello.json)"
+read -r hits misses <<< "$(sed -n 1p <<< "$runs")"
+[ "$hits" -eq 0 ] && [ "$misses" -gt 0 ] || fail "first render should miss every stem, got $hits hits and $misses misses"
+read -r hits misses <<< "$(sed -n 2p <<< "$runs")"
+[ "$hits" -gt 0 ] && [ "$misses" -eq 0 ] || fail "second render should play from the cache, got $hits hits and $misses misses"
+
+sed -i 's/"volume": -15/"volume": -14/' hello.json
+read -r hits misses <<< "$(stems --runs 1 hello.json)"
+[ "$misses" -gt 0 ] || fail "render after editing a part should miss, got $hits hits and $misses misses"
+
+echo "check_stem_cache: ok"
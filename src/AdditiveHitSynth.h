@@ -12,6 +12,7 @@
 #include "Utility.h"
 #include "Memory.h"
 #include <utility>
+#include <cmath>
 
 namespace json2wav
 {
@@ -93,7 +94,7 @@ namespace json2wav
 				OnFrequencyChange(GetFrequency(), deltaTime);
 				//OnAmplitudeChange(GetAmplitude(), deltaTime);
 				OnHitChange();
-				GetSynthSamples(bufs, 1, numSamples, false, [this, buf, deltaTime](const size_t i)
+				GetSynthSamples(bufs, 1, numSamples, false, deltaTime, [this, buf, deltaTime](const size_t i)
 					{
 						const bool bIncAmp = IncrementHit(deltaTime);
 						Increment(deltaTime);
@@ -382,8 +383,8 @@ namespace json2wav
 			const unsigned long smpend = sampleNum + decayDelaySamps + decayTimeSamps + 1;
 
 			{
-				Vector<size_t> eventsToErase = GetEventKeysInRange(smpstart, smpend);
-				Vector<std::pair<size_t, size_t>> erasepairs;
+				const ScratchVector<size_t> eventsToErase = GetEventKeysInRange(smpstart, smpend);
+				ScratchVector<std::pair<size_t, size_t>> erasepairs(BlockScratch::Get());
 				for (const size_t smpnum : eventsToErase)
 				{
 					const Vector<SharedPtr<IEvent>>& smpevts = static_cast<const AdditiveHitSynth*>(this)->GetEvents(smpnum);
@@ -400,8 +401,8 @@ namespace json2wav
 
 			for (SharedPtr<FiltType> filt : filts)
 			{
-				Vector<size_t> filtevents = filt->GetEventKeysInRange(smpstart, smpend);
-				Vector<std::pair<size_t, size_t>> erasepairs;
+				const ScratchVector<size_t> filtevents = filt->GetEventKeysInRange(smpstart, smpend);
+				ScratchVector<std::pair<size_t, size_t>> erasepairs(BlockScratch::Get());
 				for (const size_t smpnum : filtevents)
 				{
 					const Vector<SharedPtr<IEvent>>& smpevts = static_cast<const FiltType&>(*filt).GetEvents(smpnum);
@@ -476,7 +477,38 @@ namespace json2wav
 			}
 		}
 
+		/** Does what numSamples calls to IncrementPhases would, in closed form */
+		void SkipPhases(const size_t numSamples)
+		{
+			const double n = static_cast<double>(numSamples);
+			for (size_t idx = 0; idx < amps.size(); ++idx)
+			{
+				const double nextphase = phases[idx] + n * dphases[idx];
+				phases[idx] = nextphase - std::floor(nextphase);
+			}
+		}
+
 	private:
+		virtual bool SkipSamples(const size_t numSamples, const double deltaTime) noexcept override
+		{
+			ProcessEventSpans(numSamples, [this, deltaTime](const size_t start, size_t count)
+				{
+					for ( ; count > 0 && IsRamping(); --count)
+					{
+						const bool bIncAmp = IncrementHit(deltaTime);
+						Increment(deltaTime);
+						if (bIncAmp)
+							OnHitChange();
+						if (Utility::FloatAbsGreaterEqual(GetAmplitude(), 0.0001f))
+							IncrementPhases(deltaTime);
+					}
+					IncrementSteady(count);
+					if (count > 0 && Utility::FloatAbsGreaterEqual(GetAmplitude(), 0.0001f))
+						SkipPhases(count);
+				});
+			return true;
+		}
+
 		virtual void OnFrequencyChange(const float basefreq, const double deltaTime) override
 		{
 			for (size_t idx = 0; idx < amps.size(); ++idx)
@@ -0,0 +1,66 @@
+// Copyright Dan Price 2026.
+
+#pragma once
+
+#ifdef ALBUMBOT_ALLOCGUARD
+#include "DebugNew.h"
+#endif
+
+#include <typeinfo>
+
+namespace json2wav::allocguard
+{
+#ifdef ALBUMBOT_ALLOCGUARD
+	/** While armed, every operator new outside an Exempt scope is recorded against the node rendering on that thread */
+	void Arm() noexcept;
+
+	/** Disarms and prints what was recorded; returns false if anything allocated while armed */
+	bool Disarm();
+
+	/** The node's address finds its NodeNames label for the report; its type stands in for unlabelled nodes */
+	struct NodeId
+	{
+		const void* node;
+		const std::type_info* type;
+	};
+
+	NodeId SetNode(NodeId node) noexcept;
+	void SetExempt(bool bExempt) noexcept;
+#else
+	inline void Arm() noexcept {}
+	inline bool Disarm() { return true; }
+#endif
+
+	/** Names the node whose GetSamples is running on this thread, for the report */
+	class NodeScope
+	{
+	public:
+#ifdef ALBUMBOT_ALLOCGUARD
+		template<typename NodeType>
+		explicit NodeScope(const NodeType& node) noexcept : prev(SetNode(NodeId{ &node, &typeid(node) })) {}
+		~NodeScope() noexcept { SetNode(prev); }
+	private:
+		const NodeId prev;
+#else
+		template<typename NodeType>
+		explicit NodeScope(const NodeType&) noexcept {}
+#endif
+	public:
+		NodeScope(const NodeScope&) = delete;
+		NodeScope& operator=(const NodeScope&) = delete;
+	};
+
+	/** Allocations the render loop can't avoid yet (launching render threads) */
+	class Exempt
+	{
+	public:
+#ifdef ALBUMBOT_ALLOCGUARD
+		Exempt() noexcept { SetExempt(true); }
+		~Exempt() noexcept { SetExempt(false); }
+#else
+		Exempt() noexcept {}
+#endif
+		Exempt(const Exempt&) = delete;
+		Exempt& operator=(const Exempt&) = delete;
+	};
+}
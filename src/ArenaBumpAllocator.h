@@ -5,6 +5,7 @@
 #include "MemoryCommon.h"
 #include "Logging.h"
 #include "Macros.h"
+#include "ThreadHeap.h"
 #include <mutex>
 #include <shared_mutex>
 #include <atomic>
@@ -19,11 +20,11 @@ namespace json2wav
 	struct ArenaBumpAllocatorTracking
 	{
 		ArenaBumpAllocatorTracking()
-			: StartByte(InvalidSize()), NumBytes(0), AlignBytes(0), NumReferences(0), Serial(InvalidUint32())
+			: StartByte(InvalidSize()), NumBytes(0), AlignBytes(0), NumReferences(0), Serial(InvalidUint32()), OwnerHeap(InvalidUint32()), NextFree(InvalidUint32())
 		{
 		}
 		ArenaBumpAllocatorTracking(size_t StartByteInit, uint32_t NumBytesInit, uint32_t AlignBytesInit)
-			: StartByte(StartByteInit), NumBytes(NumBytesInit), AlignBytes(AlignBytesInit), NumReferences(0), Serial(InvalidUint32())
+			: StartByte(StartByteInit), NumBytes(NumBytesInit), AlignBytes(AlignBytesInit), NumReferences(0), Serial(InvalidUint32()), OwnerHeap(InvalidUint32()), NextFree(InvalidUint32())
 		{
 		}
 		size_t StartByte = InvalidSize();
@@ -31,6 +32,17 @@ namespace json2wav
 		uint32_t AlignBytes = 0;
 		std::atomic<uint32_t> NumReferences = 0;
 		uint32_t Serial = InvalidUint32();
+		uint32_t OwnerHeap = InvalidUint32();
+		uint32_t NextFree = InvalidUint32();
+	};
+
+	/** A thread's free list of recycled allocations of one size and alignment, linked through the tracking entries */
+	struct ArenaBumpSizeClass
+	{
+		uint32_t NumBytes = 0;
+		uint32_t AlignBytes = 0;
+		uint32_t FreeTop = InvalidUint32();
+		uint32_t NumFree = 0;
 	};
 
 	struct AllocationRecycle
@@ -46,9 +58,31 @@ namespace json2wav
 		uint32_t Serial = InvalidUint32();
 	};
 
+	/**
+	 * Each thread bumps through its own span of the shared byte range and keeps its own free lists. Frees from another
+	 * thread go onto the owner's remote list; the shared byte range, tracking count and recycle stack are only for refill.
+	 */
 	class ArenaBumpAllocator
 	{
 	private:
+		static constexpr uint32_t MaxThreadHeaps = 1024;
+		static constexpr uint32_t MaxSizeClasses = 64;
+		static constexpr uint32_t TrackingBatch = 64;
+		static constexpr uint32_t SpanSize = 1u << 16;
+		static constexpr uint32_t SpanAlign = 64;
+
+		struct ThreadHeap : public ThreadHeapBase
+		{
+			size_t SpanNext = 0;
+			size_t SpanEnd = 0;
+			uint32_t TrackingNext = 0;
+			uint32_t TrackingEnd = 0;
+			uint32_t NumSizeClasses = 0;
+			ArenaBumpSizeClass SizeClasses[MaxSizeClasses];
+		};
+
+		using HeapRegistry = ThreadHeapRegistry<ThreadHeap, MaxThreadHeaps>;
+
 		static std::byte** GetBlocks()
 		{
 			static std::byte* Blocks[NumBlocks] = { 0 };
@@ -65,11 +99,7 @@ namespace json2wav
 		DEFINE_STATIC_PROPERTY(std::mutex, RecycleMutex);
 		DEFINE_STATIC_PROPERTY(std::shared_mutex, AllocationMutex);
 
-		static uint32_t NextSerial()
-		{
-			static std::atomic<uint32_t> Serial = 0;
-			return Serial.fetch_add(1);
-		}
+		DEFINE_STATIC_PROPERTY(std::atomic<uint32_t>, NextSerial, 0);
 
 		static void RemoveRecycleStackIndexUnsafe(AllocationRecycle* RecycleStack, uint32_t RecycleStackLength, uint32_t RecycleStackIndex)
 		{
@@ -139,6 +169,135 @@ namespace json2wav
 			return StartByte;
 		}
 
+		static ArenaBumpAllocatorTracking& GetTracking(uint32_t TrackingIndex)
+		{
+			return reinterpret_cast<ArenaBumpAllocatorTracking*>(GetTrackingBlock())[TrackingIndex];
+		}
+
+		static ArenaBumpSizeClass* FindSizeClass(ThreadHeap& Heap, uint32_t NumBytes, uint32_t AlignBytes, bool bCreate)
+		{
+			for (uint32_t ClassIndex = 0; ClassIndex < Heap.NumSizeClasses; ++ClassIndex)
+			{
+				ArenaBumpSizeClass& SizeClass = Heap.SizeClasses[ClassIndex];
+				if (SizeClass.NumBytes == NumBytes && SizeClass.AlignBytes == AlignBytes)
+				{
+					return &SizeClass;
+				}
+			}
+
+			if (bCreate && Heap.NumSizeClasses < MaxSizeClasses)
+			{
+				ArenaBumpSizeClass& SizeClass = Heap.SizeClasses[Heap.NumSizeClasses++];
+				SizeClass = ArenaBumpSizeClass{NumBytes, AlignBytes, InvalidUint32(), 0};
+				return &SizeClass;
+			}
+
+			return nullptr;
+		}
+
+		static bool PushLocalFree(ThreadHeap& Heap, uint32_t TrackingIndex)
+		{
+			ArenaBumpAllocatorTracking& Tracking = GetTracking(TrackingIndex);
+			if (ArenaBumpSizeClass* SizeClass = FindSizeClass(Heap, Tracking.NumBytes, Tracking.AlignBytes, true))
+			{
+				Tracking.NextFree = SizeClass->FreeTop;
+				SizeClass->FreeTop = TrackingIndex;
+				++SizeClass->NumFree;
+				return true;
+			}
+			return false;
+		}
+
+		/** Moves everything other threads freed on this heap's behalf into its own free lists */
+		static void DrainRemoteFrees(ThreadHeap& Heap)
+		{
+			uint32_t TrackingIndex = Heap.TakeRemote();
+			while (TrackingIndex != InvalidUint32())
+			{
+				const uint32_t NextTrackingIndex = GetTracking(TrackingIndex).NextFree;
+				if (!PushLocalFree(Heap, TrackingIndex))
+				{
+					RecycleShared(TrackingIndex);
+				}
+				TrackingIndex = NextTrackingIndex;
+			}
+		}
+
+		static uint32_t TakeLocalFree(ThreadHeap& Heap, uint32_t NumBytes, uint32_t AlignBytes)
+		{
+			ArenaBumpSizeClass* SizeClass = FindSizeClass(Heap, NumBytes, AlignBytes, false);
+			if (!SizeClass || SizeClass->NumFree == 0)
+			{
+				DrainRemoteFrees(Heap);
+				SizeClass = FindSizeClass(Heap, NumBytes, AlignBytes, false);
+			}
+
+			if (SizeClass && SizeClass->NumFree > 0)
+			{
+				const uint32_t TrackingIndex = SizeClass->FreeTop;
+				SizeClass->FreeTop = GetTracking(TrackingIndex).NextFree;
+				--SizeClass->NumFree;
+				LOG_MEMORY(Allocation, "Reusing ", AlignBytes, " byte aligned ", NumBytes, " byte allocation with tracking index ", TrackingIndex);
+				return TrackingIndex;
+			}
+
+			return InvalidUint32();
+		}
+
+		/** Bump within the thread's span, reserving a new span from the shared byte range when it runs out */
+		static size_t BumpBytes(ThreadHeap& Heap, uint32_t NumBytes, uint32_t AlignBytes)
+		{
+			const size_t Alignment = AlignBytes;
+			size_t StartByte = Heap.SpanNext + ((Alignment - (Heap.SpanNext & (Alignment - 1))) & (Alignment - 1));
+			if (StartByte + NumBytes > Heap.SpanEnd)
+			{
+				// Big allocations would waste most of a span
+				if (NumBytes > SpanSize / 4)
+				{
+					return ReserveBytes(NumBytes, AlignBytes);
+				}
+
+				Heap.SpanNext = ReserveBytes(SpanSize, SpanAlign);
+				Heap.SpanEnd = Heap.SpanNext + SpanSize;
+				StartByte = Heap.SpanNext + ((Alignment - (Heap.SpanNext & (Alignment - 1))) & (Alignment - 1));
+			}
+			Heap.SpanNext = StartByte + NumBytes;
+			return StartByte;
+		}
+
+		static void RecycleShared(uint32_t TrackingIndex)
+		{
+			ArenaBumpAllocatorTracking& Tracking = GetTracking(TrackingIndex);
+
+			std::unique_lock<std::mutex> Lock(GetRecycleMutex());
+
+			std::byte* RecycleBlock = GetRecycleBlock();
+			if (!RecycleBlock)
+			{
+				LOG_MEMORY(Allocation, "Allocating ", RecycleBlockSize, " bytes with ", RecycleBlockSize, " byte alignment for recycle block");
+				RecycleBlock = reinterpret_cast<std::byte*>(std::aligned_alloc(RecycleBlockSize, RecycleBlockSize));
+				if (!RecycleBlock)
+				{
+					MemoryError("ArenaBumpAllocator::RecycleAllocation could not allocate the recycle block");
+					return;
+				}
+
+				GetRecycleBlock() = RecycleBlock;
+			}
+
+			const uint32_t RecycleIndex = GetRecycleCount().fetch_add(1);
+			if (RecycleIndex >= MaxObjects)
+			{
+				GetRecycleCount().fetch_sub(1);
+				MemoryError("ArenaBumpAllocator::RecycleAllocation is recycling too many objects");
+				return;
+			}
+
+			LOG_MEMORY(Tracking, "Recycle stack size is ", RecycleIndex + 1);
+			std::byte* RecycleStorage = RecycleBlock + RecycleIndex * sizeof(AllocationRecycle);
+			new(RecycleStorage) AllocationRecycle{Tracking.NumBytes, Tracking.AlignBytes, TrackingIndex};
+		}
+
 	public:
 		static constexpr size_t BlockSizeLog2 = 24ull;
 		static constexpr size_t NumBlocksLog2 = 8ull;
@@ -151,7 +310,8 @@ namespace json2wav
 
 		static AllocationTransaction Allocate(uint32_t NumBytes, uint32_t AlignBytes)
 		{
-			AllocationTransaction Allocation(GetAllocationMutex());
+			ThreadHeap& Heap = HeapRegistry::Get();
+			AllocationTransaction Allocation(HeapRegistry::Pin(Heap, GetAllocationMutex()));
 
 			LOG_MEMORY(Allocation, "Allocating ", NumBytes, " bytes with ", AlignBytes, " byte alignment");
 
@@ -177,7 +337,11 @@ namespace json2wav
 			}
 
 			size_t StartByte = InvalidSize();
-			const uint32_t TrackingIndex = ReuseAllocation(NumBytes, AlignBytes);
+			uint32_t TrackingIndex = TakeLocalFree(Heap, NumBytes, AlignBytes);
+			if (TrackingIndex == InvalidUint32() && GetRecycleCount().load() > 0)
+			{
+				TrackingIndex = ReuseAllocation(NumBytes, AlignBytes);
+			}
 			if (TrackingIndex < GetTrackingCount().load())
 			{
 				if (std::byte* TrackingBlock = GetTrackingBlock())
@@ -189,7 +353,7 @@ namespace json2wav
 			}
 			if (StartByte == InvalidSize())
 			{
-				StartByte = ReserveBytes(NumBytes, AlignBytes);
+				StartByte = BumpBytes(Heap, NumBytes, AlignBytes);
 			}
 
 			const size_t BlockIndex = StartByte >> BlockSizeLog2;
@@ -277,21 +441,35 @@ namespace json2wav
 				return IndexSerial();
 			}
 
+			ThreadHeap& Heap = HeapRegistry::Get();
 			ArenaBumpAllocatorTracking* Tracking = nullptr;
 			uint32_t TrackingIndex = Allocation.TrackingIndex;
 			if (TrackingIndex == InvalidUint32())
 			{
-				TrackingIndex = GetTrackingCount().fetch_add(1);
-				LOG_MEMORY(Tracking, "Tracking list size is ", TrackingIndex + 1);
-				if (TrackingIndex >= MaxObjects)
+				if (Heap.TrackingNext == Heap.TrackingEnd)
 				{
-					MemoryError("ArenaBumpAllocator::TrackAllocation is tracking too many objects");
-					return IndexSerial();
+					// Claim a run of tracking entries at once; unused ones stay default constructed, so they never match a serial
+					Heap.TrackingNext = GetTrackingCount().fetch_add(TrackingBatch);
+					Heap.TrackingEnd = Heap.TrackingNext + TrackingBatch;
+					LOG_MEMORY(Tracking, "Tracking list size is ", Heap.TrackingEnd);
+					if (Heap.TrackingEnd > MaxObjects)
+					{
+						Heap.TrackingNext = Heap.TrackingEnd;
+						MemoryError("ArenaBumpAllocator::TrackAllocation is tracking too many objects");
+						return IndexSerial();
+					}
+					for (uint32_t BatchIndex = Heap.TrackingNext; BatchIndex < Heap.TrackingEnd; ++BatchIndex)
+					{
+						new(TrackingBlock + BatchIndex * sizeof(ArenaBumpAllocatorTracking)) ArenaBumpAllocatorTracking();
+					}
 				}
+				TrackingIndex = Heap.TrackingNext++;
 
 				LOG_MEMORY(Allocation, "Adding tracking at index ", TrackingIndex);
-				std::byte* TrackingStorage = TrackingBlock + TrackingIndex * sizeof(ArenaBumpAllocatorTracking);
-				Tracking = new(TrackingStorage) ArenaBumpAllocatorTracking(Allocation.StartByte, Allocation.NumBytes, Allocation.AlignBytes);
+				Tracking = reinterpret_cast<ArenaBumpAllocatorTracking*>(TrackingBlock + TrackingIndex * sizeof(ArenaBumpAllocatorTracking));
+				Tracking->StartByte = Allocation.StartByte;
+				Tracking->NumBytes = Allocation.NumBytes;
+				Tracking->AlignBytes = Allocation.AlignBytes;
 			}
 			else
 			{
@@ -300,12 +478,16 @@ namespace json2wav
 				Tracking = reinterpret_cast<ArenaBumpAllocatorTracking*>(TrackingStorage);
 			}
 
-			Tracking->Serial = NextSerial();
+			Tracking->Serial = Heap.TakeSerial(GetNextSerial());
+			Tracking->OwnerHeap = Heap.HeapIndex;
 			return {TrackingIndex, Tracking->Serial};
 		}
 
 		static void RecycleAllocation(uint32_t TrackingIndex, uint32_t ObjectSerial)
 		{
+			ThreadHeap& Heap = HeapRegistry::Get();
+			const ThreadHeapPin Pin = HeapRegistry::Pin(Heap, GetAllocationMutex());
+
 			LOG_MEMORY(Allocation, "Recycling allocation with tracking index ", TrackingIndex);
 
 			ArenaBumpAllocatorTracking* TrackingList = reinterpret_cast<ArenaBumpAllocatorTracking*>(GetTrackingBlock());
@@ -331,33 +513,26 @@ namespace json2wav
 
 			LOG_MEMORY(Allocation, "Recycling ", Tracking.AlignBytes, " byte aligned ", Tracking.NumBytes, " byte allocation with tracking index ", TrackingIndex);
 
-			std::unique_lock<std::mutex> Lock(GetRecycleMutex());
+			// Stale references fail the serial check from here on
+			Tracking.Serial = InvalidUint32();
 
-			std::byte* RecycleBlock = GetRecycleBlock();
-			if (!RecycleBlock)
+			if (Tracking.OwnerHeap == Heap.HeapIndex)
 			{
-				LOG_MEMORY(Allocation, "Allocating ", RecycleBlockSize, " bytes with ", RecycleBlockSize, " byte alignment for recycle block");
-				RecycleBlock = reinterpret_cast<std::byte*>(std::aligned_alloc(RecycleBlockSize, RecycleBlockSize));
-				if (!RecycleBlock)
+				if (PushLocalFree(Heap, TrackingIndex))
 				{
-					MemoryError("ArenaBumpAllocator::RecycleAllocation could not allocate the recycle block");
 					return;
 				}
-
-				GetRecycleBlock() = RecycleBlock;
 			}
-
-			const uint32_t RecycleIndex = GetRecycleCount().fetch_add(1);
-			if (RecycleIndex >= MaxObjects)
+			else if (ThreadHeap* OwnerHeap = HeapRegistry::At(Tracking.OwnerHeap))
 			{
-				GetRecycleCount().fetch_sub(1);
-				MemoryError("ArenaBumpAllocator::RecycleAllocation is recycling too many objects");
+				OwnerHeap->PushRemote(TrackingIndex, [](uint32_t Index, uint32_t Next)
+				{
+					GetTracking(Index).NextFree = Next;
+				});
 				return;
 			}
 
-			LOG_MEMORY(Tracking, "Recycle stack size is ", RecycleIndex + 1);
-			std::byte* RecycleStorage = RecycleBlock + RecycleIndex * sizeof(AllocationRecycle);
-			new(RecycleStorage) AllocationRecycle{Tracking.NumBytes, Tracking.AlignBytes, TrackingIndex};
+			RecycleShared(TrackingIndex);
 		}
 
 		static uint32_t IncrementNumReferences(uint32_t TrackingIndex, uint32_t ObjectSerial)
@@ -427,6 +602,15 @@ namespace json2wav
 			std::unique_lock<std::mutex> BlocksLock(GetBlocksMutex());
 			std::unique_lock<std::mutex> RecycleLock(GetRecycleMutex());
 
+			HeapRegistry::TearDown([](ThreadHeap& Heap)
+			{
+				Heap.SpanNext = 0;
+				Heap.SpanEnd = 0;
+				Heap.TrackingNext = 0;
+				Heap.TrackingEnd = 0;
+				Heap.NumSizeClasses = 0;
+			});
+
 			// Destroy recycle stack in reverse order
 			if (AllocationRecycle* RecycleStack = reinterpret_cast<AllocationRecycle*>(GetRecycleBlock()))
 			{
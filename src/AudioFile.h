@@ -4,77 +4,55 @@
 
 #include "IAudioObject.h"
 #include "Sample.h"
+#include "SampleKernels.h"
 #include "Memory.h"
 #include "WavFile.h"
+#include "BlockScratch.h"
+#include "AllocGuard.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include "RenderArena.h"
+#include "RenderStats.h"
+#include "RenderRange.h"
+#include "SegmentRender.h"
+#include "Random.h"
+
+#ifdef ALBUMBOT_DEBUGNEW
+#include "DebugNew.h"
+#endif
+
 #include <string>
 #include <fstream>
 #include <iostream>
 #include <utility>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
 #include <chrono>
 #include <cstdint>
 #include <cmath>
 
 namespace json2wav
 {
-	typedef void (*SerializeSampleFunc)(Vector<riff::Byte>&, const Sample&);
-
-	void SerializeSample16(Vector<riff::Byte>& bytes, const Sample& sample)
-	{
-		const int16_t sample16 = sample.AsInt16();
-		bytes.push_back(sample16 & 0xff);
-		bytes.push_back((sample16 >> 8) & 0xff);
-	}
-
-	void SerializeSample24(Vector<riff::Byte>& bytes, const Sample& sample)
-	{
-		const int32_t sample24 = sample.AsInt24();
-		bytes.push_back(sample24 & 0xff);
-		bytes.push_back((sample24 >> 8) & 0xff);
-		bytes.push_back((sample24 >> 16) & 0xff);
-	}
-
-	void SerializeSample32(Vector<riff::Byte>& bytes, const Sample& sample)
-	{
-		const float sample32Float = sample.AsFloat32();
-		const char* const sampleFloatBytes = reinterpret_cast<const char*>(&sample32Float);
-		const uint32_t sample32 = [sampleFloatBytes]()
-		{
-			uint32_t sample32;
-			char* sampleBytes = reinterpret_cast<char*>(&sample32);
-			for (size_t i = 0; i < 4; ++i)
-			{
-				sampleBytes[i] = sampleFloatBytes[i];
-			}
-			return sample32;
-		}();
-		bytes.push_back(sample32 & 0xff);
-		bytes.push_back((sample32 >> 8) & 0xff);
-		bytes.push_back((sample32 >> 16) & 0xff);
-		bytes.push_back((sample32 >> 24) & 0xff);
-	}
-
 	Vector<riff::Byte> GetBytes(
 		Sample* const* const bufs,
 		const size_t numChannels,
 		const size_t numSamples,
 		ESampleType sampleType)
 	{
-		Vector<riff::Byte> bytes;
-		bytes.reserve(numSamples * numChannels * GetSampleSize(sampleType));
-
-		SerializeSampleFunc serialize;
-		switch (sampleType)
-		{
-		case ESampleType::Int16: serialize = &SerializeSample16; break;
-		case ESampleType::Int24: serialize = &SerializeSample24; break;
-		case ESampleType::Float32: serialize = &SerializeSample32; break;
-		}
+		const size_t sampleSize = GetSampleSize(sampleType);
+		const size_t frameSize = numChannels * sampleSize;
+		Vector<riff::Byte> bytes(numSamples * frameSize);
 
-		for (size_t smpnum = 0; smpnum < numSamples; ++smpnum)
+		for (size_t ch = 0; ch < numChannels; ++ch)
 		{
-			for (size_t ch = 0; ch < numChannels; ++ch)
+			const std::span<const float> chspan(AsSpan(bufs[ch], numSamples));
+			riff::Byte* const chbytes = bytes.data() + ch * sampleSize;
+			switch (sampleType)
 			{
-				serialize(bytes, bufs[ch][smpnum]);
+			case ESampleType::Int16: kernel::Convert<ESampleType::Int16>(chspan, chbytes, frameSize); break;
+			case ESampleType::Int24: kernel::Convert<ESampleType::Int24>(chspan, chbytes, frameSize); break;
+			case ESampleType::Float32: kernel::Convert<ESampleType::Float32>(chspan, chbytes, frameSize); break;
 			}
 		}
 
@@ -88,32 +66,244 @@ namespace json2wav
 		void Write(const std::string& filename, const size_t numSamples, const unsigned long sampleRate = 44100,
 			const ESampleType sampleType = ESampleType::Int16, const size_t numChannels = 2)
 		{
-			std::cout << "Rendering audio for " << filename << "...\n";
-			SampleBuf buf(numChannels, numSamples);
+			if (segments)
+			{
+				WriteSegment(filename, numSamples, sampleRate, sampleType, numChannels);
+				return;
+			}
+
+			const bool bBench = renderStats != nullptr;
+			if (!bBench)
+				std::cout << "Rendering audio for " << filename << "...\n";
+
+			size_t startSample = 0;
+			size_t endSample = numSamples;
+			if (renderRange)
+			{
+				const double sr = static_cast<double>(sampleRate);
+				startSample = std::min(numSamples, static_cast<size_t>(std::max(0.0, renderRange->fromSeconds) * sr + 0.5));
+				if (renderRange->toSeconds)
+					endSample = std::clamp(static_cast<size_t>(std::max(0.0, *renderRange->toSeconds) * sr + 0.5), startSample, numSamples);
+			}
+			const size_t numOutSamples = endSample - startSample;
+
+			SampleBuf buf(numChannels, numOutSamples);
+			const auto renderstart = std::chrono::steady_clock::now();
+			const size_t numBlocks = Render(buf.get(), numChannels, startSample, endSample,
+				GetSkipSamples(startSample, sampleRate), sampleRate, !bBench, true);
+			const auto renderstop = std::chrono::steady_clock::now();
+			if (!allocguard::Disarm())
+				throw std::runtime_error("Rendering " + filename + " allocated after its first block");
+			Save(filename, buf.get(), numChannels, numOutSamples, sampleRate, sampleType, numBlocks, renderstop - renderstart);
+		}
+
+		/** Makes Write measure the render into stats instead of writing a file */
+		void SetRenderStats(RenderStats* const stats) noexcept
+		{
+			renderStats = stats;
+		}
+
+		/** Makes Write render only the given window of the song */
+		void SetRenderRange(const RenderRange* const range) noexcept
+		{
+			renderRange = range;
+		}
+
+		/** Makes Write render one segment of the song as part of a segmented render; see SegmentRender */
+		void SetSegmentRender(SegmentRender* const segmentRender) noexcept
+		{
+			segments = segmentRender;
+		}
+
+		bool AddInput(SharedPtr<IAudioObject> inputNode)
+		{
+			return inputs.AddInput(std::move(inputNode));
+		}
+
+		bool RemoveInput(SharedPtr<IAudioObject> inputNode)
+		{
+			return inputs.RemoveInput(std::move(inputNode));
+		}
+
+	private:
+		/** Where a render starting at startSample starts fast-forwarding; block-aligned so later blocks match a full render's */
+		size_t GetSkipSamples(const size_t startSample, const unsigned long sampleRate) const noexcept
+		{
+			const double sr = static_cast<double>(sampleRate);
+			const size_t minWarmupSamples = static_cast<size_t>(RenderRange::MinWarmupSeconds * sr);
+			size_t warmupSamples = std::max(inputs.GetTailSamples(sampleRate), minWarmupSamples);
+			if (renderRange && renderRange->warmupSeconds)
+				warmupSamples = static_cast<size_t>(std::max(0.0, *renderRange->warmupSeconds) * sr);
+			if (const size_t latency = inputs.GetSampleDelay(); warmupSamples < SIZE_MAX - latency)
+				warmupSamples += latency;
+			else
+				return 0;
+			return (startSample > warmupSamples) ? ((startSample - warmupSamples) / sampleChunkNum) * sampleChunkNum : 0;
+		}
+
+		/**
+		 * Renders samples [startSample, endSample) of the song into bufs, fast-forwarding through the first skipSamples
+		 * and rendering the rest before startSample into scratch. Returns the number of blocks rendered.
+		 */
+		size_t Render(Sample* const* const bufs, const size_t numChannels, const size_t startSample, const size_t endSample,
+			const size_t skipSamples, const unsigned long sampleRate, const bool bProgress, const bool bGuard)
+		{
+			SampleBuf warmupBuf((startSample > 0) ? numChannels : 0, sampleChunkNum);
 			Vector<Sample*> choffsets(numChannels, nullptr);
-			const float nsf = static_cast<float>(numSamples);
+			const float nsf = static_cast<float>(endSample);
 			float pertwentdone = -1.0f;
-			auto renderstart = std::chrono::steady_clock::now();
-			for (size_t offset = 0, samplesLeft = numSamples, readSamples = 0; samplesLeft > 0;)
+			const allocguard::NodeScope guardNode(*this);
+			size_t numBlocks = 0;
+			for (size_t offset = 0, readSamples = 0; offset < endSample;)
 			{
+				const BlockScratch::Scope scratchScope;
 				const float nextpertwentdone = std::floorf(25.0f * (static_cast<float>(offset) / nsf));
-				if (nextpertwentdone > pertwentdone)
+				if (nextpertwentdone > pertwentdone && bProgress)
 				{
 					pertwentdone = nextpertwentdone;
 					std::cout << (pertwentdone * 4.0f) << "%\n";
 				}
+				readSamples = std::min(endSample - offset, sampleChunkNum);
 				for (size_t ch = 0; ch < numChannels; ++ch)
-					choffsets[ch] = buf.get()[ch] + offset;
-				readSamples = (samplesLeft < sampleChunkNum) ? samplesLeft : sampleChunkNum;
-				inputs.GetSamples(choffsets.data(), numChannels, readSamples, sampleRate, nullptr);
-				samplesLeft -= readSamples;
+					choffsets[ch] = (offset >= startSample) ? bufs[ch] + (offset - startSample) : warmupBuf.get()[ch];
+				{
+					const trace::Span traceBlock("block", static_cast<int64_t>(offset));
+					const profile::Scope profileNode(inputs, nullptr, readSamples);
+					const trace::NodeSpan traceNode(inputs, readSamples);
+					const FastForward::Scope fastForward(offset < skipSamples);
+					inputs.GetSamples(choffsets.data(), numChannels, readSamples, sampleRate, nullptr);
+				}
+				if (offset < startSample && offset + readSamples > startSample)
+					for (size_t ch = 0; ch < numChannels; ++ch)
+						kernel::Copy(AsSpan(bufs[ch], offset + readSamples - startSample),
+							AsSpan(warmupBuf.get()[ch] + (startSample - offset), offset + readSamples - startSample));
+#ifdef ALBUMBOT_TRACE
+				{
+					size_t poolLiveBytes = 0;
+					size_t poolCommittedBytes = 0;
+					SampleBuf::GetPoolBytes(poolLiveBytes, poolCommittedBytes);
+					trace::Counter("sample pool live bytes", static_cast<int64_t>(poolLiveBytes));
+					trace::Counter("sample pool committed bytes", static_cast<int64_t>(poolCommittedBytes));
+					if (const RenderArena* const arena = RenderArena::Current())
+						trace::Counter("render arena bytes", static_cast<int64_t>(arena->GetNumBytes()));
+				}
+#endif
 				offset += readSamples;
+				++numBlocks;
+
+				// The first block rendered in full is allowed to size buffers; nothing after it should touch the heap
+				if (bGuard && offset == skipSamples + readSamples)
+					allocguard::Arm();
+			}
+			return numBlocks;
+		}
+
+		/**
+		 * Every copy of the graph but the last adds its segment's render and builds the next copy. The last renders
+		 * them all, each fast-forwarding up to its own warm-up, and writes the song.
+		 */
+		void WriteSegment(const std::string& filename, const size_t numSamples, const unsigned long sampleRate,
+			const ESampleType sampleType, const size_t numChannels)
+		{
+			const size_t copy = segments->GetCurrentCopy();
+			const size_t numSegments = segments->GetNumSegments();
+			const size_t numSongBlocks = (numSamples + sampleChunkNum - 1) / sampleChunkNum;
+			const size_t startSample = (copy < numSegments) ? (numSongBlocks * copy / numSegments) * sampleChunkNum : 0;
+			const size_t endSample = (copy < numSegments) ? std::min(numSamples, (numSongBlocks * (copy + 1) / numSegments) * sampleChunkNum) : numSamples;
+			const size_t skipSamples = (copy < numSegments) ? GetSkipSamples(startSample, sampleRate) : 0;
+			// Each copy renders on its own thread, so it takes the arena its graph was built in along
+			SegmentRender::RenderFunc render = [this, numChannels, startSample, endSample, skipSamples, sampleRate,
+				arena = RenderArena::Current()](Sample* const* const bufs)
+				{
+					const RenderArena::Use arenaScope(arena);
+					Vector<Sample*> segmentBufs(numChannels, nullptr);
+					for (size_t ch = 0; ch < numChannels; ++ch)
+						segmentBufs[ch] = bufs[ch] + startSample;
+					Render(segmentBufs.data(), numChannels, startSample, endSample, skipSamples, sampleRate, false, false);
+				};
+
+			if (copy + 1 < segments->GetNumCopies())
+			{
+				if (!segments->AddAndBuildNext(std::move(render)))
+					throw std::runtime_error("Couldn't build segment " + std::to_string(copy + 1) + " of " + filename);
+				return;
+			}
+
+			const bool bBench = renderStats != nullptr;
+			if (!bBench)
+				std::cout << "Rendering audio for " << filename << " in " << numSegments << " segments...\n";
+			SampleBuf buf(numChannels, numSamples);
+			const auto renderstart = std::chrono::steady_clock::now();
+			segments->RenderAll(std::move(render), buf.get());
+			const auto renderstop = std::chrono::steady_clock::now();
+			if (segments->GetNumCopies() > numSegments)
+			{
+				SampleBuf serialBuf(numChannels, numSamples);
+				segments->RenderSerial(serialBuf.get());
+				const auto serialstop = std::chrono::steady_clock::now();
+				const double segmentSeconds = std::chrono::duration<double>(renderstop - renderstart).count();
+				const double serialSeconds = std::chrono::duration<double>(serialstop - renderstop).count();
+				std::cout << "Serial render took " << serialSeconds << " seconds; the segmented render was "
+					<< ((segmentSeconds > 0.0) ? serialSeconds / segmentSeconds : 0.0) << "x as fast\n";
+				segments->SetSeamError(ReportSeams(buf.get(), serialBuf.get(), numChannels, numSamples, sampleRate, numSegments));
+			}
+			Save(filename, buf.get(), numChannels, numSamples, sampleRate, sampleType, numSongBlocks, renderstop - renderstart);
+		}
+
+		/** Prints how far a segmented render strays from a serial one, overall and around each seam; returns the overall */
+		static float ReportSeams(Sample* const* const bufs, Sample* const* const serialBufs, const size_t numChannels,
+			const size_t numSamples, const unsigned long sampleRate, const size_t numSegments)
+		{
+			auto ToDB = [](const float err) { return (err > 0.0f) ? 20.0 * std::log10(static_cast<double>(err)) : -std::numeric_limits<double>::infinity(); };
+			auto MaxError = [bufs, serialBufs, numChannels](const size_t start, const size_t end)
+				{
+					float maxErr = 0.0f;
+					for (size_t ch = 0; ch < numChannels; ++ch)
+						for (size_t i = start; i < end; ++i)
+							maxErr = std::max(maxErr, std::abs(bufs[ch][i].AsFloat32() - serialBufs[ch][i].AsFloat32()));
+					return maxErr;
+				};
+
+			const size_t numSongBlocks = (numSamples + sampleChunkNum - 1) / sampleChunkNum;
+			const size_t seamRadius = sampleChunkNum;
+			const float maxErr = MaxError(0, numSamples);
+			std::cout << "Max error against a serial render: " << ToDB(maxErr) << " dBFS (at most "
+				<< ToDB(SegmentRender::MaxSeamError) << " dBFS passes)\n";
+			for (size_t segment = 1; segment < numSegments; ++segment)
+			{
+				const size_t seam = std::min(numSamples, (numSongBlocks * segment / numSegments) * sampleChunkNum);
+				const float seamErr = MaxError((seam > seamRadius) ? seam - seamRadius : 0, std::min(numSamples, seam + seamRadius));
+				std::cout << "  Seam at " << (static_cast<double>(seam) / static_cast<double>(sampleRate)) << " s: "
+					<< ToDB(seamErr) << " dBFS\n";
+			}
+			return maxErr;
+		}
+
+		/** Fills renderStats, or writes the rendered song to filename */
+		void Save(const std::string& filename, Sample* const* const bufs, const size_t numChannels, const size_t numSamples,
+			const unsigned long sampleRate, const ESampleType sampleType, const size_t numBlocks,
+			const std::chrono::steady_clock::duration renderTime)
+		{
+			if (renderStats)
+			{
+				renderStats->numSamples = numSamples;
+				renderStats->sampleRate = sampleRate;
+				renderStats->numBlocks = numBlocks;
+				renderStats->renderSeconds = std::chrono::duration<double>(renderTime).count();
+				if (const RenderArena* const arena = RenderArena::Current())
+				{
+					renderStats->arenaAllocations = arena->GetNumAllocations();
+					renderStats->arenaBytes = arena->GetNumBytes();
+				}
+				profile::Report(filename.substr(0, filename.find_last_of('.')));
+				trace::Flush(filename.substr(0, filename.find_last_of('.')));
+				return;
 			}
-			auto renderstop = std::chrono::steady_clock::now();
 			std::cout << "100.0%\n";
-			std::cout << "Render took " << (0.001*static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(renderstop - renderstart).count())) << " seconds\n";
+			std::cout << "Render took " << (0.001*static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(renderTime).count())) << " seconds\n";
 			Vector<riff::DataPtr> bytesVec;
-			bytesVec.emplace_back(riff::MakePtr<riff::BytesPtr>(GetBytes(buf.get(), numChannels, numSamples, sampleType)));
+			DitherEngine().seed(RandomSeed().Seq());
+			bytesVec.emplace_back(riff::MakePtr<riff::BytesPtr>(GetBytes(bufs, numChannels, numSamples, sampleType)));
 			std::cout << "Writing " << filename << "...\n";
 			switch (sampleType)
 			{
@@ -145,24 +335,19 @@ namespace json2wav
 			default: break;
 			}
 			std::cout << "Done writing " << filename << ".\n";
+			profile::Report(filename.substr(0, filename.find_last_of('.')));
+			trace::Flush(filename.substr(0, filename.find_last_of('.')));
 
 #ifdef ALBUMBOT_DEBUGNEW
 			json2wav::PrintAllocTimes("just after writing wav to disk");
 #endif
 		}
 
-		bool AddInput(SharedPtr<IAudioObject> inputNode)
-		{
-			return inputs.AddInput(std::move(inputNode));
-		}
-
-		bool RemoveInput(SharedPtr<IAudioObject> inputNode)
-		{
-			return inputs.RemoveInput(std::move(inputNode));
-		}
-
 	private:
 		BasicAudioSum<bOwner> inputs;
+		RenderStats* renderStats = nullptr;
+		const RenderRange* renderRange = nullptr;
+		SegmentRender* segments = nullptr;
 	};
 
 	class AudioFileIn : public IAudioObject
@@ -0,0 +1,77 @@
+// Copyright Dan Price 2026.
+
+#pragma once
+
+#include "Macros.h"
+#include "AllocGuard.h"
+#include <memory_resource>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <cstddef>
+
+#ifndef ALBUMBOT_BLOCK_SCRATCH_BYTES
+#define ALBUMBOT_BLOCK_SCRATCH_BYTES (256 * 1024)
+#endif
+
+namespace json2wav
+{
+	/**
+	 * Per-thread monotonic memory for containers that only live while one block renders. A thread's buffer is allocated
+	 * the first time it asks for scratch inside a Scope, not as part of its thread-local storage, so the threads inputs
+	 * are launched on don't each zero and fault in the whole buffer when they start. After that the thread gets its
+	 * scratch without touching the heap; the outermost Scope on a thread releases it.
+	 * Outside a Scope, Get() returns the default resource, so the same code is safe to call while a song is being built.
+	 */
+	class BlockScratch
+	{
+	private:
+		struct ThreadScratch
+		{
+			std::unique_ptr<std::byte[]> buffer;
+			std::optional<std::pmr::monotonic_buffer_resource> resource;
+			size_t depth = 0;
+		};
+
+		DEFINE_THREADLOCAL_PROPERTY(ThreadScratch, ThreadScratch);
+
+	public:
+		class Scope
+		{
+		public:
+			Scope() noexcept
+			{
+				++GetThreadScratch().depth;
+			}
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+			~Scope() noexcept
+			{
+				ThreadScratch& scratch = GetThreadScratch();
+				if (--scratch.depth == 0 && scratch.resource)
+					scratch.resource->release();
+			}
+		};
+
+		static std::pmr::memory_resource* Get() noexcept
+		{
+			ThreadScratch& scratch = GetThreadScratch();
+			if (scratch.depth == 0)
+				return std::pmr::get_default_resource();
+			if (!scratch.resource)
+			{
+				// Like starting the thread, setting up its scratch allocates once
+				const allocguard::Exempt firstUse;
+				scratch.buffer = std::make_unique_for_overwrite<std::byte[]>(ALBUMBOT_BLOCK_SCRATCH_BYTES);
+				scratch.resource.emplace(scratch.buffer.get(), ALBUMBOT_BLOCK_SCRATCH_BYTES, std::pmr::new_delete_resource());
+			}
+			return &*scratch.resource;
+		}
+	};
+
+	/** A vector for one block's transient data; never keep one past the end of the block */
+	template<typename T>
+	using ScratchVector = std::pmr::vector<T>;
+}
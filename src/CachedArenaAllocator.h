@@ -4,6 +4,7 @@
 
 #include "MemoryCommon.h"
 #include "Macros.h"
+#include "ThreadHeap.h"
 #include <mutex>
 #include <cstdint>
 #include <cstddef>
@@ -293,20 +294,20 @@ namespace json2wav
 		return RecycleStackTopAtomic.compare_exchange_weak(RecycleStackTopWithState, IndexWithState);
 	}
 
-	inline ArenaAllocation AllocateStorage(ArenaHeader& Arena)
+	inline bool PopAnyRecycleStack(ArenaHeader& Arena, ArenaAllocation& Allocation)
 	{
-		ArenaAllocation Allocation;
-
-		if (PopRecycleStack(Arena, Arena.RecycleStack0Top, Allocation) ||
+		return PopRecycleStack(Arena, Arena.RecycleStack0Top, Allocation) ||
 			PopRecycleStack(Arena, Arena.RecycleStack1Top, Allocation) ||
 			PopRecycleStack(Arena, Arena.RecycleStack2Top, Allocation) ||
-			PopRecycleStack(Arena, Arena.RecycleStack3Top, Allocation))
-		{
-			return Allocation;
-		}
+			PopRecycleStack(Arena, Arena.RecycleStack3Top, Allocation);
+	}
 
-		const uint32_t NextIndex = Arena.NextIndex.fetch_add(1);
-		ArenaLocation Location = GetArenaLocation(Arena, NextIndex);
+	/** Storage for an index handed out by NextIndex, allocating its block if nobody has yet */
+	inline ArenaAllocation ClaimStorage(ArenaHeader& Arena, uint32_t Index)
+	{
+		ArenaAllocation Allocation;
+
+		ArenaLocation Location = GetArenaLocation(Arena, Index);
 		const uint64_t BlockSize = GetBlockSize(Arena) + (Location.Block == 0) * GetArenaStartOffset(Arena);
 		if (Location.Block >= ArenaHeader::MaxBlocks)
 		{
@@ -353,10 +354,20 @@ namespace json2wav
 		}
 
 		Allocation.Storage = Block + Location.Byte;
-		Allocation.Index = NextIndex;
+		Allocation.Index = Index;
 		return Allocation;
 	}
 
+	inline ArenaAllocation AllocateStorage(ArenaHeader& Arena)
+	{
+		ArenaAllocation Allocation;
+		if (PopAnyRecycleStack(Arena, Allocation))
+		{
+			return Allocation;
+		}
+		return ClaimStorage(Arena, Arena.NextIndex.fetch_add(1));
+	}
+
 	inline void RecycleStorage(ArenaHeader& Arena, uint32_t Index)
 	{
 		if (std::byte* AllocationStorage = GetArenaAllocationStorage(Arena, Index))
@@ -374,21 +385,132 @@ namespace json2wav
 		}
 	}
 
+	/** One thread's share of an arena: storage it freed itself, plus a run of indices claimed from NextIndex in one step */
+	struct ArenaThreadCache
+	{
+		uint32_t FreeTop;
+		uint32_t NumFree;
+		uint32_t ReservedNext;
+		uint32_t ReservedEnd;
+	};
+
+	inline constexpr uint32_t GetThreadRefillCount(uint64_t NumBytes)
+	{
+		// About 16KB per refill, but always at least one and never more than 64 allocations
+		const uint64_t RefillCount = 16384ull / NumBytes;
+		return RefillCount < 1ull ? 1u : RefillCount > 64ull ? 64u : static_cast<uint32_t>(RefillCount);
+	}
+
+	inline constexpr uint32_t GetThreadFreeMax(uint64_t NumBytes)
+	{
+		return GetThreadRefillCount(NumBytes) << 4;
+	}
+
+	inline void PushThreadCache(ArenaHeader& Arena, ArenaThreadCache& Cache, uint32_t Index)
+	{
+		if (Cache.NumFree >= GetThreadFreeMax(Arena.NumBytes))
+		{
+			// Past the cap, hand storage back to the shared recycle stacks where other threads can refill from it
+			RecycleStorage(Arena, Index);
+		}
+		else if (std::byte* AllocationStorage = GetArenaAllocationStorage(Arena, Index))
+		{
+			WriteUint32(AllocationStorage, Cache.FreeTop);
+			Cache.FreeTop = Index;
+			++Cache.NumFree;
+		}
+	}
+
+	inline bool PopThreadCache(ArenaHeader& Arena, ArenaThreadCache& Cache, ArenaAllocation& Allocation)
+	{
+		if (Cache.NumFree > 0)
+		{
+			Allocation.Storage = GetArenaAllocationStorage(Arena, Cache.FreeTop);
+			Allocation.Index = Cache.FreeTop;
+			Cache.FreeTop = ReadUint32(Allocation.Storage);
+			--Cache.NumFree;
+			return true;
+		}
+
+		if (Cache.ReservedNext != Cache.ReservedEnd)
+		{
+			Allocation = ClaimStorage(Arena, Cache.ReservedNext++);
+			return true;
+		}
+
+		return false;
+	}
+
+	/** Refill from the shared arena: recycled storage first, then a fresh run of indices */
+	inline ArenaAllocation RefillThreadCache(ArenaHeader& Arena, ArenaThreadCache& Cache)
+	{
+		const uint32_t RefillCount = GetThreadRefillCount(Arena.NumBytes);
+
+		ArenaAllocation Allocation;
+		for (uint32_t NumRefilled = 0; NumRefilled < RefillCount && PopAnyRecycleStack(Arena, Allocation); ++NumRefilled)
+		{
+			WriteUint32(Allocation.Storage, Cache.FreeTop);
+			Cache.FreeTop = Allocation.Index;
+			++Cache.NumFree;
+		}
+
+		if (PopThreadCache(Arena, Cache, Allocation))
+		{
+			return Allocation;
+		}
+
+		Cache.ReservedNext = Arena.NextIndex.fetch_add(RefillCount);
+		Cache.ReservedEnd = Cache.ReservedNext + RefillCount;
+		return ClaimStorage(Arena, Cache.ReservedNext++);
+	}
+
 	struct CachedArenaAllocatorTracking
 	{
-		CachedArenaAllocatorTracking(uint32_t NumReferencesInit = 0, uint32_t SerialInit = InvalidUint32(), uint32_t ArenaIndexInit = InvalidUint32(), uint32_t AllocationIndexInit = InvalidUint32())
-			: NumReferences(NumReferencesInit), Serial(SerialInit), ArenaIndex(ArenaIndexInit), AllocationIndex(AllocationIndexInit)
+		CachedArenaAllocatorTracking(uint32_t NumReferencesInit = 0, uint32_t SerialInit = InvalidUint32(), uint32_t ArenaIndexInit = InvalidUint32(), uint32_t AllocationIndexInit = InvalidUint32(), uint32_t OwnerHeapInit = InvalidUint32())
+			: NumReferences(NumReferencesInit), Serial(SerialInit), ArenaIndex(ArenaIndexInit), AllocationIndex(AllocationIndexInit), OwnerHeap(OwnerHeapInit)
 		{
 		}
 		std::atomic<uint32_t> NumReferences;
 		uint32_t Serial;
 		uint32_t ArenaIndex;
 		uint32_t AllocationIndex;
+		uint32_t OwnerHeap;
 	};
 
+	/**
+	 * Each thread allocates from its own cache of every arena and frees straight back into it. Frees from another thread
+	 * go onto the owning thread's remote list; the shared arenas are only touched to refill a cache or take its excess.
+	 */
 	class CachedArenaAllocator
 	{
 	private:
+		static constexpr uint32_t MaxThreadHeaps = 1024;
+
+		struct ThreadHeap : public ThreadHeapBase
+		{
+			ThreadHeap()
+				: TrackingCache{}, ArenaCaches(static_cast<ArenaThreadCache*>(std::calloc(MaxArenas, sizeof(ArenaThreadCache))))
+			{
+				if (!ArenaCaches)
+				{
+					MemoryError("CachedArenaAllocator::ThreadHeap couldn't allocate its arena caches");
+				}
+			}
+
+			~ThreadHeap() noexcept
+			{
+				std::free(ArenaCaches);
+			}
+
+			ThreadHeap(const ThreadHeap&) = delete;
+			ThreadHeap& operator=(const ThreadHeap&) = delete;
+
+			ArenaThreadCache TrackingCache;
+			ArenaThreadCache* ArenaCaches;
+		};
+
+		using HeapRegistry = ThreadHeapRegistry<ThreadHeap, MaxThreadHeaps>;
+
 		DEFINE_STATIC_PROPERTY(std::shared_mutex, AllocationMutex);
 		DEFINE_STATIC_PROPERTY(std::mutex, ArenaHeadersMutex);
 		DEFINE_STATIC_PROPERTY(std::mutex, TrackingArenaMutex);
@@ -559,7 +681,7 @@ namespace json2wav
 			return GetThreadCache()[ThreadCacheIndex].ArenaIndex;
 		}
 
-		static uint32_t NewTrackingIndex(uint32_t ArenaIndex, uint32_t AllocationIndex, uint32_t Serial)
+		static ArenaHeader* InitTrackingArena()
 		{
 			ArenaHeader* TrackingArena = GetTrackingArena();
 			if (!TrackingArena)
@@ -577,22 +699,66 @@ namespace json2wav
 					std::byte* TrackingArenaStorage = static_cast<std::byte*>(std::aligned_alloc(Alignment, HeaderBlockSize + AlignmentPadding));
 					if (!TrackingArenaStorage)
 					{
-						MemoryError("CachedArenaAllocator::NewTrackingIndex couldn't allocate storage for the tracking arena");
-						return InvalidUint32();
+						MemoryError("CachedArenaAllocator::InitTrackingArena couldn't allocate storage for the tracking arena");
+						return nullptr;
 					}
 					TrackingArena = new(TrackingArenaStorage) ArenaHeader(SizeOfTracking, AlignOfTracking);
 					GetTrackingArena() = TrackingArena;
 				}
 			}
+			return TrackingArena;
+		}
+
+		/** Moves everything other threads freed on this heap's behalf into its own caches */
+		static void DrainRemoteFrees(ThreadHeap& Heap, ArenaHeader& TrackingArena)
+		{
+			uint32_t TrackingIndex = Heap.TakeRemote();
+			while (TrackingIndex != InvalidUint32())
+			{
+				std::byte* TrackingStorage = GetArenaAllocationStorage(TrackingArena, TrackingIndex);
+				const uint32_t NextTrackingIndex = ReadUint32(TrackingStorage);
+				CachedArenaAllocatorTracking* Tracking = reinterpret_cast<CachedArenaAllocatorTracking*>(TrackingStorage);
+				const uint32_t ArenaIndex = Tracking->ArenaIndex;
+				const uint32_t AllocationIndex = Tracking->AllocationIndex;
+				Tracking->~CachedArenaAllocatorTracking();
+
+				if (ArenaHeader* Arena = ArenaIndex < MaxArenas ? GetArenaHeaders()[ArenaIndex].load() : nullptr)
+				{
+					PushThreadCache(*Arena, Heap.ArenaCaches[ArenaIndex], AllocationIndex);
+				}
+				PushThreadCache(TrackingArena, Heap.TrackingCache, TrackingIndex);
+
+				TrackingIndex = NextTrackingIndex;
+			}
+		}
+
+		static ArenaAllocation TakeStorage(ThreadHeap& Heap, ArenaThreadCache& Cache, ArenaHeader& Arena, ArenaHeader& TrackingArena)
+		{
+			ArenaAllocation Allocation;
+			if (PopThreadCache(Arena, Cache, Allocation))
+			{
+				return Allocation;
+			}
+
+			DrainRemoteFrees(Heap, TrackingArena);
+			if (PopThreadCache(Arena, Cache, Allocation))
+			{
+				return Allocation;
+			}
 
-			ArenaAllocation TrackingAllocation = AllocateStorage(*TrackingArena);
+			return RefillThreadCache(Arena, Cache);
+		}
+
+		static uint32_t NewTrackingIndex(ThreadHeap& Heap, ArenaHeader& TrackingArena, uint32_t ArenaIndex, uint32_t AllocationIndex, uint32_t Serial)
+		{
+			ArenaAllocation TrackingAllocation = TakeStorage(Heap, Heap.TrackingCache, TrackingArena, TrackingArena);
 			if (!TrackingAllocation.Storage)
 			{
 				MemoryError("CachedArenaAllocator::NewTrackingIndex couldn't allocate tracking storage in the tracking arena");
 				return InvalidUint32();
 			}
 
-			new(TrackingAllocation.Storage) CachedArenaAllocatorTracking(0, Serial, ArenaIndex, AllocationIndex);
+			new(TrackingAllocation.Storage) CachedArenaAllocatorTracking(0, Serial, ArenaIndex, AllocationIndex, Heap.HeapIndex);
 			return TrackingAllocation.Index;
 		}
 
@@ -605,7 +771,8 @@ namespace json2wav
 
 		static AllocationTransaction Allocate(uint32_t NumBytes, uint32_t AlignBytes)
 		{
-			AllocationTransaction AllocationInfo(GetAllocationMutex());
+			ThreadHeap& Heap = HeapRegistry::Get();
+			AllocationTransaction AllocationInfo(HeapRegistry::Pin(Heap, GetAllocationMutex()));
 
 			const uint32_t AlignMask = AlignBytes - 1;
 			if (AlignBytes & AlignMask)
@@ -632,8 +799,14 @@ namespace json2wav
 				return AllocationInfo;
 			}
 
+			ArenaHeader* TrackingArena = InitTrackingArena();
+			if (!TrackingArena)
+			{
+				return AllocationInfo;
+			}
+
 			// Allocate storage
-			ArenaAllocation Allocation = AllocateStorage(*Arena);
+			ArenaAllocation Allocation = TakeStorage(Heap, Heap.ArenaCaches[ArenaIndex], *Arena, *TrackingArena);
 			if (!Allocation.Storage)
 			{
 				MemoryError("CachedArenaAllocator::Allocate couldn't allocate storage");
@@ -647,16 +820,19 @@ namespace json2wav
 			AllocationInfo.Storage = Allocation.Storage;
 
 			// Increment serial
-			AllocationInfo.ObjectSerial = GetNextSerial().fetch_add(1);
+			AllocationInfo.ObjectSerial = Heap.TakeSerial(GetNextSerial());
 
 			// Add tracking
-			AllocationInfo.TrackingIndex = NewTrackingIndex(ArenaIndex, Allocation.Index, AllocationInfo.ObjectSerial);
+			AllocationInfo.TrackingIndex = NewTrackingIndex(Heap, *TrackingArena, ArenaIndex, Allocation.Index, AllocationInfo.ObjectSerial);
 
 			return AllocationInfo;
 		}
 
 		static void RecycleAllocation(uint32_t TrackingIndex, uint32_t ObjectSerial)
 		{
+			ThreadHeap& Heap = HeapRegistry::Get();
+			const ThreadHeapPin Pin = HeapRegistry::Pin(Heap, GetAllocationMutex());
+
 			ArenaHeader* TrackingArena = GetTrackingArena();
 			if (!TrackingArena)
 			{
@@ -675,10 +851,30 @@ namespace json2wav
 					return;
 				}
 
-				const uint32_t AllocationIndex = Tracking->AllocationIndex;
-				Tracking->~CachedArenaAllocatorTracking();
-				RecycleStorage(*TrackingArena, TrackingIndex);
-				RecycleStorage(*Arena, AllocationIndex);
+				// Stale references fail the serial check from here on
+				Tracking->Serial = InvalidUint32();
+
+				if (Tracking->OwnerHeap == Heap.HeapIndex)
+				{
+					const uint32_t AllocationIndex = Tracking->AllocationIndex;
+					Tracking->~CachedArenaAllocatorTracking();
+					PushThreadCache(*Arena, Heap.ArenaCaches[ArenaIndex], AllocationIndex);
+					PushThreadCache(*TrackingArena, Heap.TrackingCache, TrackingIndex);
+				}
+				else if (ThreadHeap* OwnerHeap = HeapRegistry::At(Tracking->OwnerHeap))
+				{
+					OwnerHeap->PushRemote(TrackingIndex, [TrackingArena](uint32_t Index, uint32_t Next)
+					{
+						WriteUint32(GetArenaAllocationStorage(*TrackingArena, Index), Next);
+					});
+				}
+				else
+				{
+					const uint32_t AllocationIndex = Tracking->AllocationIndex;
+					Tracking->~CachedArenaAllocatorTracking();
+					RecycleStorage(*TrackingArena, TrackingIndex);
+					RecycleStorage(*Arena, AllocationIndex);
+				}
 			}
 		}
 
@@ -733,6 +929,12 @@ namespace json2wav
 			std::unique_lock<std::mutex> ArenaHeadersLock(GetArenaHeadersMutex());
 			std::unique_lock<std::mutex> TrackingArenaLock(GetTrackingArenaMutex());
 
+			HeapRegistry::TearDown([](ThreadHeap& Heap)
+			{
+				Heap.TrackingCache = ArenaThreadCache{};
+				std::memset(Heap.ArenaCaches, 0, MaxArenas * sizeof(ArenaThreadCache));
+			});
+
 			if (ArenaHeader* TrackingArena = GetTrackingArena())
 			{
 				TrackingArena->~ArenaHeader();
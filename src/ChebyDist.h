@@ -3,6 +3,7 @@
 #pragma once
 
 #include "IAudioObject.h"
+#include "IOversampled.h"
 #include "Memory.h"
 #include "Oversampler.h"
 #include "GaussBoost.h"
@@ -430,7 +431,7 @@ namespace json2wav
 	template<> struct ChebyDistSampleDelay<2> { static constexpr const size_t value = 128; };
 
 	template<typename sample_t, size_t order, size_t buf_n, EChebyDistWaveShaper eWaveShaper = EChebyDistWaveShaper::InverseSquare, bool bOwner = false>
-	class ChebyDist : public AudioSum<bOwner>
+	class ChebyDist : public AudioSum<bOwner>, public IOversampledX2
 	{
 		static_assert(std::is_floating_point_v<sample_t>, "ChebyDist sample_t must be a floating point type");
 		static_assert(2 <= order && order <= 6, "ChebyDist order must be between 2 and 6, inclusive");
@@ -459,6 +460,10 @@ namespace json2wav
 			if (osbufs.size() != numChannels)
 				osbufs.resize(numChannels);
 
+			// The shaper maps 0 to 0, so resampling filters with nothing in them stay that way
+			if (this->SkipAtRest(bufs, numChannels, numSamples))
+				return;
+
 			const size_t bufmod = numSamples & (buf_n - 1);
 			for (size_t ch = 0; ch < numChannels; ++ch)
 			{
@@ -501,6 +506,34 @@ namespace json2wav
 			return AudioSum<bOwner>::GetSampleDelay() + ChebyDistSampleDelay<order>::value;
 		}
 
+		/** Only order 2 oversamples by 2 */
+		virtual bool CanProcessOversampled() const noexcept override
+		{
+			return order == 2;
+		}
+
+		virtual void ProcessOversampled(
+			double* const* const bufsX2,
+			const size_t numChannels,
+			const size_t numSamples,
+			const unsigned long sampleRate) noexcept override
+		{
+			if constexpr (order == 2)
+			{
+				for (size_t ch = 0; ch < numChannels; ++ch)
+				{
+					double* const chbuf = bufsX2[ch];
+					for (size_t i = 0, end = numSamples << 1; i < end; ++i)
+						chbuf[i] = static_cast<double>(ChebyDistProc<order>::template Process<eWaveShaper, sample_t>(static_cast<sample_t>(chbuf[i])));
+				}
+			}
+		}
+
+		virtual size_t GetOversampledDelay() const noexcept override
+		{
+			return ChebyDistSampleDelay<order>::value - oversampling::delay441_x2;
+		}
+
 	private:
 		typedef ChebyDistBuf<sample_t, order, buf_n> osbuf_t;
 		Vector<osbuf_t> osbufs;
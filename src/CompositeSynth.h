@@ -259,10 +259,20 @@ namespace json2wav
 				switch (synths.size())
 				{
 				default: AddEffect<BasicAudioSum<bOwner>>(); break;
-				case 1: synths[0]->GetSamples(bufs, numChannels, bufSize, sampleRate, requester);
+				case 1:
+					{
+						const profile::InputsScope profileInputs;
+						const profile::Scope profileSynth(*synths[0], this, bufSize);
+						const trace::NodeSpan traceSynth(*synths[0], bufSize);
+						synths[0]->GetSamples(bufs, numChannels, bufSize, sampleRate, requester);
+					}
+					[[fallthrough]];
 				case 0: return;
 				}
 			}
+			const profile::InputsScope profileInputs;
+			const profile::Scope profileEffect(*effects.back(), this, bufSize);
+			const trace::NodeSpan traceEffect(*effects.back(), bufSize);
 			effects.back()->GetSamples(bufs, numChannels, bufSize, sampleRate, requester);
 		}
 
@@ -282,6 +292,17 @@ namespace json2wav
 			return maxnum;
 		}
 
+		virtual size_t GetTailSamples(const unsigned long sampleRate) const noexcept override
+		{
+			if (effects.size() > 0)
+				return effects.back()->GetTailSamples(sampleRate);
+			size_t maxtail(0);
+			for (const SharedPtr<IAudioObject>& synth : synths)
+				if (const size_t tail(synth->GetTailSamples(sampleRate)); tail > maxtail)
+					maxtail = tail;
+			return maxtail;
+		}
+
 		ControlSet& GetControls() noexcept { return ctrls; }
 		const ControlSet& GetControls() const noexcept { return ctrls; }
 
@@ -3,13 +3,19 @@
 #pragma once
 
 #include "IAudioObject.h"
+#include "IOversampled.h"
 #include "Math.h"
 #include "Sample.h"
 #include "Utility.h"
 #include "Memory.h"
 #include "Oversampler.h"
+#include <algorithm>
+#include <limits>
 #include <cmath>
 
+// The gain computer interpolates its curve from a table rebuilt when the settings change instead of evaluating it
+#define ALBUMBOT_COMPRESSOR_GAIN_TABLE 1
+
 namespace json2wav
 {
 	class ICompressorMeasurer
@@ -48,10 +54,14 @@ namespace json2wav
 		double knee_db;
 		float dryVolume_db;
 		bool df2;
+		size_t controlDecimation = 1; // Run the envelope at 1/N of the sample rate, ramping the gain between; 1 oversamples it
+
+		/** Longest decimation the output delay line can cover */
+		static constexpr const size_t MaxControlDecimation = 256;
 	};
 
 	template<bool bOwner = false>
-	class Compressor : public AudioSum<bOwner>
+	class Compressor : public AudioSum<bOwner>, public IOversampledX2
 	{
 	public:
 		using IMeasurer = ICompressorMeasurer;
@@ -77,45 +87,22 @@ namespace json2wav
 			if (numChannels < this->GetNumChannels() || this->GetNumChannels() == 0)
 				return;
 
-			if (!bInitialized)
-			{
-				if (stereoMode == ECompressorStereoMode::LR)
-				{
-					channels.resize(this->GetNumChannels());
-					sidechains.resize(channels.size());
-					for (size_t i = 0; i < channels.size(); ++i)
-					{
-						channels[i].SetParams(params);
-						sidechains[i].resize(bufSize);
-					}
-				}
-				else if (stereoMode == ECompressorStereoMode::M)
-				{
-					channels.resize(1);
-					sidechains.resize(1);
-					channels[0].SetParams(params);
-					sidechains[0].resize(bufSize);
-				}
-				else if (stereoMode == ECompressorStereoMode::MS)
-				{
-					channels.resize(this->GetNumChannels());
-					sidechains.resize(channels.size());
-					for (size_t i = 0; i < channels.size(); ++i)
-					{
-						channels[i].SetParams((i & 1) ? sideParams : params);
-						sidechains[i].resize(bufSize);
-					}
-				}
-				else
-				{
-					return;
-				}
-				bInitialized = true;
-			}
+			if (!Initialize(this->GetNumChannels(), bufSize))
+				return;
 
 			if (this->GetInputSamples(bufs, this->GetNumChannels(), bufSize, sampleRate) != AudioSum<bOwner>::EGetInputSamplesResult::SamplesWritten)
 				return;
 
+			if (this->SkipAtRest(bufs, this->GetNumChannels(), bufSize))
+			{
+				for (CompressorChannel& channel : channels)
+					channel.SkipSilence(bufSize);
+				if (channels.size() == 1)
+					for (size_t i = 1; i < numChannels; ++i)
+						kernel::Zero(AsSpan(bufs[i], bufSize));
+				return;
+			}
+
 			if (this->GetNumChannels() == 1 || stereoMode == ECompressorStereoMode::LR)
 			{
 				for (size_t ch = 0; ch < channels.size(); ++ch)
@@ -195,6 +182,39 @@ namespace json2wav
 			return AudioSum<bOwner>::GetSampleDelay() + 256;
 		}
 
+		/** The detector settles to within 16-bit resolution after about 11 time constants */
+		virtual size_t GetTailSamples(const unsigned long sampleRate) const noexcept override
+		{
+			double timeConstants = params.attackSamples + params.releaseSamples;
+			if (stereoMode == ECompressorStereoMode::MS)
+				timeConstants = std::max(timeConstants, sideParams.attackSamples + sideParams.releaseSamples);
+			return this->AddTails(AudioSum<bOwner>::GetTailSamples(sampleRate), static_cast<size_t>(std::ceil(11.0 * timeConstants)));
+		}
+
+		/** Unlinked stereo with the envelope at the full rate is the only mode that runs at 2x */
+		virtual bool CanProcessOversampled() const noexcept override
+		{
+			return stereoMode == ECompressorStereoMode::LR && params.controlDecimation <= 1;
+		}
+
+		virtual void ProcessOversampled(
+			double* const* const bufsX2,
+			const size_t numChannels,
+			const size_t numSamples,
+			const unsigned long sampleRate) noexcept override
+		{
+			if (!Initialize(numChannels, numSamples))
+				return;
+
+			for (size_t ch = 0; ch < channels.size() && ch < numChannels; ++ch)
+				channels[ch].ProcessOversampled(bufsX2[ch], numSamples);
+		}
+
+		virtual size_t GetOversampledDelay() const noexcept override
+		{
+			return CompressorChannel::oversampledDelay;
+		}
+
 		void Measure(IMeasurer& m, const double threshold_db, const double ratio, const double knee_db,
 			const size_t nGainCompPts)
 		{
@@ -251,10 +271,55 @@ namespace json2wav
 		}
 
 	private:
+		/** Sizes the channels for the stereo mode once, from the first block */
+		bool Initialize(const size_t numChannels, const size_t bufSize)
+		{
+			if (!bInitialized)
+			{
+				if (stereoMode == ECompressorStereoMode::LR)
+				{
+					channels.resize(numChannels);
+					sidechains.resize(channels.size());
+					for (size_t i = 0; i < channels.size(); ++i)
+					{
+						channels[i].SetParams(params);
+						sidechains[i].resize(bufSize);
+					}
+				}
+				else if (stereoMode == ECompressorStereoMode::M)
+				{
+					channels.resize(1);
+					sidechains.resize(1);
+					channels[0].SetParams(params);
+					sidechains[0].resize(bufSize);
+				}
+				else if (stereoMode == ECompressorStereoMode::MS)
+				{
+					channels.resize(numChannels);
+					sidechains.resize(channels.size());
+					for (size_t i = 0; i < channels.size(); ++i)
+					{
+						channels[i].SetParams((i & 1) ? sideParams : params);
+						sidechains[i].resize(bufSize);
+					}
+				}
+				else
+				{
+					return false;
+				}
+				bInitialized = true;
+			}
+			return bInitialized;
+		}
+
 		class GainComputer
 		{
 		public:
-			GainComputer() : xm1(0), um1(0) {}
+			GainComputer()
+				: curThreshold_db(std::numeric_limits<double>::quiet_NaN()), curRatio(0), curKnee_db(0),
+				tableBottomExponent(0), xm1(0), um1(0)
+			{
+			}
 			GainComputer(const GainComputer&) noexcept = default;
 			GainComputer(GainComputer&&) noexcept = default;
 			GainComputer& operator=(const GainComputer&) noexcept = default;
@@ -264,7 +329,7 @@ namespace json2wav
 			{
 				// ADAA1
 				double a[2];
-				a[0] = U(std::abs(x));
+				a[0] = CurveU(std::abs(x));
 				a[1] = -a[0];
 				const double u = a[x < 0.0];
 				const double dx = x - xm1;
@@ -273,7 +338,7 @@ namespace json2wav
 				um1 = u;
 				static constexpr const double tol = 0.0001;
 				if (std::abs(dx) < tol)
-					return G(0.5*(x + xm1)) - 1.0;
+					return CurveG(0.5*(x + xm1)) - 1.0;
 				return du/dx;
 			}
 
@@ -281,9 +346,9 @@ namespace json2wav
 			{
 				// ADAA1
 				static constexpr const double tol2 = 0.00000001;
-				const double y = G(0.5*(x + xm1));
+				const double y = CurveG(0.5*(x + xm1));
 				double a[2];
-				a[0] = U(std::abs(x));
+				a[0] = CurveU(std::abs(x));
 				a[1] = -a[0];
 				const double u = a[x < 0.0];
 				aout[0] = u;
@@ -297,8 +362,20 @@ namespace json2wav
 				return du/dx;
 			}
 
+			/** The gain less one at a level, without antialiasing, for envelopes running below the sample rate */
+			double ComputeStatic(const double x)
+			{
+				return CurveG(x) - 1.0;
+			}
+
 			void SetParams(const double threshold_db, const double ratio, const double knee_db)
 			{
+				if (threshold_db == curThreshold_db && ratio == curRatio && knee_db == curKnee_db)
+					return;
+				curThreshold_db = threshold_db;
+				curRatio = ratio;
+				curKnee_db = knee_db;
+
 				const double T = threshold_db;
 				const double R = (ratio > 1.1) ? ratio : 1.1;
 				const double K = (knee_db > 0.1) ? knee_db : 0.1;
@@ -338,6 +415,10 @@ namespace json2wav
 				W_k_powscale = std::pow(10.0, d*0.05);
 				W_k_powarg_scale = 20.0*b;
 				W_k_powarg_offset = c - 1.0;
+
+#if ALBUMBOT_COMPRESSOR_GAIN_TABLE
+				BuildTable();
+#endif
 			}
 
 			void Measure(IMeasurer& m,
@@ -362,6 +443,100 @@ namespace json2wav
 				}
 			}
 
+		private:
+			// Levels from the octave holding the knee's start up to 2^tableTopExponent (+36 dBFS) are tabled
+			static constexpr const int tableTopExponent = 6;
+			static constexpr const size_t stepsPerOctave = 32;
+
+			/**
+			 * Fits a cubic to U over each step between levels spaced evenly within each octave, matching U and its
+			 * derivative G - 1 at both ends. The fit is smooth across steps, so ADAA's difference quotient stays an
+			 * average of a close fit to G - 1, and the step comes from the level's exponent and mantissa.
+			 */
+			void BuildTable()
+			{
+				int bottomExponent;
+				std::frexp(T_k1, &bottomExponent);
+				tableBottomExponent = bottomExponent;
+				const size_t numSteps = (tableTopExponent >= bottomExponent) ?
+					static_cast<size_t>(tableTopExponent - bottomExponent + 1) * stepsPerOctave : 0;
+				tableCoeffs.resize(numSteps * 4);
+
+				const auto level = [bottomExponent](const size_t step)
+				{
+					return std::ldexp(1.0 + static_cast<double>(step % stepsPerOctave) / stepsPerOctave,
+						bottomExponent - 1 + static_cast<int>(step / stepsPerOctave));
+				};
+				double x0 = level(0);
+				double u0 = U(x0);
+				double d0 = G(x0) - 1.0;
+				for (size_t step = 0; step < numSteps; ++step)
+				{
+					const double x1 = level(step + 1);
+					const double u1 = U(x1);
+					const double d1 = G(x1) - 1.0;
+					const double h = x1 - x0;
+					double* const c = &tableCoeffs[step * 4];
+					c[0] = u0;
+					c[1] = h*d0;
+					c[2] = 3.0*(u1 - u0) - h*(d0 + d0 + d1);
+					c[3] = 2.0*(u0 - u1) + h*(d0 + d1);
+					x0 = x1;
+					u0 = u1;
+					d0 = d1;
+				}
+			}
+
+			double TableU(const double x)
+			{
+				if (x <= T_k1)
+					return 0.0;
+				int exponent;
+				const double mantissa = std::frexp(x, &exponent);
+				if (exponent > tableTopExponent)
+					return U(x);
+				const double pos = (mantissa + mantissa - 1.0) * stepsPerOctave;
+				const size_t step = std::min(static_cast<size_t>(pos), stepsPerOctave - 1);
+				const double t = pos - static_cast<double>(step);
+				const double* const c = &tableCoeffs[(static_cast<size_t>(exponent - tableBottomExponent) * stepsPerOctave + step) * 4];
+				return c[0] + t*(c[1] + t*(c[2] + t*c[3]));
+			}
+
+			double TableG(const double x_in)
+			{
+				const double x = std::abs(x_in);
+				if (x <= T_k1)
+					return 1.0;
+				int exponent;
+				const double mantissa = std::frexp(x, &exponent);
+				if (exponent > tableTopExponent)
+					return G(x);
+				const double pos = (mantissa + mantissa - 1.0) * stepsPerOctave;
+				const size_t step = std::min(static_cast<size_t>(pos), stepsPerOctave - 1);
+				const double t = pos - static_cast<double>(step);
+				const double* const c = &tableCoeffs[(static_cast<size_t>(exponent - tableBottomExponent) * stepsPerOctave + step) * 4];
+				const double invH = std::ldexp(static_cast<double>(stepsPerOctave + stepsPerOctave), -exponent);
+				return (c[1] + t*(2.0*c[2] + 3.0*t*c[3]))*invH + 1.0;
+			}
+
+			double CurveU(const double x)
+			{
+#if ALBUMBOT_COMPRESSOR_GAIN_TABLE
+				return TableU(x);
+#else
+				return U(x);
+#endif
+			}
+
+			double CurveG(const double x)
+			{
+#if ALBUMBOT_COMPRESSOR_GAIN_TABLE
+				return TableG(x);
+#else
+				return G(x);
+#endif
+			}
+
 		private:
 			static double sqrtpi()
 			{
@@ -441,6 +616,15 @@ namespace json2wav
 			}
 
 		private:
+			// Settings the cached calculations and table are for
+			double curThreshold_db;
+			double curRatio;
+			double curKnee_db;
+
+			// Cubic coefficients of U over each step of the table, lowest level first
+			Vector<double> tableCoeffs;
+			int tableBottomExponent;
+
 			// Cached calculations from parameters
 			double T_k1;
 			double T_k2;
@@ -472,7 +656,9 @@ namespace json2wav
 			CompressorChannel()
 				: inputDelay{ static_cast<Sample>(0.0f) },
 				passThruDelay{ static_cast<Sample>(0.0f) },
-				gm1(0.0), vm1(0.0), dryVolume(0.0f), pEnvelopeFilter(tdf2())
+				gm1(0.0), vm1(0.0), dryVolume(0.0f), pEnvelopeFilter(tdf2()),
+				outputDelay{ static_cast<Sample>(0.0f) },
+				decimation(1), detectPos(0), detectSum(0.0), ctlGain(0.0), ctlStep(0.0), outputDelayPos(0)
 			{
 			}
 			CompressorChannel(const CompressorChannel&) = default;
@@ -486,9 +672,10 @@ namespace json2wav
 				gc.SetParams(paramsToSet.threshold_db, paramsToSet.ratio, paramsToSet.knee_db);
 				gm1 = 0.0;
 				vm1 = 0.0;
+				decimation = std::clamp<size_t>(paramsToSet.controlDecimation, 1, numOutputDelaySamples);
 				b = std::sqrt(paramsToSet.attackSamples + paramsToSet.releaseSamples);
-				at2 = paramsToSet.attackSamples*2.0;
-				rt2 = paramsToSet.releaseSamples*2.0;
+				at2 = paramsToSet.attackSamples*2.0/static_cast<double>(decimation);
+				rt2 = paramsToSet.releaseSamples*2.0/static_cast<double>(decimation);
 				dryVolume = (paramsToSet.dryVolume_db > -100.0f) ? Utility::DBToGain(paramsToSet.dryVolume_db) : 0.0f;
 				pEnvelopeFilter = (paramsToSet.df2) ? df2() : tdf2();
 			}
@@ -496,6 +683,12 @@ namespace json2wav
 			void Process(double* const scbuf, Sample* const iobuf, const size_t bufSize, const unsigned long sampleRate,
 				double* const gcbuf = nullptr, double* const tabuf = nullptr, double* const gebuf = nullptr)
 			{
+				if (decimation > 1)
+				{
+					ProcessDecimated(scbuf, iobuf, bufSize);
+					return;
+				}
+
 				thread_local Vector<double> workbuf;
 				thread_local Vector<double> iobuf_up;
 				thread_local Vector<Sample> drySignal;
@@ -517,29 +710,57 @@ namespace json2wav
 				if (gebuf)
 					for (size_t i = 0; i < bufSize; ++i)
 						gebuf[i] = scbuf[i];
-				if (std::abs(dryVolume) > 0.00001) // > -100 dB
+				if (bufSize < 256)
 				{
-					drySignal.resize(bufSize);
+					// Too short to delay in place, as the last block of a song or window can be
+					Sample delayLine[256 + 256];
 					for (size_t i = 0; i < 128; ++i)
 					{
-						drySignal[i] = dryVolume*passThruDelay[i];
-						drySignal[128 + i] = dryVolume*inputDelay[i];
+						delayLine[i] = passThruDelay[i];
+						delayLine[128 + i] = inputDelay[i];
+					}
+					for (size_t i = 0; i < bufSize; ++i)
+						delayLine[256 + i] = iobuf[i];
+					if (std::abs(dryVolume) > 0.00001) // > -100 dB
+					{
+						drySignal.resize(bufSize);
+						for (size_t i = 0; i < bufSize; ++i)
+							drySignal[i] = dryVolume*delayLine[i];
+					}
+					for (size_t i = 0; i < bufSize; ++i)
+						iobuf[i] = delayLine[128 + i];
+					for (size_t i = 0; i < 128; ++i)
+					{
+						passThruDelay[i] = delayLine[bufSize + i];
+						inputDelay[i] = delayLine[bufSize + 128 + i];
 					}
-					for (size_t i = 256; i < bufSize; ++i)
-						drySignal[i] = dryVolume*iobuf[i - 256];
-				}
-				Sample atmp[128] = { static_cast<Sample>(0.0f) };
-				for (size_t i = 0; i < 128; ++i)
-				{
-					passThruDelay[i] = iobuf[bufSize - 256 + i];
-					atmp[i] = iobuf[bufSize - 128 + i];
-					for (size_t j = 256; j - i <= bufSize; j += 128)
-						iobuf[bufSize - (j - 128) + i] = iobuf[bufSize - j + i];
 				}
-				for (size_t i = 0; i < 128; ++i)
+				else
 				{
-					iobuf[i] = inputDelay[i];
-					inputDelay[i] = atmp[i];
+					if (std::abs(dryVolume) > 0.00001) // > -100 dB
+					{
+						drySignal.resize(bufSize);
+						for (size_t i = 0; i < 128; ++i)
+						{
+							drySignal[i] = dryVolume*passThruDelay[i];
+							drySignal[128 + i] = dryVolume*inputDelay[i];
+						}
+						for (size_t i = 256; i < bufSize; ++i)
+							drySignal[i] = dryVolume*iobuf[i - 256];
+					}
+					Sample atmp[128] = { static_cast<Sample>(0.0f) };
+					for (size_t i = 0; i < 128; ++i)
+					{
+						passThruDelay[i] = iobuf[bufSize - 256 + i];
+						atmp[i] = iobuf[bufSize - 128 + i];
+						for (size_t j = 256; j - i <= bufSize; j += 128)
+							iobuf[bufSize - (j - 128) + i] = iobuf[bufSize - j + i];
+					}
+					for (size_t i = 0; i < 128; ++i)
+					{
+						iobuf[i] = inputDelay[i];
+						inputDelay[i] = atmp[i];
+					}
 				}
 				us_in.process_unsafe(bufSize, iobuf, iobuf_up.data());
 				us_ge.process_unsafe(bufSize, scbuf, workbuf.data());
@@ -551,6 +772,72 @@ namespace json2wav
 						iobuf[i] += drySignal[i];
 			}
 
+			/** Moves on over bufSize samples of silence at rest, which leave the channel as it was but for its decimation phase */
+			void SkipSilence(const size_t bufSize) noexcept
+			{
+				if (decimation > 1)
+				{
+					detectPos = (detectPos + bufSize) % decimation;
+					outputDelayPos = (outputDelayPos + bufSize) & (numOutputDelaySamples - 1);
+				}
+			}
+
+			/**
+			 * Process for audio that's already at 2x. The sidechain comes down once for detection and the gain goes back up
+			 * as usual, which leaves it trailing the audio by oversampledDelay, so the audio waits that long at 2x before
+			 * they multiply. The dry signal shares the wet one's delay, so it folds into the gain.
+			 */
+			void ProcessOversampled(double* const iobufX2, const size_t bufSize)
+			{
+				const size_t bufSizeX2 = bufSize << 1;
+				thread_local Vector<double> scbuf;
+				thread_local Vector<double> workbuf;
+				scbuf.resize(bufSize);
+				workbuf.resize(bufSizeX2);
+				ds_sc.process_unsafe(bufSize, iobufX2, scbuf.data());
+				us_gc.process_unsafe(bufSize, scbuf.data(), workbuf.data());
+				for (size_t i = 0; i < bufSizeX2; ++i)
+					workbuf[i] = gc.Compute(workbuf[i]);
+				ds_gc.process_unsafe(bufSize, workbuf.data(), scbuf.data());
+				for (size_t i = 0; i < bufSize; ++i)
+					scbuf[i] = EnvelopeFilter(scbuf[i]);
+				us_ge.process_unsafe(bufSize, scbuf.data(), workbuf.data());
+
+				constexpr const size_t delayX2 = oversampledDelay << 1;
+				oversampledLine.resize(delayX2 + bufSizeX2);
+				std::copy_n(iobufX2, bufSizeX2, oversampledLine.data() + delayX2);
+				const double gainOffset = 1.0 + ((std::abs(dryVolume) > 0.00001) ? static_cast<double>(dryVolume) : 0.0); // > -100 dB
+				for (size_t i = 0; i < bufSizeX2; ++i)
+					iobufX2[i] = (workbuf[i] + gainOffset)*oversampledLine[i];
+				std::copy_n(oversampledLine.data() + bufSizeX2, delayX2, oversampledLine.data());
+			}
+
+			/**
+			 * Averages the gain computer's table over every decimation samples and runs the envelope on the averages,
+			 * ramping the gain linearly to each new value over the next decimation samples. No oversampling is needed
+			 * since the ramped gain is smooth; the output is delayed to keep the oversampled path's latency.
+			 */
+			void ProcessDecimated(const double* const scbuf, Sample* const iobuf, const size_t bufSize)
+			{
+				const double invDecimation = 1.0/static_cast<double>(decimation);
+				const double wetOffset = 1.0 + static_cast<double>(dryVolume);
+				for (size_t i = 0; i < bufSize; ++i)
+				{
+					detectSum += gc.ComputeStatic(scbuf[i]);
+					const float x = iobuf[i].AsFloat32();
+					iobuf[i] = outputDelay[outputDelayPos];
+					outputDelay[outputDelayPos] = static_cast<float>((ctlGain + wetOffset)*x);
+					outputDelayPos = (outputDelayPos + 1) & (numOutputDelaySamples - 1);
+					ctlGain += ctlStep;
+					if (++detectPos == decimation)
+					{
+						ctlStep = (EnvelopeFilter(detectSum*invDecimation) - ctlGain)*invDecimation;
+						detectSum = 0.0;
+						detectPos = 0;
+					}
+				}
+			}
+
 			double EnvelopeFilterTimeArg(const double x)
 			{
 				const double bxp = std::pow(b, x);
@@ -652,12 +939,20 @@ namespace json2wav
 				return &efdf2;
 			}
 
+		public:
+			/** Base-rate samples between the input and the gain in ProcessOversampled: four half trips through 2x */
+			static constexpr const size_t oversampledDelay = 2 * oversampling::delay441_x2;
+
+		private:
+			static constexpr const size_t numOutputDelaySamples = CompressorParams::MaxControlDecimation;
+
 		private:
 			oversampling::upsampler441_x2_qsmp<double> us_gc; // ADAA1 in gain computer causes half-sample delay
 			oversampling::downsampler441_x2<double> ds_gc;
 			oversampling::upsampler441_x2<double> us_in;
 			oversampling::upsampler441_x2<double> us_ge;
 			oversampling::downsampler441_x2<double> ds_rm;
+			oversampling::downsampler441_x2<double> ds_sc; // Brings ProcessOversampled's input down for detection
 			GainComputer gc;
 			Sample inputDelay[128];
 			Sample passThruDelay[128];
@@ -668,6 +963,18 @@ namespace json2wav
 			double rt2;
 			float dryVolume;
 			EnvelopeFilterStrategy* pEnvelopeFilter;
+
+			// Control-rate detection
+			Sample outputDelay[numOutputDelaySamples];
+			size_t decimation;
+			size_t detectPos;
+			double detectSum;
+			double ctlGain;
+			double ctlStep;
+			size_t outputDelayPos;
+
+			// Oversampled audio waiting for its gain
+			Vector<double> oversampledLine;
 		};
 
 	private:
@@ -1,11 +1,18 @@
 // Copyright Dan Price 2026.
 
 #include "DebugNew.h"
+#ifdef ALBUMBOT_ALLOCGUARD
+#include "AllocGuard.h"
+#include "NodeNames.h"
+#endif
 #include <chrono>
 #include <atomic>
 #include <iostream>
 #include <cstdlib>
 #include <cstdint>
+#include <cstddef>
+#include <string>
+#include <new>
 
 namespace
 {
@@ -20,16 +27,76 @@ namespace
 		static std::atomic<uint64_t> timens = 0.0f;
 		return timens;
 	}
+
+	std::atomic<uint64_t>& GetNumAllocs()
+	{
+		static std::atomic<uint64_t> numAllocs = 0;
+		return numAllocs;
+	}
+
+#ifdef ALBUMBOT_ALLOCGUARD
+	// Only the first few guard violations are kept; everything is counted
+	struct GuardRecord
+	{
+		json2wav::allocguard::NodeId node;
+		std::size_t sz;
+	};
+
+	constexpr std::size_t maxGuardRecords = 64;
+	GuardRecord guardRecords[maxGuardRecords];
+	std::atomic<std::size_t> numGuardViolations = 0;
+	std::atomic<bool> bGuardArmed = false;
+	thread_local json2wav::allocguard::NodeId guardNode{ nullptr, nullptr };
+	thread_local unsigned int guardExemptDepth = 0;
+
+	void RecordAlloc(const std::size_t sz) noexcept
+	{
+		if (bGuardArmed.load(std::memory_order_relaxed) && guardExemptDepth == 0)
+		{
+			const std::size_t idx = numGuardViolations.fetch_add(1);
+			if (idx < maxGuardRecords)
+				guardRecords[idx] = GuardRecord{ guardNode, sz };
+		}
+	}
+
+	/** The node's label from the interpreter if it has one, otherwise its type */
+	std::string GetNodeName(const json2wav::allocguard::NodeId& node)
+	{
+		if (!node.type)
+			return "(no node)";
+		if (std::string label = json2wav::NodeNames::Find(node.node); !label.empty())
+			return label;
+		return json2wav::NodeNames::ShortTypeName(*node.type);
+	}
+#else
+	void RecordAlloc(const std::size_t) noexcept
+	{
+	}
+#endif
+
+	void* TimedAlloc(const std::size_t sz, const std::size_t al)
+	{
+		RecordAlloc(sz);
+		GetNumAllocs().fetch_add(1, std::memory_order_relaxed);
+		auto start = std::chrono::high_resolution_clock::now();
+		void* ptr = (al > alignof(std::max_align_t)) ? std::aligned_alloc(al, (sz + al - 1) & ~(al - 1)) : std::malloc(sz ? sz : 1);
+		auto end = std::chrono::high_resolution_clock::now();
+		std::chrono::nanoseconds diff = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+		GetAllocTime() += diff.count();
+		if (!ptr)
+			throw std::bad_alloc();
+		return ptr;
+	}
 }
 
 void* operator new(std::size_t sz)
 {
-	auto start = std::chrono::high_resolution_clock::now();
-	void* ptr = std::malloc(sz);
-	auto end = std::chrono::high_resolution_clock::now();
-	std::chrono::nanoseconds diff = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
-	GetAllocTime() += diff.count();
-	return ptr;
+	return TimedAlloc(sz, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t sz, std::align_val_t al)
+{
+	return TimedAlloc(sz, static_cast<std::size_t>(al));
 }
 
 void operator delete(void* ptr) noexcept
@@ -41,6 +108,11 @@ void operator delete(void* ptr) noexcept
 	GetDeallocTime() += diff.count();
 }
 
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+	operator delete(ptr);
+}
+
 namespace json2wav
 {
 	double QueryAllocTime()
@@ -55,12 +127,77 @@ namespace json2wav
 		return static_cast<double>(timens)*0.000000001;
 	}
 
+	uint64_t QueryNumAllocs()
+	{
+		return GetNumAllocs().exchange(0);
+	}
+
 	void PrintAllocTimes(const char* const desc)
 	{
 		const double allocTime = QueryAllocTime();
 		const double deallocTime = QueryDeallocTime();
-		std::cout << allocTime << " seconds spent allocating and\n";
-		std::cout << deallocTime << " seconds spent deallocating " << desc << "\nsince previous query.\n";
+		std::cerr << allocTime << " seconds spent allocating and\n";
+		std::cerr << deallocTime << " seconds spent deallocating " << desc << "\nsince previous query.\n";
 	}
-}
 
+#ifdef ALBUMBOT_ALLOCGUARD
+	namespace allocguard
+	{
+		void Arm() noexcept
+		{
+			numGuardViolations.store(0);
+			bGuardArmed.store(true);
+		}
+
+		bool Disarm()
+		{
+			bGuardArmed.store(false);
+			const std::size_t numViolations = numGuardViolations.exchange(0);
+			if (numViolations == 0)
+				return true;
+
+			const std::size_t numRecords = (numViolations < maxGuardRecords) ? numViolations : maxGuardRecords;
+			std::cerr << numViolations << " allocations after the first block of the render";
+			if (numRecords < numViolations)
+				std::cerr << " (first " << numRecords << " shown)";
+			std::cerr << ":\n";
+			for (std::size_t i = 0; i < numRecords; ++i)
+			{
+				bool bSeen = false;
+				for (std::size_t j = 0; j < i && !bSeen; ++j)
+					bSeen = guardRecords[j].node.node == guardRecords[i].node.node;
+				if (bSeen)
+					continue;
+
+				std::size_t count = 0;
+				std::size_t bytes = 0;
+				for (std::size_t j = i; j < numRecords; ++j)
+				{
+					if (guardRecords[j].node.node == guardRecords[i].node.node)
+					{
+						++count;
+						bytes += guardRecords[j].sz;
+					}
+				}
+				std::cerr << "  " << GetNodeName(guardRecords[i].node) << ": " << count << " allocations, " << bytes << " bytes\n";
+			}
+			return false;
+		}
+
+		NodeId SetNode(const NodeId node) noexcept
+		{
+			const NodeId prev = guardNode;
+			guardNode = node;
+			return prev;
+		}
+
+		void SetExempt(const bool bExempt) noexcept
+		{
+			if (bExempt)
+				++guardExemptDepth;
+			else
+				--guardExemptDepth;
+		}
+	}
+#endif
+}
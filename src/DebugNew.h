@@ -2,17 +2,24 @@
 
 #pragma once
 
+#include <new>
 #include <cstddef>
+#include <cstdint>
 
+#ifndef ALBUMBOT_DEBUGNEW
 #define ALBUMBOT_DEBUGNEW
+#endif
 
 void* operator new(std::size_t sz);
 void operator delete(void* ptr) noexcept;
+void* operator new(std::size_t sz, std::align_val_t al);
+void operator delete(void* ptr, std::align_val_t al) noexcept;
 
 namespace json2wav
 {
 	double QueryAllocTime();
 	double QueryDeallocTime();
+	uint64_t QueryNumAllocs();
 	void PrintAllocTimes(const char* const desc);
 }
 
@@ -5,10 +5,14 @@
 #include "IAudioObject.h"
 #include "Sample.h"
 #include "Filter.h"
+#include "SampleKernels.h"
 #include "Utility.h"
 #include "Memory.h"
+#include "BlockScratch.h"
 #include <limits>
-#include <functional>
+#include <algorithm>
+#include <bit>
+#include <cmath>
 
 namespace json2wav
 {
@@ -28,17 +32,60 @@ namespace json2wav
 		}
 	}
 
-	template<bool bOwner = false>
+	/**
+	 * Filters for a Delay's echoes, chosen at compile time so the delay filters whole spans through direct calls.
+	 * A filter runs on each span of output in order, and what it outputs is what feeds back.
+	 */
+	namespace DelayFilter
+	{
+		/** Leaves echoes unfiltered */
+		struct None
+		{
+			static constexpr const size_t maxChannels = std::numeric_limits<size_t>::max();
+
+			void Process(Sample* const* const bufs, const size_t numChannels, const size_t start, const size_t count) noexcept
+			{
+			}
+		};
+
+		/** Lowpasses echoes with a Bessel filter; order 1 is a one-pole and order 2 a biquad */
+		template<uint_fast8_t order, Filter::ETopo eTopo = Filter::ETopo::TDF2, uint_fast8_t numch = 2>
+		class BesselLP
+		{
+		public:
+			static constexpr const size_t maxChannels = numch;
+
+			void Recalc(const float deltaTime, const float freq)
+			{
+				state.Recalc(deltaTime, freq);
+			}
+
+			void Process(Sample* const* const bufs, const size_t numChannels, const size_t start, const size_t count) noexcept
+			{
+				if (numChannels == numch)
+				{
+					Filter::Topo<eTopo>::template DoFilterBlock<float, order, numch>(bufs, start, count, state.z, state.a, state.b, state.b1);
+					return;
+				}
+				for (size_t ch = 0; ch < numChannels; ++ch)
+					for (size_t i = start; i < start + count; ++i)
+						Filter::Topo<eTopo>::template DoFilter<float, order>(bufs[ch][i], state.z[ch], state.a, state.b, state.b1[ch]);
+			}
+
+		private:
+			Filter::FilterState<float, float, Filter::BesselLPLaplace<float, order>, order, numch> state;
+		};
+	}
+
+	template<bool bOwner = false, typename FeedbackFilter = DelayFilter::None>
 	class Delay : public AudioSum<bOwner>
 	{
 	public:
 		Delay(const float timeInit, const float feedbackInit = 0.0f, const EFeedbackType efbt = EFeedbackType::Gain,
 			const size_t sampleRateInit = 0)
 			: time(timeInit), feedback(CalcFeedback(feedbackInit, efbt)), timeSamples(0),
-			filtnumch(std::numeric_limits<size_t>::max()),
 			lastNumChannels(0), lastSampleRate(sampleRateInit),
-			queueLength(256), bQueueInitialized(false),
-			filter([](const uint_fast8_t ch, const float val) -> Sample { Sample smp(val); return smp; })
+			queueLength(0), queuePos(0), bQueueInitialized(false)
 		{
 		}
 
@@ -47,6 +94,8 @@ namespace json2wav
 			time = t;
 			if (lastSampleRate > 0)
 				timeSamples = static_cast<size_t>(time * static_cast<float>(lastSampleRate));
+			if (bQueueInitialized)
+				timeSamples = std::min(timeSamples, queueLength);
 		}
 
 		float GetTime() const noexcept
@@ -83,66 +132,18 @@ namespace json2wav
 			return (feedback == 0.0f) ? -std::numeric_limits<float>::infinity() : Utility::GainToDB(sign*feedback);
 		}
 
-	private:
-		template<uint_fast8_t order, uint_fast8_t numch>
-		using BesselFilterState = Filter::FilterState<float, float, Filter::BesselLPLaplace<float, order>, order, numch>;
-
-		template<uint_fast8_t order>
-		SharedPtr<Filter::IFilterState<float, float>> CreateBesselFilterState(const uint_fast8_t numch)
-		{
-			SharedPtr<Filter::IFilterState<float, float>> ptr;
-			switch (numch)
-			{
-			case 1: ptr = MakeShared<BesselFilterState<order, 1>>(); break;
-			case 2: ptr = MakeShared<BesselFilterState<order, 2>>(); break;
-			default: break;
-			}
-			return ptr;
-		}
-
-	public:
-		void SetBesselFilter(
-			const float deltaTime,
-			const float freq,
-			const uint_fast8_t order,
-			const uint_fast8_t numch,
-			const Filter::ETopo eTopo = Filter::ETopo::TDF2)
-		{
-			filtnumch = numch;
-			auto CreateFilterState = [this, order, numch]()
-			{
-				switch (order)
-				{
-				case 0:
-				case 1: return CreateBesselFilterState<1>(numch);
-				case 2: return CreateBesselFilterState<2>(numch);
-				case 3: return CreateBesselFilterState<3>(numch);
-				case 4: return CreateBesselFilterState<4>(numch);
-				case 5: return CreateBesselFilterState<5>(numch);
-				case 6: return CreateBesselFilterState<6>(numch);
-				case 7: return CreateBesselFilterState<7>(numch);
-				default:
-				case 8: return CreateBesselFilterState<8>(numch);
-				}
-			};
-			filterState = CreateFilterState();
-			filterState->Recalc(deltaTime, freq);
-			filter = [this, eTopo](const uint_fast8_t ch, const float val) -> Sample
-			{
-				Sample smp(val);
-				filterState->DoFilter(ch, smp, eTopo);
-				return smp;
-			};
-		}
-
-		void UnsetFilter()
+		FeedbackFilter& GetFeedbackFilter() noexcept
 		{
-			filter = [](const uint_fast8_t ch, const float val) { Sample smp(val); return smp; };
-			filterState = nullptr;
-			filtnumch = std::numeric_limits<size_t>::max();
+			return feedbackFilter;
 		}
 
 	public:
+		/**
+		 * The queue is a ring of the sums still to be echoed, timeSamples of them live from queuePos. Each block's input
+		 * is pulled once, whole, into scratch, since inputs like the compressor expect whole blocks. Delays shorter than
+		 * the block echo within it a delay's worth at a time; longer ones copy a whole block out of the ring and the
+		 * input into it.
+		 */
 		virtual void GetSamples(
 			Sample* const* const bufs,
 			const size_t numChannels,
@@ -152,56 +153,61 @@ namespace json2wav
 		{
 			static const float fbthresh = Utility::DBToGain(-96.3f);
 			static constexpr const int arrsign[2] = { 1, -1 };
-			if (numChannels > filtnumch)
+			if (numChannels > FeedbackFilter::maxChannels)
 				return;
 
 			lastNumChannels = numChannels;
 			lastSampleRate = sampleRate;
 			InitializeQueue(numChannels, sampleRate);
-			Vector<Sample*> bufOffsets(numChannels, nullptr);
-			size_t fillSize = timeSamples;
-			size_t movenum = 0;
 			const bool bFeedback = arrsign[feedback < 0.0f] * feedback >= fbthresh;
 
-			if (timeSamples < bufSize)
+			if (timeSamples == 0)
 			{
-				for (size_t ch = 0; ch < numChannels; ++ch)
-				{
-					for (size_t i = 0; i < timeSamples; ++i)
-						bufs[ch][i] = filter(ch, queue[ch][i]);
-					bufOffsets[ch] = bufs[ch] + timeSamples;
-				}
-				this->GetInputSamples(bufOffsets.data(), numChannels, bufSize - fillSize, sampleRate);
+				this->GetInputSamples(bufs, numChannels, bufSize, sampleRate);
 				if (bFeedback)
 					for (size_t ch = 0; ch < numChannels; ++ch)
-						for (size_t i = timeSamples; i < bufSize; ++i)
-							bufs[ch][i] = filter(ch, bufs[ch][i] + feedback * bufs[ch][i - timeSamples]);
-				else
-					for (size_t ch = 0; ch < numChannels; ++ch)
-						for (size_t i = timeSamples; i < bufSize; ++i)
-							bufs[ch][i] = filter(ch, bufs[ch][i]);
-				for (size_t ch = 0; ch < numChannels; ++ch)
-					bufOffsets[ch] = queue[ch];
+						kernel::Gain(AsSpan(bufs[ch], bufSize), 1.0f + feedback);
+				feedbackFilter.Process(bufs, numChannels, 0, bufSize);
+				return;
 			}
-			else
+
+			ScratchVector<Sample> input(numChannels * bufSize, BlockScratch::Get());
+			ScratchVector<Sample*> inputBufs(numChannels, nullptr, BlockScratch::Get());
+			for (size_t ch = 0; ch < numChannels; ++ch)
+				inputBufs[ch] = input.data() + ch * bufSize;
+			this->GetInputSamples(inputBufs.data(), numChannels, bufSize, sampleRate);
+
+			const size_t echoSize = std::min(timeSamples, bufSize);
+			ReadQueue(bufs, numChannels, echoSize);
+			feedbackFilter.Process(bufs, numChannels, 0, echoSize);
+			if (timeSamples < bufSize)
 			{
-				movenum = timeSamples - bufSize;
 				for (size_t ch = 0; ch < numChannels; ++ch)
+					kernel::Copy(AsSpan(bufs[ch] + timeSamples, bufSize - timeSamples), AsSpan(inputBufs[ch], bufSize - timeSamples));
+				for (size_t start = timeSamples; start < bufSize; start += timeSamples)
 				{
-					for (size_t i = 0; i < bufSize; ++i)
-						bufs[ch][i] = filter(ch, queue[ch][i]);
-					for (size_t i = 0; i < movenum; ++i)
-						queue[ch][i] = queue[ch][timeSamples - movenum + i];
-					bufOffsets[ch] = queue[ch] + movenum;
+					const size_t count = std::min(timeSamples, bufSize - start);
+					if (bFeedback)
+						for (size_t ch = 0; ch < numChannels; ++ch)
+							kernel::AddGain(AsSpan(bufs[ch] + start, count), AsSpan(bufs[ch] + start - timeSamples, count), feedback);
+					feedbackFilter.Process(bufs, numChannels, start, count);
 				}
-				fillSize = bufSize;
 			}
 
-			this->GetInputSamples(bufOffsets.data(), numChannels, fillSize, sampleRate);
+			// The input's last echoSize samples and the last echoSize echoes go in a delay after the ones just echoed
+			WriteQueue(inputBufs.data(), numChannels, echoSize, bufSize);
 			if (bFeedback)
+			{
+				const size_t writePos = (queuePos + timeSamples) & (queueLength - 1);
+				const size_t firstCount = std::min(echoSize, queueLength - writePos);
 				for (size_t ch = 0; ch < numChannels; ++ch)
-					for (size_t i = 0; i < fillSize; ++i)
-						bufOffsets[ch][i] += feedback * bufs[ch][bufSize + movenum - timeSamples + i];
+				{
+					const Sample* const echoes = bufs[ch] + bufSize - echoSize;
+					kernel::AddGain(AsSpan(queue[ch] + writePos, firstCount), AsSpan(echoes, firstCount), feedback);
+					kernel::AddGain(AsSpan(queue[ch], echoSize - firstCount), AsSpan(echoes + firstCount, echoSize - firstCount), feedback);
+				}
+			}
+			queuePos = (queuePos + echoSize) & (queueLength - 1);
 		}
 
 		virtual size_t GetNumChannels() const noexcept override
@@ -209,6 +215,18 @@ namespace json2wav
 			return lastNumChannels;
 		}
 
+		/** Echoes repeat until the feedback has taken them below 16-bit resolution, forever if it doesn't attenuate */
+		virtual size_t GetTailSamples(const unsigned long sampleRate) const noexcept override
+		{
+			const size_t delaySamples = static_cast<size_t>(std::ceil(time * static_cast<float>(sampleRate)));
+			const float feedbackGain = std::abs(feedback);
+			if (feedbackGain >= 1.0f)
+				return SIZE_MAX;
+			const double numEchoes = (feedbackGain > 0.0f) ? std::ceil(-96.0 / Utility::GainToDB(feedbackGain)) : 0.0;
+			const size_t echoSamples = static_cast<size_t>(std::min(numEchoes + 1.0, 1e6)) * delaySamples;
+			return this->AddTails(AudioSum<bOwner>::GetTailSamples(sampleRate), echoSamples);
+		}
+
 	private:
 		void InitializeQueue(const size_t numChannels, const size_t sampleRate)
 		{
@@ -218,27 +236,46 @@ namespace json2wav
 			if (!queue.Initialized())
 			{
 				timeSamples = static_cast<size_t>(time * static_cast<float>(sampleRate));
-				size_t newQueueLength = queueLength;
-				while (newQueueLength <= timeSamples)
-					newQueueLength <<= 1;
-				queueLength = newQueueLength;
+				queueLength = std::bit_ceil(std::max<size_t>(timeSamples, 256));
 				queue.Initialize(numChannels, queueLength);
 			}
 			bQueueInitialized = true;
 		}
 
+		/** Copies the next count sums out of the ring, in up to two spans */
+		void ReadQueue(Sample* const* const bufs, const size_t numChannels, const size_t count)
+		{
+			const size_t firstCount = std::min(count, queueLength - queuePos);
+			for (size_t ch = 0; ch < numChannels; ++ch)
+			{
+				kernel::Copy(AsSpan(bufs[ch], firstCount), AsSpan(queue[ch] + queuePos, firstCount));
+				kernel::Copy(AsSpan(bufs[ch] + firstCount, count - firstCount), AsSpan(queue[ch], count - firstCount));
+			}
+		}
+
+		/** Copies the block's last count input samples into the ring a delay after the ones being echoed, in up to two spans */
+		void WriteQueue(Sample* const* const inputBufs, const size_t numChannels, const size_t count, const size_t bufSize)
+		{
+			const size_t writePos = (queuePos + timeSamples) & (queueLength - 1);
+			const size_t firstCount = std::min(count, queueLength - writePos);
+			for (size_t ch = 0; ch < numChannels; ++ch)
+			{
+				const Sample* const in = inputBufs[ch] + bufSize - count;
+				kernel::Copy(AsSpan(queue[ch] + writePos, firstCount), AsSpan(in, firstCount));
+				kernel::Copy(AsSpan(queue[ch], count - firstCount), AsSpan(in + firstCount, count - firstCount));
+			}
+		}
+
 	private:
 		float time;
 		float feedback;
 		size_t timeSamples;
-		size_t filtnumch;
 		size_t lastNumChannels;
 		size_t lastSampleRate;
-		size_t queueLength;
+		size_t queueLength; // A power of two no shorter than the delay
+		size_t queuePos;
 		bool bQueueInitialized;
 		SampleBuf queue;
-		std::function<Sample(const uint_fast8_t, const float)> filter;
-		SharedPtr<Filter::IFilterState<float, float>> filterState;
+		FeedbackFilter feedbackFilter;
 	};
 }
-
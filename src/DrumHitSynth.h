@@ -115,7 +115,9 @@ namespace json2wav
 			, const bool bActivateFilters = true)
 			: SynthWithCustomEvent<DrumHitSynthEvent>(frequency_init, 0.0f, 0.0f)
 			, hit(0.0f), th(th_init), mic(mic_init)
+			, rng(RandomSeed())
 			, rdist(0.0f, hit_range)
+			, thdist(0.0f, vTau<float>::value)
 			, strenToAmp(0.25f)
 			, transientTime(0.00025)
 			, transientShape(ERampShape::SCurve)
@@ -192,7 +194,7 @@ namespace json2wav
 				OnFrequencyChange(GetFrequency(), deltaTime);
 				//OnAmplitudeChange(GetAmplitude(), deltaTime);
 				OnHitChange();
-				GetSynthSamples(bufs, 1, numSamples, false, [this, buf, deltaTime](const size_t i)
+				GetSynthSamples(bufs, 1, numSamples, false, deltaTime, [this, buf, deltaTime](const size_t i)
 					{
 						const bool bIncAmp = IncrementHit(deltaTime);
 						Increment(deltaTime);
@@ -265,10 +267,8 @@ namespace json2wav
 				bReentering = true;
 				filts[0]->GetSamples(bufs, 1, numSamples, sampleRate, requester);
 				bReentering = false;
-				Sample* const buf = bufs[0];
 				for (size_t ch = 1; ch < numChannels; ++ch)
-					for (size_t idx = 0; idx < numSamples; ++idx)
-						bufs[ch][idx] = buf[idx];
+					kernel::Copy(AsSpan(bufs[ch], numSamples), AsSpan(bufs[0], numSamples));
 			}
 		}
 
@@ -553,16 +553,14 @@ namespace json2wav
 
 		void Hit(const float hitStrength, const unsigned long sampleNum)
 		{
-			static std::uniform_real_distribution<float> thdist(0.0f, vTau<float>::value);
-
 			const float amp = GetAmplitude();
 			float oldamp = 0.0f;
 			for (size_t order = 0; order < DrumHit::NumOrders; ++order)
 				for (size_t zero = 0; zero < DrumHit::NumZeroes; ++zero)
 					oldamp += amp * amps[order][zero] * fast::cos(phases[order][zero] * vTau<double>::value);
 
-			SetHitRadius(grng(rdist));
-			SetHitAngle(grng(thdist));
+			SetHitRadius(rng(rdist));
+			SetHitAngle(rng(thdist));
 			ResetPhase();
 
 			OnHitChange();
@@ -580,8 +578,8 @@ namespace json2wav
 			const unsigned long smpend = sampleNum + decayDelaySamps + decayTimeSamps + 1;
 
 			{
-				Vector<size_t> eventsToErase = GetEventKeysInRange(smpstart, smpend);
-				Vector<std::pair<size_t, size_t>> erasepairs;
+				const ScratchVector<size_t> eventsToErase = GetEventKeysInRange(smpstart, smpend);
+				ScratchVector<std::pair<size_t, size_t>> erasepairs(BlockScratch::Get());
 				for (const size_t smpnum : eventsToErase)
 				{
 					const Vector<SharedPtr<IEvent>>& smpevts = static_cast<const DrumHitSynth*>(this)->GetEvents(smpnum);
@@ -598,8 +596,8 @@ namespace json2wav
 
 			for (SharedPtr<FiltType> filt : filts)
 			{
-				Vector<size_t> filtevents = filt->GetEventKeysInRange(smpstart, smpend);
-				Vector<std::pair<size_t, size_t>> erasepairs;
+				const ScratchVector<size_t> filtevents = filt->GetEventKeysInRange(smpstart, smpend);
+				ScratchVector<std::pair<size_t, size_t>> erasepairs(BlockScratch::Get());
 				for (const size_t smpnum : filtevents)
 				{
 					const Vector<SharedPtr<IEvent>>& smpevts = static_cast<const FiltType&>(*filt).GetEvents(smpnum);
@@ -711,7 +709,56 @@ namespace json2wav
 			}
 		}
 
+		/** Does what numSamples calls to IncrementPhases would, in closed form */
+		void SkipPhases(const size_t numSamples)
+		{
+			const double n = static_cast<double>(numSamples);
+			for (size_t order = 0; order < DrumHit::NumOrders; ++order)
+			{
+				for (size_t zero = 0; zero < DrumHit::NumZeroes; ++zero)
+				{
+					const double nextphase = phases[order][zero] + n * dphases[order][zero];
+					phases[order][zero] = nextphase - std::floor(nextphase);
+				}
+			}
+		}
+
+		/** Does what numSamples calls to IncrementAmps would, in closed form */
+		void SkipAmps(const size_t numSamples)
+		{
+			const double n = static_cast<double>(numSamples);
+			for (size_t order = 0; order < DrumHit::NumOrders; ++order)
+				for (size_t zero = 0; zero < DrumHit::NumZeroes; ++zero)
+					amps[order][zero] *= static_cast<float>(std::pow(static_cast<double>(modecay[order][zero]), n));
+		}
+
 	private:
+		virtual bool SkipSamples(const size_t numSamples, const double deltaTime) noexcept override
+		{
+			ProcessEventSpans(numSamples, [this, deltaTime](const size_t start, size_t count)
+				{
+					for ( ; count > 0 && (IsRamping() || hitRamp.IsActive() || angRamp.IsActive() || micRamp.IsActive()); --count)
+					{
+						const bool bIncAmp = IncrementHit(deltaTime);
+						Increment(deltaTime);
+						if (bIncAmp)
+							OnHitChange();
+						if (Utility::FloatAbsGreaterEqual(GetAmplitude(), 0.0001f))
+						{
+							IncrementPhases(deltaTime);
+							IncrementAmps(deltaTime);
+						}
+					}
+					IncrementSteady(count);
+					if (count > 0 && Utility::FloatAbsGreaterEqual(GetAmplitude(), 0.0001f))
+					{
+						SkipPhases(count);
+						SkipAmps(count);
+					}
+				});
+			return true;
+		}
+
 		virtual void OnFrequencyChange(const float basefreq, const double deltaTime) override
 		{
 			for (size_t order = 0; order < DrumHit::NumOrders; ++order)
@@ -754,7 +801,9 @@ namespace json2wav
 		Vector<InfiniSaw::JumpMetadata> jumps;
 		EInfiniSawPrecision ePrecision;
 
+		RNGShared<float> rng; // Per hit; seeded while the song is built so hits don't depend on render order
 		std::uniform_real_distribution<float> rdist;
+		std::uniform_real_distribution<float> thdist;
 
 		float strenToAmp;
 		double transientTime;
@@ -225,6 +225,7 @@ namespace json2wav
 				} break;
 			case 0: break;
 			}
+			bDirty = false;
 		}
 
 	private:
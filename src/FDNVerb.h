@@ -7,14 +7,21 @@
 #include "Utility.h"
 #include "Memory.h"
 #include "AirFilter.h"
+#include "Random.h"
 #include <random>
 #include <type_traits>
+#include <bit>
 #include <cmath>
+#include <cstdint>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 namespace json2wav
 {
 	template<size_t n, typename T>
-	inline math::matrix::SquareMatrix<n, T> GenRandomOrthonormalBasis()
+	inline math::matrix::SquareMatrix<n, T> GenRandomOrthonormalBasis(const Seed& seed = RandomSeed())
 	{
 		using namespace math::matrix;
 
@@ -22,9 +29,8 @@ namespace json2wav
 		SquareMatrix<n, T> basis;
 
 		// Initialize normal distribution to generate uniform random unit vectors in any number of dimensions
-		std::random_device rd;
 		static constexpr const bool bmt64 = sizeof(T) > 4;
-		std::conditional_t<bmt64, std::mt19937_64, std::mt19937> mt(rd());
+		std::conditional_t<bmt64, std::mt19937_64, std::mt19937> mt(seed.Seq());
 		std::normal_distribution<T> dist(static_cast<T>(0));
 
 		// Generate uniform random unit vectors, orthonormalizing along the way
@@ -92,12 +98,11 @@ namespace json2wav
 	}
 
 	template<size_t n>
-	inline math::matrix::ShuffleMatrix<n> GenRandomShuffleMatrix()
+	inline math::matrix::ShuffleMatrix<n> GenRandomShuffleMatrix(const Seed& seed = RandomSeed())
 	{
 		// Initialize RNG
-		std::random_device rd;
 		static constexpr const bool bmt64 = sizeof(size_t) > 4;
-		std::conditional_t<bmt64, std::mt19937_64, std::mt19937> mt(rd());
+		std::conditional_t<bmt64, std::mt19937_64, std::mt19937> mt(seed.Seq());
 		using float_t = std::conditional_t<bmt64, double, float>;
 		std::uniform_real_distribution<float_t> dist((float_t)0, (float_t)1);
 		size_t shuffle[n];
@@ -119,11 +124,161 @@ namespace json2wav
 		return m;
 	}
 
+	namespace fdn
+	{
+		static constexpr const size_t numLines = 8;
+
+		/** One sample of each line, aligned to load into one 256-bit register */
+		struct alignas(32) Frame
+		{
+			float lane[numLines] = {};
+		};
+
+		/** Where each lane of a ShuffleMatrix<8> product comes from, and the sign bit to flip on it */
+		struct alignas(32) Permutation
+		{
+			explicit Permutation(const math::matrix::ShuffleMatrix<numLines>& shufmtx)
+			{
+				for (size_t v = 0; v < numLines; ++v)
+				{
+					source[v] = static_cast<int32_t>(shufmtx.GetSource(v));
+					signs[v] = shufmtx.IsInverted(v) ? 0x80000000u : 0u;
+				}
+			}
+
+			int32_t source[numLines];
+			uint32_t signs[numLines];
+		};
+
+#ifdef __AVX2__
+		using Lanes = __m256;
+		inline Lanes Load(const Frame& frame) noexcept { return _mm256_load_ps(frame.lane); }
+		inline void Store(Frame& frame, const Lanes x) noexcept { _mm256_store_ps(frame.lane, x); }
+		inline Lanes Splat(const float x) noexcept { return _mm256_set1_ps(x); }
+		inline Lanes Add(const Lanes x, const Lanes y) noexcept { return _mm256_add_ps(x, y); }
+		inline Lanes Sub(const Lanes x, const Lanes y) noexcept { return _mm256_sub_ps(x, y); }
+		inline Lanes Mul(const Lanes x, const Lanes y) noexcept { return _mm256_mul_ps(x, y); }
+
+		inline Lanes Permute(const Lanes x, const Permutation& perm) noexcept
+		{
+			const Lanes shuffled = _mm256_permutevar8x32_ps(x, _mm256_load_si256(reinterpret_cast<const __m256i*>(perm.source)));
+			return _mm256_xor_ps(shuffled, _mm256_castsi256_ps(_mm256_load_si256(reinterpret_cast<const __m256i*>(perm.signs))));
+		}
+
+		/**
+		 * HadamardMatrix<8> as three butterflies pairing lanes 1, 2 and 4 apart, without leaving the register. The
+		 * sums nest the same way as HadamardMatrix<8>::op's, so the results are the same.
+		 */
+		inline Lanes Hadamard(const Lanes x) noexcept
+		{
+			Lanes pair = _mm256_permute_ps(x, 0xB1);
+			Lanes y = _mm256_blend_ps(_mm256_add_ps(x, pair), _mm256_sub_ps(pair, x), 0xAA);
+			pair = _mm256_permute_ps(y, 0x4E);
+			y = _mm256_blend_ps(_mm256_add_ps(y, pair), _mm256_sub_ps(pair, y), 0xCC);
+			pair = _mm256_permute2f128_ps(y, y, 0x01);
+			return _mm256_blend_ps(_mm256_add_ps(y, pair), _mm256_sub_ps(pair, y), 0xF0);
+		}
+#else
+		using Lanes = Frame;
+		inline Lanes Load(const Frame& frame) noexcept { return frame; }
+		inline void Store(Frame& frame, const Lanes& x) noexcept { frame = x; }
+		inline Lanes Splat(const float x) noexcept
+		{
+			Lanes r;
+			for (size_t v = 0; v < numLines; ++v)
+				r.lane[v] = x;
+			return r;
+		}
+#define ALBUMBOT_FDN_LANEWISE(Name, op) \
+		inline Lanes Name(const Lanes& x, const Lanes& y) noexcept \
+		{ \
+			Lanes r; \
+			for (size_t v = 0; v < numLines; ++v) \
+				r.lane[v] = x.lane[v] op y.lane[v]; \
+			return r; \
+		}
+		ALBUMBOT_FDN_LANEWISE(Add, +)
+		ALBUMBOT_FDN_LANEWISE(Sub, -)
+		ALBUMBOT_FDN_LANEWISE(Mul, *)
+#undef ALBUMBOT_FDN_LANEWISE
+
+		inline Lanes Permute(const Lanes& x, const Permutation& perm) noexcept
+		{
+			Lanes r;
+			for (size_t v = 0; v < numLines; ++v)
+				r.lane[v] = perm.signs[v] ? -x.lane[perm.source[v]] : x.lane[perm.source[v]];
+			return r;
+		}
+
+		inline Lanes Hadamard(const Lanes& x) noexcept
+		{
+			math::matrix::VerticalVector<numLines, float> vec;
+			for (size_t v = 0; v < numLines; ++v)
+				vec[v] = x.lane[v];
+			vec = math::matrix::HadamardMatrix<numLines>::array_multiply(vec);
+			Lanes r;
+			for (size_t v = 0; v < numLines; ++v)
+				r.lane[v] = vec[v];
+			return r;
+		}
+#endif
+
+		/** Biquad coefficients for every lane, loaded once per block */
+		struct BiquadLanes
+		{
+			Lanes b0, b1, b2, a1, a2;
+		};
+
+		/** One step of a transposed direct form II biquad on every lane */
+		inline Lanes BiquadStep(const Lanes x, const BiquadLanes& c, Lanes& s1, Lanes& s2) noexcept
+		{
+			const Lanes y = Add(Mul(c.b0, x), s1);
+			s1 = Add(Sub(Mul(c.b1, x), Mul(c.a1, y)), s2);
+			s2 = Sub(Mul(c.b2, x), Mul(c.a2, y));
+			return y;
+		}
+
+		/**
+		 * Every line's delay in one interleaved ring of frames, a power of two long so positions wrap with a mask. Lines
+		 * are written together and read back each at its own delay.
+		 */
+		class Ring
+		{
+		public:
+			void Resize(const size_t maxDelay)
+			{
+				frames.assign(std::bit_ceil(maxDelay + 1), Frame());
+				mask = frames.size() - 1;
+				pos = 0;
+			}
+
+			/** Each lane v of the frame written delays[v] writes ago, for delays from 1 up to the ring's maxDelay */
+			Frame Read(const size_t (&delays)[numLines]) const noexcept
+			{
+				Frame delayed;
+				for (size_t v = 0; v < numLines; ++v)
+					delayed.lane[v] = frames[(pos - delays[v]) & mask].lane[v];
+				return delayed;
+			}
+
+			void Write(const Frame& frame) noexcept
+			{
+				frames[pos & mask] = frame;
+				++pos;
+			}
+
+		private:
+			Vector<Frame> frames;
+			size_t mask = 0;
+			size_t pos = 0;
+		};
+	}
+
 	template<bool bOwner = false>
 	class FDNVerb : public AudioSum<bOwner>
 	{
 	public:
-		FDNVerb(const double rt60Init) : numInputChannels(0), numOutputChannels(2), rt60(rt60Init) {}
+		FDNVerb(const double rt60Init) : numInputChannels(0), numOutputChannels(2), rt60(rt60Init), seed(RandomSeed()) {}
 
 		virtual void GetSamples(
 			Sample* const* const bufs,
@@ -143,9 +298,11 @@ namespace json2wav
 				if (numOutputChannels > numChannels)
 					numOutputChannels = numChannels;
 
+				// Channels are built on first render, so they take their randomness from the seed drawn at construction
+				std::mt19937_64 seeder(seed.Seq());
 				chs.reserve(numOutputChannels);
 				for (size_t i = 0; i < numOutputChannels; ++i)
-					chs.emplace_back(rt60);
+					chs.emplace_back(rt60, seeder);
 			}
 
 			if (this->GetInputSamples(bufs, numInputChannels, bufSize, sampleRate) != AudioSum<bOwner>::EGetInputSamplesResult::SamplesWritten)
@@ -156,6 +313,10 @@ namespace json2wav
 					for (size_t i = 0; i < bufSize; ++i)
 						bufs[ch][i] = bufs[ch - numInputChannels][i];
 
+			// Empty lines read back silence wherever their rings are
+			if (this->SkipAtRest(bufs, numOutputChannels, bufSize))
+				return;
+
 			for (size_t ch = 0; ch < numOutputChannels; ++ch)
 				chs[ch].Process(bufs[ch], bufSize, sampleRate);
 		}
@@ -165,6 +326,14 @@ namespace json2wav
 			return numOutputChannels;
 		}
 
+		/** The feedback network takes rt60 to fall 60 dB, so 1.6 rt60 to fall 96, after the diffusers' worst-case delay */
+		virtual size_t GetTailSamples(const unsigned long sampleRate) const noexcept override
+		{
+			static constexpr const size_t MaxDiffusionSamples = 2*4410 + 3*8820;
+			const size_t decaySamples = static_cast<size_t>(std::ceil(rt60 * (96.0/60.0) * static_cast<double>(sampleRate)));
+			return this->AddTails(AudioSum<bOwner>::GetTailSamples(sampleRate), MaxDiffusionSamples + decaySamples);
+		}
+
 		void SetParams(const size_t numOutChs)
 		{
 			numOutputChannels = numOutChs;
@@ -177,12 +346,12 @@ namespace json2wav
 			class Diffuser
 			{
 			public:
-				Diffuser(const size_t randomDelayMin, const size_t randomDelayMax, const double rt60, const unsigned long sr = 44100)
-					: shufmtx(GenRandomShuffleMatrix<8>())
+				Diffuser(const size_t randomDelayMin, const size_t randomDelayMax, const double rt60, std::mt19937_64& seeder,
+					const unsigned long sr = 44100)
+					: shuffle(GenRandomShuffleMatrix<8>(SplitSeed(seeder)))
 				{
-					std::random_device rd;
 					static constexpr const bool bmt64 = sizeof(size_t) > 4;
-					std::conditional_t<bmt64, std::mt19937_64, std::mt19937> mt(rd());
+					std::conditional_t<bmt64, std::mt19937_64, std::mt19937> mt(SplitSeed(seeder).Seq());
 
 					const size_t randomDelayRange = randomDelayMax - randomDelayMin;
 					const size_t rangeLimits[9] = {
@@ -208,25 +377,19 @@ namespace json2wav
 					};
 					for (size_t v = 0; v < 8; ++v)
 						delays[v] = dists[v](mt);
-					const size_t maxdly = delays[7];
-
-					tmpbufs.resize(maxdly);
-					dlybufs.resize(maxdly);
-					for (size_t i = 0; i < maxdly; ++i)
-						for (size_t v = 0; v < 8; ++v)
-							dlybufs[i][v] = 0;
+					ring.Resize(delays[7]);
 					const double dt = 1.0/double(sr);
 					for (size_t v = 0; v < 8; ++v)
 					{
 						const double airtime = dt*double(delays[v]);
 						const airfilt::biquad filt = airfilt::get_airfilt((airtime > 0.015) ? airtime : 0.015, sr);
-						b0[v] = (float)filt.b0;
-						b1[v] = (float)filt.b1;
-						b2[v] = (float)filt.b2;
-						a1[v] = (float)filt.a1;
-						a2[v] = (float)filt.a2;
+						b0.lane[v] = (float)filt.b0;
+						b1.lane[v] = (float)filt.b1;
+						b2.lane[v] = (float)filt.b2;
+						a1.lane[v] = (float)filt.a1;
+						a2.lane[v] = (float)filt.a2;
 						const double attenuationDB = -60.0/rt60*airtime;
-						attenuation[v] = Utility::DBToGain(attenuationDB);
+						attenuation.lane[v] = static_cast<float>(Utility::DBToGain(attenuationDB));
 					}
 				}
 				Diffuser(const Diffuser&) = default;
@@ -235,209 +398,49 @@ namespace json2wav
 				Diffuser& operator=(Diffuser&&) noexcept = default;
 				~Diffuser() noexcept = default;
 
-				void Diffuse(Vector<math::matrix::VerticalVector<8, float>>& work)
+				/** Delays each line, then filters, attenuates, shuffles and spreads it, a frame at a time in registers */
+				void Diffuse(Vector<fdn::Frame>& work)
 				{
-					Delay(work);
-					Filter(work);
-					Shuffle(work);
-					Spread(work);
-				}
-
-			private:
-				void Delay(Vector<math::matrix::VerticalVector<8, float>>& work)
-				{
-					// delays = { 3, 1, 4, 7, 5, 9, 2, 6 }
-					// input = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 }
-					// input2 = { 1, 2, 3, 4, 5 }
-					// maxdly = 9
-					// dlybufs = {
-					//     { 0,  0,  0,  0,  0,  0,  0,  0,  0 },
-					//     { 0,  0,  0,  0,  0,  0,  0,  0,  0 },
-					//     { 0,  0,  0,  0,  0,  0,  0,  0,  0 },
-					//     { 0,  0,  0,  0,  0,  0,  0,  0,  0 },
-					//     { 0,  0,  0,  0,  0,  0,  0,  0,  0 },
-					//     { 0,  0,  0,  0,  0,  0,  0,  0,  0 },
-					//     { 0,  0,  0,  0,  0,  0,  0,  0,  0 },
-					//     { 0,  0,  0,  0,  0,  0,  0,  0,  0 }
-					// }
-					// tmpbufs[0] = work[16 - 9 + 0]
-					// tmpbufs[1] = work[16 - 9 + 1]
-					// ...
-					// tmpbufs[8] = work[16 - 9 + 8]
-					// tmpbufs2[0] = dlybufs[5 + 0]
-					// tmpbufs2[1] = dlybufs[5 + 1]
-					// tmpbufs2[2] = dlybufs[5 + 2]
-					// tmpbufs2[3] = dlybufs[5 + 3]
-					// tmpbufs2[4] = work[5 - 9 + 4]
-					// tmpbufs2[5] = work[5 - 9 + 5]
-					// tmpbufs2[6] = work[5 - 9 + 6]
-					// tmpbufs2[7] = work[5 - 9 + 7]
-					// tmpbufs2[8] = work[5 - 9 + 8]
-					// tmpbufs = {
-					//     { 8,  9, 10, 11, 12, 13, 14, 15, 16 },
-					//     { 8,  9, 10, 11, 12, 13, 14, 15, 16 },
-					//     { 8,  9, 10, 11, 12, 13, 14, 15, 16 },
-					//     { 8,  9, 10, 11, 12, 13, 14, 15, 16 },
-					//     { 8,  9, 10, 11, 12, 13, 14, 15, 16 },
-					//     { 8,  9, 10, 11, 12, 13, 14, 15, 16 },
-					//     { 8,  9, 10, 11, 12, 13, 14, 15, 16 },
-					//     { 8,  9, 10, 11, 12, 13, 14, 15, 16 }
-					// }
-					// tmpbufs2 = {
-					//     { 0,  0,  0,  0,  1,  2,  3,  4,  5 },
-					//     { 0,  0,  0,  0,  1,  2,  3,  4,  5 },
-					//     { 0,  0,  0,  0,  1,  2,  3,  4,  5 },
-					//     { 0,  0,  0,  0,  1,  2,  3,  4,  5 },
-					//     { 0,  0,  0,  0,  1,  2,  3,  4,  5 },
-					//     { 0,  0,  0,  0,  1,  2,  3,  4,  5 },
-					//     { 0,  0,  0,  0,  1,  2,  3,  4,  5 },
-					//     { 0,  0,  0,  0,  1,  2,  3,  4,  5 }
-					// }
-					// work[15][0] = work[15 - 3][0]
-					// work[15][1] = work[15 - 1][1]
-					// work[15][2] = work[15 - 4][2]
-					// work[15][3] = work[15 - 7][3]
-					// work[15][4] = work[15 - 5][4]
-					// work[15][5] = work[15 - 9][5]
-					// work[15][6] = work[15 - 2][6]
-					// work[15][7] = work[15 - 6][7]
-					// work[14][0] = work[14 - 3][0]
-					// ...
-					// work[14][7] = work[14 - 6][7]
-					// ...
-					// work[9][0] = work[9 - 3][0]
-					// ...
-					// work[9][7] = work[9 - 6][7]
-					// work[8][0] = work[8 - 3][0]
-					// work[8][1] = work[8 - 1][1]
-					// work[8][2] = work[8 - 4][2]
-					// work[8][3] = work[8 - 7][3]
-					// work[8][4] = work[8 - 5][4]
-					// work[8][5] = dlybufs[9 + 8 - 9][5]
-					// work[8][6] = work[8 - 2][6]
-					// work[8][7] = work[8 - 6][7]
-					// work[7][0] = work[7 - 3][0]
-					// work[7][1] = work[7 - 1][1]
-					// work[7][2] = work[7 - 4][2]
-					// work[7][3] = work[7 - 7][3]
-					// work[7][4] = work[7 - 5][4]
-					// work[7][5] = dlybufs[9 + 7 - 9][5]
-					// work[7][6] = work[7 - 2][6]
-					// work[7][7] = work[7 - 6][7]
-					// work[6][0] = work[6 - 3][0]
-					// work[6][1] = work[6 - 1][1]
-					// work[6][2] = work[6 - 4][2]
-					// work[6][3] = dlybufs[9 + 6 - 7][3]
-					// work[6][4] = work[6 - 5][4]
-					// work[6][5] = dlybufs[9 + 6 - 9][5]
-					// work[6][6] = work[6 - 2][6]
-					// work[6][7] = work[6 - 6][7]
-					// ...
-					// work[0][0] = dlybufs[9 + 0 - 3][0]
-					// work[0][1] = dlybufs[9 + 0 - 1][1]
-					// work[0][2] = dlybufs[9 + 0 - 4][2]
-					// work[0][3] = dlybufs[9 + 0 - 7][3]
-					// work[0][4] = dlybufs[9 + 0 - 5][4]
-					// work[0][5] = dlybufs[9 + 0 - 9][5]
-					// work[0][6] = dlybufs[9 + 0 - 2][6]
-					// work[0][7] = dlybufs[9 + 0 - 6][7]
-					// work = {
-					//     { 0,  0,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13 },
-					//     { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
-					//     { 0,  0,  0,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12 },
-					//     { 0,  0,  0,  0,  0,  0,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9 },
-					//     { 0,  0,  0,  0,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11 },
-					//     { 0,  0,  0,  0,  0,  0,  0,  0,  0,  1,  2,  3,  4,  5,  6,  7 },
-					//     { 0,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14 },
-					//     { 0,  0,  0,  0,  0,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10 }
-					// }
-					// work20 = {
-					//     { 0,  0,  0,  1,  2 },
-					//     { 0,  1,  2,  3,  4 },
-					//     { 0,  0,  0,  0,  1 },
-					//     { 0,  0,  0,  0,  0 },
-					//     { 0,  0,  0,  0,  0 },
-					//     { 0,  0,  0,  0,  0 },
-					//     { 0,  0,  1,  2,  3 },
-					//     { 0,  0,  0,  0,  0 }
-					// }
-					// work21 = {
-					//     { 3,  4,  5,  6,  7 },
-					//     { 5,  6,  7,  8,  9 },
-					//     { 2,  3,  4,  5,  6 },
-					//     { 0,  0,  1,  2,  3 },
-					//     { 1,  2,  3,  4,  5 },
-					//     { 0,  0,  0,  0,  1 },
-					//     { 4,  5,  6,  7,  8 },
-					//     { 0,  1,  2,  3,  4 }
-					// }
-					// dlybufs = tmpbufs
-
-					const size_t maxdly = dlybufs.size();
-					for (size_t i = 0; i < maxdly; ++i)
+					using namespace fdn;
+					const BiquadLanes filt{ Load(b0), Load(b1), Load(b2), Load(a1), Load(a2) };
+					const Lanes gain = Load(attenuation);
+					Lanes state1 = Load(s1);
+					Lanes state2 = Load(s2);
+					for (Frame& frame : work)
 					{
-						const size_t dlyidx = work.size() + i;
-						tmpbufs[i] = (dlyidx < maxdly)
-							? dlybufs[dlyidx]
-							: work[dlyidx - maxdly];
+						const Frame delayed = ring.Read(delays);
+						ring.Write(frame);
+						const Lanes filtered = BiquadStep(Load(delayed), filt, state1, state2);
+						Store(frame, Hadamard(Permute(Mul(gain, filtered), shuffle)));
 					}
-					for (size_t i = work.size(); i > 0; --i)
-						for (size_t v = 0; v < 8; ++v)
-							work[i-1][v] = (delays[v] > i-1)
-								? dlybufs[maxdly + i-1 - delays[v]][v]
-								: work[i-1 - delays[v]][v];
-					for (size_t i = 0; i < maxdly; ++i)
-						dlybufs[i] = tmpbufs[i];
-				}
-
-				void Filter(Vector<math::matrix::VerticalVector<8, float>>& work)
-				{
-					for (auto& frame : work)
-					{
-						auto output = b0*frame + s1;
-						s1 = b1*frame - a1*output + s2;
-						s2 = b2*frame - a2*output;
-						frame = attenuation*output;
-					}
-				}
-
-				void Shuffle(Vector<math::matrix::VerticalVector<8, float>>& work)
-				{
-					for (auto& frame : work)
-						frame = shufmtx*frame;
-				}
-
-				void Spread(Vector<math::matrix::VerticalVector<8, float>>& work)
-				{
-					static const math::matrix::HadamardMatrix<8> hadmtx;
-					for (auto& frame : work)
-						frame = (hadmtx*frame);
+					Store(s1, state1);
+					Store(s2, state2);
 				}
 
 			private:
 				size_t delays[8];
-				Vector<math::matrix::VerticalVector<8, float>> dlybufs;
-				Vector<math::matrix::VerticalVector<8, float>> tmpbufs;
-				math::matrix::DiagonalMatrix<8, float> b0;
-				math::matrix::DiagonalMatrix<8, float> b1;
-				math::matrix::DiagonalMatrix<8, float> b2;
-				math::matrix::DiagonalMatrix<8, float> a1;
-				math::matrix::DiagonalMatrix<8, float> a2;
-				math::matrix::VerticalVector<8, float> s1;
-				math::matrix::VerticalVector<8, float> s2;
-				math::matrix::DiagonalMatrix<8, float> attenuation;
-				math::matrix::ShuffleMatrix<8> shufmtx;
+				fdn::Ring ring;
+				fdn::Frame b0;
+				fdn::Frame b1;
+				fdn::Frame b2;
+				fdn::Frame a1;
+				fdn::Frame a2;
+				fdn::Frame s1;
+				fdn::Frame s2;
+				fdn::Frame attenuation;
+				fdn::Permutation shuffle;
 			};
 
 		public:
-			ReverbChannel(const double rt60)
-				: diffuser0(1, 4410, rt60),
-				diffuser1(1, 4410, rt60),
-				diffuser2(1, 8820, rt60),
-				diffuser3(1, 8820, rt60),
-				diffuser4(1, 8820, rt60)
+			ReverbChannel(const double rt60, std::mt19937_64& seeder)
+				: echoSeed(SplitSeed(seeder)),
+				diffuser0(1, 4410, rt60, seeder),
+				diffuser1(1, 4410, rt60, seeder),
+				diffuser2(1, 8820, rt60, seeder),
+				diffuser3(1, 8820, rt60, seeder),
+				diffuser4(1, 8820, rt60, seeder)
 			{
-				math::matrix::SquareMatrix<8, double> basis(GenRandomOrthonormalBasis<8, double>());
+				math::matrix::SquareMatrix<8, double> basis(GenRandomOrthonormalBasis<8, double>(SplitSeed(seeder)));
 				for (size_t i = 0; i < 8; ++i)
 					for (size_t j = 0; j < 8; ++j)
 						reflector[i][j] = static_cast<float>(Utility::DBToGain(-12.0/rt60)*basis[i][j]);
@@ -452,75 +455,45 @@ namespace json2wav
 			{
 				chwork.resize(bufSize);
 				for (size_t i = 0; i < bufSize; ++i)
-					for (size_t v = 0; v < 8; ++v)
-						chwork[i][v] = 0.125f*iobuf[i].AsFloat32(); // Divide voltage
+					fdn::Store(chwork[i], fdn::Splat(0.125f*iobuf[i].AsFloat32())); // Divide voltage
 				Diffuse();
 				Echo();
 				for (size_t i = 0; i < bufSize; ++i)
 				{
-					iobuf[i] = chwork[i][0];
+					iobuf[i] = chwork[i].lane[0];
 					for (size_t v = 1; v < 8; ++v)
-						iobuf[i] += chwork[i][v];
+						iobuf[i] += chwork[i].lane[v];
 				}
 			}
 
 		private:
 			void Diffuse()
 			{
+				using namespace fdn;
 				const size_t bufSize = chwork.size();
 				diffused.resize(bufSize);
 				for (size_t i = 0; i < bufSize; ++i)
-					for (size_t v = 0; v < 8; ++v)
-						diffused[i][v] = 0.0f;
-				diffuser0.Diffuse(chwork);
-				for (size_t i = 0; i < bufSize; ++i)
-					diffused[i] += chwork[i];
-				diffuser1.Diffuse(chwork);
-				for (size_t i = 0; i < bufSize; ++i)
-					diffused[i] += chwork[i];
-				diffuser2.Diffuse(chwork);
-				for (size_t i = 0; i < bufSize; ++i)
-					diffused[i] += chwork[i];
-				diffuser3.Diffuse(chwork);
-				for (size_t i = 0; i < bufSize; ++i)
-					diffused[i] += chwork[i];
+					diffused[i] = Frame();
+				Diffuser* const diffusers[] = { &diffuser0, &diffuser1, &diffuser2, &diffuser3 };
+				for (Diffuser* const diffuser : diffusers)
+				{
+					diffuser->Diffuse(chwork);
+					for (size_t i = 0; i < bufSize; ++i)
+						Store(diffused[i], Add(Load(diffused[i]), Load(chwork[i])));
+				}
 				diffuser4.Diffuse(chwork);
 				for (size_t i = 0; i < bufSize; ++i)
-					chwork[i] += diffused[i];
+					Store(chwork[i], Add(Load(chwork[i]), Load(diffused[i])));
 			}
 
+			/** Feeds the lines back through the reflector and the 200ms air filters, a frame at a time in registers */
 			void Echo()
 			{
-
-				static constexpr const float lpb0 = float(airfilt::lp200ms::b0);
-				static constexpr const float lpb1 = float(airfilt::lp200ms::b1);
-				static constexpr const float lpb2 = float(airfilt::lp200ms::b2);
-				static constexpr const float lpa1 = float(airfilt::lp200ms::a1);
-				static constexpr const float lpa2 = float(airfilt::lp200ms::a2);
-
-				static constexpr const float hsb0 = float(airfilt::hs200ms::b0);
-				static constexpr const float hsb1 = float(airfilt::hs200ms::b1);
-				static constexpr const float hsb2 = float(airfilt::hs200ms::b2);
-				static constexpr const float hsa1 = float(airfilt::hs200ms::a1);
-				static constexpr const float hsa2 = float(airfilt::hs200ms::a2);
-
-				auto airfilter200ms = [this](math::matrix::VerticalVector<8, float>& frame)
-				{
-					auto output = lpb0*frame + lps1;
-					lps1 = lpb1*frame - lpa1*output + lps2;
-					lps2 = lpb2*frame - lpa2*output;
-					frame = output;
-					output = hsb0*frame + hss1;
-					hss1 = hsb1*frame - hsa1*output + hss2;
-					hss2 = hsb2*frame - hsa2*output;
-					frame = output;
-				};
-
-				if (delaybuf.size() == 0)
+				using namespace fdn;
+				if (reflectorColumns.empty())
 				{
-					std::random_device rd;
 					static constexpr const bool bmt64 = sizeof(size_t) > 4;
-					std::conditional_t<bmt64, std::mt19937_64, std::mt19937> mt(rd());
+					std::conditional_t<bmt64, std::mt19937_64, std::mt19937> mt(echoSeed.Seq());
 					static constexpr const size_t randomDelayMin = 8820 - 88; // 198ms
 					static constexpr const size_t randomDelayMax = 8820 + 89; // 202ms
 					std::uniform_int_distribution<size_t> dist(randomDelayMin, randomDelayMax);
@@ -535,41 +508,61 @@ namespace json2wav
 						if (delays[i] > echotime)
 							echotime = delays[i];
 					}
-					delaybuf.resize(echotime);
-					for (size_t i = 0; i < echotime; ++i)
+					ring.Resize(echotime);
+
+					// Columns, so a frame's mix is eight lane-wide multiply-adds in the same order as SquareMatrix's rows
+					reflectorColumns.resize(8);
+					for (size_t k = 0; k < 8; ++k)
 						for (size_t v = 0; v < 8; ++v)
-							delaybuf[i][v] = 0;
+							reflectorColumns[k].lane[v] = reflector[v][k];
 				}
 
-				for (size_t i = 0; i < chwork.size(); ++i)
+				const BiquadLanes lp{
+					Splat(float(airfilt::lp200ms::b0)), Splat(float(airfilt::lp200ms::b1)), Splat(float(airfilt::lp200ms::b2)),
+					Splat(float(airfilt::lp200ms::a1)), Splat(float(airfilt::lp200ms::a2)) };
+				const BiquadLanes hs{
+					Splat(float(airfilt::hs200ms::b0)), Splat(float(airfilt::hs200ms::b1)), Splat(float(airfilt::hs200ms::b2)),
+					Splat(float(airfilt::hs200ms::a1)), Splat(float(airfilt::hs200ms::a2)) };
+				Lanes columns[8];
+				for (size_t k = 0; k < 8; ++k)
+					columns[k] = Load(reflectorColumns[k]);
+				Lanes lpState1 = Load(lps1), lpState2 = Load(lps2);
+				Lanes hsState1 = Load(hss1), hsState2 = Load(hss2);
+
+				for (Frame& frame : chwork)
 				{
-					math::matrix::VerticalVector<8, float> frame;
-					for (size_t v = 0; v < 8; ++v)
-						frame[v] = (i < delays[v]) ? delaybuf[delaybuf.size() + i - delays[v]][v] : chwork[i - delays[v]][v];
-					frame = reflector*frame;
-					airfilter200ms(frame);
-					chwork[i] += frame;
-				}
-				for (size_t i = 0; i < delaybuf.size(); ++i)
-				{
-					delaybuf[i] = (chwork.size() + i < delaybuf.size()) ? delaybuf[chwork.size() + i] : chwork[chwork.size() + i - delaybuf.size()];
+					const Frame delayed = ring.Read(delays);
+					Lanes echo = Mul(columns[0], Splat(delayed.lane[0]));
+					for (size_t k = 1; k < 8; ++k)
+						echo = Add(echo, Mul(columns[k], Splat(delayed.lane[k])));
+					echo = BiquadStep(echo, lp, lpState1, lpState2);
+					echo = BiquadStep(echo, hs, hsState1, hsState2);
+					Store(frame, Add(Load(frame), echo));
+					ring.Write(frame);
 				}
+
+				Store(lps1, lpState1);
+				Store(lps2, lpState2);
+				Store(hss1, hsState1);
+				Store(hss2, hsState2);
 			}
 
 		private:
 			size_t delays[8];
-			Vector<math::matrix::VerticalVector<8, float>> chwork;
-			Vector<math::matrix::VerticalVector<8, float>> diffused;
-			Vector<math::matrix::VerticalVector<8, float>> delaybuf;
+			Vector<fdn::Frame> chwork;
+			Vector<fdn::Frame> diffused;
+			fdn::Ring ring;
+			Vector<fdn::Frame> reflectorColumns;
+			Seed echoSeed;
 			Diffuser diffuser0;
 			Diffuser diffuser1;
 			Diffuser diffuser2;
 			Diffuser diffuser3;
 			Diffuser diffuser4;
-			math::matrix::VerticalVector<8, float> lps1;
-			math::matrix::VerticalVector<8, float> lps2;
-			math::matrix::VerticalVector<8, float> hss1;
-			math::matrix::VerticalVector<8, float> hss2;
+			fdn::Frame lps1;
+			fdn::Frame lps2;
+			fdn::Frame hss1;
+			fdn::Frame hss2;
 			math::matrix::SquareMatrix<8, float> reflector;
 		};
 
@@ -577,6 +570,7 @@ namespace json2wav
 		size_t numInputChannels;
 		size_t numOutputChannels;
 		double rt60;
+		Seed seed;
 		Vector<ReverbChannel> chs;
 	};
 }
@@ -3,7 +3,12 @@
 #pragma once
 
 #include "IAudioObject.h"
+#include "IControlObject.h"
 #include "Ramp.h"
+#include "FastExp2.h"
+#include "SampleKernels.h"
+#include <algorithm>
+#include <span>
 #include <cmath>
 
 namespace json2wav
@@ -28,6 +33,9 @@ namespace json2wav
 	class Fader : public AudioSum<bOwner>, public ControlObject<FaderEvent<bOwner>>
 	{
 	public:
+		/** Ramps are stepped this many samples at a time */
+		static constexpr const size_t rampChunk = 64;
+
 		Fader(const float gainDBInit = 0.0f) : lastNumChannels(2), gainDB(gainDBInit) {}
 
 		virtual void GetSamples(
@@ -48,12 +56,32 @@ namespace json2wav
 				return;
 			}
 
-			this->ProcessEvents(numSamples, [this, bufs, numChannels, deltaTime](const size_t i)
+			ApplyInPlace(bufs, numChannels, numSamples, deltaTime);
+		}
+
+		/** Applies the fader to samples already in bufs, running its events; also used by chains that absorb it */
+		void ApplyInPlace(Sample* const* const bufs, const size_t numChannels, const size_t numSamples, const double deltaTime) noexcept
+		{
+			this->ProcessEventSpans(numSamples, [this, bufs, numChannels, deltaTime](const size_t start, const size_t count)
 				{
-					gainDBRamp.Increment(gainDB, deltaTime);
-					const float gainfactor = this->GetGainFactor();
-					for (uint_fast8_t ch = 0; ch < numChannels; ++ch)
-						bufs[ch][i] *= gainfactor;
+					float gains[rampChunk];
+					for (size_t i = start, end = start + count; i < end; )
+					{
+						if (!IsRamping())
+						{
+							// Nothing moves the gain until the next event
+							const float gain = GetGainFactor();
+							for (size_t ch = 0; ch < numChannels; ++ch)
+								kernel::Gain(AsSpan(bufs[ch] + i, end - i), gain);
+							return;
+						}
+
+						const size_t chunk = std::min(rampChunk, end - i);
+						StepGainFactors(deltaTime, gains, chunk);
+						for (size_t ch = 0; ch < numChannels; ++ch)
+							kernel::Gain(AsSpan(bufs[ch] + i, chunk), std::span<const float>(gains, chunk));
+						i += chunk;
+					}
 				});
 		}
 
@@ -78,6 +106,25 @@ namespace json2wav
 			return std::pow(10.0f, gainDB * over20);
 		}
 
+		/** Advances the gain ramp count samples, writing the gain for each; a ramp runs in dB and converts all at once */
+		void StepGainFactors(const double deltaTime, float* const gains, const size_t count) noexcept
+		{
+			if (!IsRamping())
+			{
+				std::fill_n(gains, count, GetGainFactor());
+				return;
+			}
+
+			gainDBRamp.IncrementBlock(gainDB, deltaTime, gains, count);
+			kernel::DBToGain(std::span<float>(gains, count));
+		}
+
+		/** While false, the gain stays GetGainFactor until the next event */
+		bool IsRamping() const noexcept
+		{
+			return gainDBRamp.IsActive();
+		}
+
 	private:
 		size_t lastNumChannels;
 		float gainDB;
@@ -0,0 +1,43 @@
+// Copyright Dan Price 2026.
+
+#pragma once
+
+#include <bit>
+#include <cstdint>
+
+namespace json2wav
+{
+	/**
+	 * 2^x in float: x rounded to an integer goes straight into the exponent bits and a degree-5 minimax polynomial covers
+	 * the remaining [-0.5, 0.5]. Relative error stays under 2.5e-7 (about -132 dB) for x in [-126, 127], which x is clamped
+	 * to. It rounds and clamps with integer and bias tricks rather than float compares and casts, so loops over it
+	 * vectorize without relaxed float semantics.
+	 */
+	inline float FastExp2(const float x) noexcept
+	{
+		constexpr const int32_t hiBits = std::bit_cast<int32_t>(127.0f);
+		constexpr const int32_t loBits = std::bit_cast<int32_t>(-126.0f);
+		constexpr const float roundingBias = 12582912.0f; // 1.5*2^23: adding it rounds to an integer held in the low bits
+
+		// Float bits order like integers among positives and backwards among negatives
+		const int32_t bits = std::bit_cast<int32_t>(x);
+		const int32_t clampedBits = (bits < 0) ? ((bits > loBits) ? loBits : bits) : ((bits > hiBits) ? hiBits : bits);
+		const float clamped = std::bit_cast<float>(clampedBits);
+
+		const float biased = clamped + roundingBias;
+		const int32_t n = static_cast<int32_t>(std::bit_cast<uint32_t>(biased) - std::bit_cast<uint32_t>(roundingBias));
+		const float f = clamped - (biased - roundingBias);
+
+		const float p = 1.0000000716546822f + f*(0.6931469670647331f + f*(0.24022119723848476f
+			+ f*(0.05550713273542586f + f*(0.00967554133421605f + f*0.0013276471979478776f))));
+		const float scale = std::bit_cast<float>(static_cast<uint32_t>(n + 127) << 23);
+		return p * scale;
+	}
+
+	/** 10^(db/20) by FastExp2; rounding db's scale to log2 adds error, so it's within 1e-6 for db within +-150 */
+	inline float FastDBToGain(const float db) noexcept
+	{
+		constexpr const float log2of10over20 = 0.16609640474436813f;
+		return FastExp2(db * log2of10over20);
+	}
+}
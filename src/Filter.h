@@ -8,9 +8,14 @@
 #include "FastSin.h"
 #include "Binomial.h"
 #include "BesselPoly.h"
+#include "PolyRoots.h"
+#include "SampleKernels.h"
 #include <utility>
+#include <algorithm>
 #include <stdexcept>
 #include <string>
+#include <complex>
+#include <iterator>
 #include <cstdint>
 #include <cmath>
 
@@ -30,6 +35,9 @@
 
 #define ALBUMBOT_DELAY_TDF2 0
 
+// Ramped Laplace filters interpolate their sections from a shared table instead of transforming them every update
+#define ALBUMBOT_FILTER_COEFF_TABLE 1
+
 namespace json2wav
 {
 	enum class EFilterParam
@@ -49,6 +57,89 @@ namespace json2wav::Filter
 
 	template<ETopo eTopo> struct Topo;
 
+	/**
+	 * Runs numSections second-order sections in series over count samples from start. Section k works on the sample
+	 * k steps behind section 0, so every section of every channel advances at once in its own lane instead of each
+	 * waiting on the one before. Step(x, z0, z1, a1, a2, b0, b1, b2, y, newz0, newz1) is the topology's section.
+	 */
+	template<typename FloatType, size_t numSections, size_t numch, typename StepFunc>
+	inline void CascadeBlock(
+		Sample* const* const bufs,
+		const size_t start,
+		const size_t count,
+		FloatType (&z)[numSections][numch][2],
+		const FloatType (&a)[numSections][2],
+		const FloatType (&b)[numSections][3],
+		StepFunc&& Step)
+	{
+		constexpr size_t numLanes = numSections * numch;
+		constexpr size_t lastLane = (numSections - 1) * numch;
+		float* ALBUMBOT_RESTRICT io[numch];
+		FloatType la1[numLanes], la2[numLanes], lb0[numLanes], lb1[numLanes], lb2[numLanes];
+		FloatType lz0[numLanes], lz1[numLanes], lx[numLanes];
+		for (size_t k = 0; k < numSections; ++k)
+		{
+			for (size_t ch = 0; ch < numch; ++ch)
+			{
+				const size_t l = k * numch + ch;
+				la1[l] = a[k][0];
+				la2[l] = a[k][1];
+				lb0[l] = b[k][0];
+				lb1[l] = b[k][1];
+				lb2[l] = b[k][2];
+				lz0[l] = z[k][ch][0];
+				lz1[l] = z[k][ch][1];
+				lx[l] = static_cast<FloatType>(0);
+			}
+		}
+		for (size_t ch = 0; ch < numch; ++ch)
+			io[ch] = AsSpan(bufs[ch] + start, count).data();
+
+		// Lanes of sections that haven't reached the block yet, or have finished it, keep their state
+		auto RunStep = [&]<bool bMasked>(const size_t t)
+		{
+			for (size_t ch = 0; ch < numch; ++ch)
+				lx[ch] = (t < count) ? static_cast<FloatType>(io[ch][t]) : static_cast<FloatType>(0);
+			FloatType ly[numLanes], nz0[numLanes], nz1[numLanes];
+			for (size_t l = 0; l < numLanes; ++l)
+				Step(lx[l], lz0[l], lz1[l], la1[l], la2[l], lb0[l], lb1[l], lb2[l], ly[l], nz0[l], nz1[l]);
+			for (size_t l = 0; l < numLanes; ++l)
+			{
+				const size_t k = l / numch;
+				if (!bMasked || (t >= k && t - k < count))
+				{
+					lz0[l] = nz0[l];
+					lz1[l] = nz1[l];
+				}
+			}
+			if (t + 1 >= numSections)
+				for (size_t ch = 0; ch < numch; ++ch)
+					io[ch][t + 1 - numSections] = static_cast<float>(ly[lastLane + ch]);
+			// Sections pass samples on as float, as they would through the buffer one section at a time
+			for (size_t l = numLanes; l-- > numch;)
+				lx[l] = static_cast<FloatType>(static_cast<float>(ly[l - numch]));
+		};
+
+		const size_t end = count + numSections - 1;
+		const size_t fullStart = std::min(numSections - 1, end);
+		const size_t fullEnd = std::max(fullStart, count);
+		for (size_t t = 0; t < fullStart; ++t)
+			RunStep.template operator()<true>(t);
+		for (size_t t = fullStart; t < fullEnd; ++t)
+			RunStep.template operator()<false>(t);
+		for (size_t t = fullEnd; t < end; ++t)
+			RunStep.template operator()<true>(t);
+
+		for (size_t k = 0; k < numSections; ++k)
+		{
+			for (size_t ch = 0; ch < numch; ++ch)
+			{
+				z[k][ch][0] = lz0[k * numch + ch];
+				z[k][ch][1] = lz1[k * numch + ch];
+			}
+		}
+	}
+
 	template<> struct Topo<ETopo::DF2>
 	{
 		template<typename FloatType, size_t order, typename z_t, typename a_t, typename b_t, typename b1_t>
@@ -87,6 +178,83 @@ namespace json2wav::Filter
 		{
 			DoFilterGeneric<FloatType, order>(inoutsmp, z, a, b, b1);
 		}
+
+		/** Filters count samples from start on every channel with fixed coefficients, one channel per SIMD lane */
+		template<typename FloatType, size_t order, size_t numch>
+		static void DoFilterBlock(
+			Sample* const* const bufs,
+			const size_t start,
+			const size_t count,
+			FloatType (&z)[numch][order],
+			const FloatType (&a)[order],
+			const FloatType (&b)[order + 1],
+			FloatType (&b1)[numch][order + 1])
+		{
+			float* ALBUMBOT_RESTRICT io[numch];
+			FloatType zl[order][numch];
+			for (size_t ch = 0; ch < numch; ++ch)
+			{
+				io[ch] = AsSpan(bufs[ch] + start, count).data();
+				for (size_t j = 0; j < order; ++j)
+					zl[j][ch] = z[ch][j];
+			}
+			for (size_t i = 0; i < count; ++i)
+			{
+				FloatType smp[numch];
+				FloatType mid[numch];
+				for (size_t ch = 0; ch < numch; ++ch)
+					smp[ch] = io[ch][i];
+				for (size_t j = 0; j < order; ++j)
+					for (size_t ch = 0; ch < numch; ++ch)
+						smp[ch] -= a[j] * zl[j][ch];
+				for (size_t ch = 0; ch < numch; ++ch)
+				{
+					mid[ch] = smp[ch];
+					smp[ch] = b[0] * smp[ch];
+				}
+				for (size_t j = 0; j < order; ++j)
+					for (size_t ch = 0; ch < numch; ++ch)
+						smp[ch] += b[j + 1] * zl[j][ch];
+				for (size_t j = 1; j < order; ++j)
+					for (size_t ch = 0; ch < numch; ++ch)
+						zl[order - j][ch] = zl[order - j - 1][ch];
+				for (size_t ch = 0; ch < numch; ++ch)
+				{
+					zl[0][ch] = mid[ch];
+					io[ch][i] = static_cast<float>(smp[ch]);
+				}
+			}
+			for (size_t ch = 0; ch < numch; ++ch)
+				for (size_t j = 0; j < order; ++j)
+					z[ch][j] = zl[j][ch];
+		}
+
+		/** Filters count samples from start through numSections biquads in series; see CascadeBlock */
+		template<typename FloatType, size_t numSections, size_t numch>
+		static void DoCascadeBlock(
+			Sample* const* const bufs,
+			const size_t start,
+			const size_t count,
+			FloatType (&z)[numSections][numch][2],
+			const FloatType (&a)[numSections][2],
+			const FloatType (&b)[numSections][3],
+			FloatType (&b1)[numSections][numch][3])
+		{
+			CascadeBlock<FloatType, numSections, numch>(bufs, start, count, z, a, b,
+				[](const FloatType x, const FloatType z0, const FloatType z1, const FloatType a1, const FloatType a2,
+					const FloatType b0, const FloatType bz1, const FloatType b2, FloatType& y, FloatType& newz0, FloatType& newz1)
+				{
+					FloatType smp = x;
+					smp -= a1 * z0;
+					smp -= a2 * z1;
+					newz0 = smp;
+					newz1 = z0;
+					smp = b0 * smp;
+					smp += bz1 * z0;
+					smp += b2 * z1;
+					y = smp;
+				});
+		}
 	};
 
 	template<> struct Topo<ETopo::TDF2>
@@ -134,6 +302,81 @@ namespace json2wav::Filter
 		{
 			DoFilterGeneric<FloatType, order>(inoutsmp, z, a, b, b1);
 		}
+
+		/** Filters count samples from start on every channel with fixed coefficients, one channel per SIMD lane */
+		template<typename FloatType, size_t order, size_t numch>
+		static void DoFilterBlock(
+			Sample* const* const bufs,
+			const size_t start,
+			const size_t count,
+			FloatType (&z)[numch][order],
+			const FloatType (&a)[order],
+			const FloatType (&b)[order + 1],
+			FloatType (&b1)[numch][order + 1])
+		{
+#if ALBUMBOT_DELAY_TDF2
+			// Delayed coefficients differ from b for a sample after every recalc, so keep to the per-sample path
+			for (size_t i = start; i < start + count; ++i)
+				for (size_t ch = 0; ch < numch; ++ch)
+					DoFilter<FloatType, order>(bufs[ch][i], z[ch], a, b, b1[ch]);
+#else
+			float* ALBUMBOT_RESTRICT io[numch];
+			FloatType zl[order][numch];
+			for (size_t ch = 0; ch < numch; ++ch)
+			{
+				io[ch] = AsSpan(bufs[ch] + start, count).data();
+				for (size_t j = 0; j < order; ++j)
+					zl[j][ch] = z[ch][j];
+			}
+			for (size_t i = 0; i < count; ++i)
+			{
+				FloatType smpin[numch];
+				FloatType smpout[numch];
+				for (size_t ch = 0; ch < numch; ++ch)
+				{
+					smpin[ch] = io[ch][i];
+					smpout[ch] = smpin[ch] * b[0] + zl[0][ch];
+				}
+				for (size_t j = 0; j + 1 < order; ++j)
+					for (size_t ch = 0; ch < numch; ++ch)
+						zl[j][ch] = smpin[ch] * b[j + 1] - smpout[ch] * a[j] + zl[j + 1][ch];
+				for (size_t ch = 0; ch < numch; ++ch)
+				{
+					zl[order - 1][ch] = smpin[ch] * b[order] - smpout[ch] * a[order - 1];
+					io[ch][i] = static_cast<float>(smpout[ch]);
+				}
+			}
+			for (size_t ch = 0; ch < numch; ++ch)
+				for (size_t j = 0; j < order; ++j)
+					z[ch][j] = zl[j][ch];
+#endif
+		}
+
+		/** Filters count samples from start through numSections biquads in series; see CascadeBlock */
+		template<typename FloatType, size_t numSections, size_t numch>
+		static void DoCascadeBlock(
+			Sample* const* const bufs,
+			const size_t start,
+			const size_t count,
+			FloatType (&z)[numSections][numch][2],
+			const FloatType (&a)[numSections][2],
+			const FloatType (&b)[numSections][3],
+			FloatType (&b1)[numSections][numch][3])
+		{
+#if ALBUMBOT_DELAY_TDF2
+			for (size_t k = 0; k < numSections; ++k)
+				DoFilterBlock<FloatType, 2, numch>(bufs, start, count, z[k], a[k], b[k], b1[k]);
+#else
+			CascadeBlock<FloatType, numSections, numch>(bufs, start, count, z, a, b,
+				[](const FloatType x, const FloatType z0, const FloatType z1, const FloatType a1, const FloatType a2,
+					const FloatType b0, const FloatType bz1, const FloatType b2, FloatType& y, FloatType& newz0, FloatType& newz1)
+				{
+					y = x * b0 + z0;
+					newz0 = x * bz1 - y * a1 + z1;
+					newz1 = x * b2 - y * a2;
+				});
+#endif
+		}
 	};
 
 	template<uint_fast8_t order, typename FloatType, typename FreqType, typename LaplaceType>
@@ -210,8 +453,12 @@ namespace json2wav::Filter
 		FilterState()
 		{
 			for (uint_fast8_t ch = 0; ch < numch; ++ch)
+			{
+				for (uint_fast8_t i = 0; i < order; ++i)
+					z[ch][i] = 0.0f;
 				for (uint_fast8_t i = 0; i < order + 1; ++i)
 					b1[ch][i] = 0.0f;
+			}
 		}
 		FilterState(const FilterState&) = default;
 		FilterState& operator=(const FilterState&) = default;
@@ -255,8 +502,8 @@ namespace json2wav::Filter
 	class FilterBase : public AudioSum<bOwner>, public ControlObject<FilterEvent<bOwner>>
 	{
 	protected:
-		explicit FilterBase(const float freq_init, const float res_init, const float gainDB_init)
-			: freq(freq_init), res(res_init), gainDB(gainDB_init)
+		explicit FilterBase(const float freq_init, const float res_init, const float gainDB_init, const uint_fast16_t controlUpdate_init = 1)
+			: controlUpdateInterval(controlUpdate_init), controlUpdateCounter(1), freq(freq_init), res(res_init), gainDB(gainDB_init)
 		{
 		}
 
@@ -307,6 +554,11 @@ namespace json2wav::Filter
 		}
 
 	protected:
+		bool IsRamping() const noexcept
+		{
+			return freqRamp.IsActive() || resRamp.IsActive() || gainDBRamp.IsActive();
+		}
+
 		bool IncrementRamps(const double deltaTime)
 		{
 			const bool freqIncred = freqRamp.Increment(freq, deltaTime);
@@ -315,7 +567,71 @@ namespace json2wav::Filter
 			return freqIncred || resIncred || gainDBIncred;
 		}
 
+		/**
+		 * Hands FilterBlock(start, count) each run of samples between events and control updates, calling Recalc()
+		 * whenever a control update moves a ramp
+		 */
+		template<typename RecalcFunc, typename FilterBlockFunc>
+		void FilterSpans(const size_t numSamples, const double deltaTime, RecalcFunc&& Recalc, FilterBlockFunc&& FilterBlock)
+		{
+			this->ProcessEventSpans(numSamples, [this, deltaTime, &Recalc, &FilterBlock](const size_t start, const size_t count)
+				{
+					// Without a ramp, control updates in this span would only cycle the counter
+					const size_t interval = std::max<size_t>(controlUpdateInterval, 1);
+					if (!IsRamping())
+					{
+						const size_t counter = std::min<size_t>(controlUpdateCounter, interval);
+						controlUpdateCounter = static_cast<uint_fast16_t>((counter - 1 + count) % interval + 1);
+						FilterBlock(start, count);
+						return;
+					}
+
+					// Otherwise filter each run of samples between control updates at once
+					for (size_t i = start, end = start + count; i < end;)
+					{
+						size_t numRun;
+						if (controlUpdateCounter >= controlUpdateInterval)
+						{
+							if (IncrementRamps(deltaTime * controlUpdateInterval))
+							{
+								Recalc();
+							}
+							numRun = std::min(end - i, interval);
+							controlUpdateCounter = static_cast<uint_fast16_t>(numRun);
+						}
+						else
+						{
+							numRun = std::min<size_t>(end - i, controlUpdateInterval - controlUpdateCounter);
+							controlUpdateCounter = static_cast<uint_fast16_t>(controlUpdateCounter + numRun);
+						}
+						FilterBlock(i, numRun);
+						i += numRun;
+					}
+				});
+		}
+
+		/**
+		 * While FastForward is active and the input is silent, moves events and ramps on as FilterSpans would but
+		 * filters nothing, recalculating once at the end instead of at every control update. The caller then clears its
+		 * state, dropping any tail still ringing as fast-forwarded synths drop theirs. Returns false, having done
+		 * nothing, when there is sound to filter.
+		 */
+		template<typename RecalcFunc>
+		bool SkipSilence(const Sample* const* const bufs, const size_t numChannels, const size_t numSamples, const double deltaTime, RecalcFunc&& Recalc)
+		{
+			if (!this->IsFastForwardingSilence(bufs, numChannels, numSamples))
+				return false;
+
+			bool bMoved = false;
+			FilterSpans(numSamples, deltaTime, [&bMoved]() { bMoved = true; }, [](const size_t, const size_t) {});
+			if (bMoved)
+				Recalc();
+			return true;
+		}
+
 	private:
+		uint_fast16_t controlUpdateInterval;
+		uint_fast16_t controlUpdateCounter;
 		float freq;
 		float res;
 		float gainDB;
@@ -335,9 +651,7 @@ namespace json2wav::Filter
 			const float res_init = 1.0f,
 			const float gainDB_init = 0.0f,
 			const uint_fast16_t controlUpdate_init = 1)
-			: FilterBase<bOwner>(freq_init, res_init, gainDB_init),
-			controlUpdateInterval(controlUpdate_init),
-			controlUpdateCounter(1),
+			: FilterBase<bOwner>(freq_init, res_init, gainDB_init, controlUpdate_init),
 			lastSampleRate(0)
 		{
 			for (uint_fast8_t ch = 0; ch < numch; ++ch)
@@ -384,33 +698,31 @@ namespace json2wav::Filter
 				return;
 			}
 
-			this->ProcessEvents(numSamples, [this, bufs, deltaTime](const size_t i)
+			if (this->SkipSilence(bufs, numChannels, numSamples, deltaTime, [this, deltaTime]() { recalc(deltaTime, b, a); }))
+			{
+				for (uint_fast8_t ch = 0; ch < numch; ++ch)
 				{
-					if (controlUpdateCounter >= controlUpdateInterval)
-					{
-						if (this->IncrementRamps(deltaTime * controlUpdateInterval))
-						{
-							recalc(deltaTime, b, a);
-						}
-						controlUpdateCounter = 1;
-					}
-					else
+					for (uint_fast8_t n = 0; n < order; ++n)
 					{
-						++controlUpdateCounter;
+						z[ch][n] = 0.0f;
+						b1[ch][n] = 0.0f;
 					}
+					b1[ch][order] = 0.0f;
+				}
+				return;
+			}
 
-					for (uint_fast8_t ch = 0; ch < numch; ++ch)
-					{
-						Topo<eTopo>::template DoFilter<FloatType, order>(bufs[ch][i], z[ch], a, b, b1[ch]);
-					}
+			this->FilterSpans(numSamples, deltaTime,
+				[this, deltaTime]() { recalc(deltaTime, b, a); },
+				[this, bufs](const size_t start, const size_t count)
+				{
+					Topo<eTopo>::template DoFilterBlock<FloatType, order, numch>(bufs, start, count, z, a, b, b1);
 				});
 		}
 
 		virtual size_t GetNumChannels() const noexcept override { return numch; }
 
 	private:
-		uint_fast16_t controlUpdateInterval;
-		uint_fast16_t controlUpdateCounter;
 		unsigned long lastSampleRate;
 		FloatType b[order + 1];
 		FloatType b1[numch][order + 1];
@@ -516,6 +828,32 @@ namespace json2wav::Filter
 		{
 			return GetRaw(i) + offset[i];
 		}
+		void GetPoles(std::complex<T> (&poles)[order]) const
+		{
+			GetPolesAt(offset[0], poles);
+		}
+		/** Roots of (1 + s)^order + resonance, in closed form */
+		static void GetPolesAt(const T resonance, std::complex<T> (&poles)[order])
+		{
+			const T turn = (resonance > static_cast<T>(0)) ? static_cast<T>(0.5) : static_cast<T>(0);
+			for (uint_fast8_t m = 0; m < order; ++m)
+				poles[m] = static_cast<T>(-1) + std::polar(GetPoleRadius(resonance), vTau<T>::value * (static_cast<T>(m) + turn) / static_cast<T>(order));
+		}
+		/** How far resonance moves the poles from -1; sections vary smoothly with this rather than with resonance */
+		static T GetPoleRadius(const T resonance)
+		{
+			const T k = std::abs(resonance);
+			if constexpr (order == 2)
+				return std::sqrt(k);
+			else if constexpr (order == 4)
+				return std::sqrt(std::sqrt(k));
+			else
+				return std::pow(k, static_cast<T>(1) / static_cast<T>(order));
+		}
+		static T GetLeadingCoeff() { return Math::Binomial_t<T, order>::data[order]; }
+		// SectionTable covers resonances from none up to where an order-4 ladder self-oscillates
+		static constexpr const uint_fast8_t numTableResonances = 33;
+		static constexpr const T maxTableResonance = static_cast<T>(4);
 		const_iterator begin() const { return const_iterator(*this); }
 		const_iterator end() const { return const_iterator(*this, order + 1); }
 		const_iterator cbegin() const { return const_iterator(*this); }
@@ -541,16 +879,398 @@ namespace json2wav::Filter
 		{
 			return Math::BesselPolyReverse_t<T, order>::data[i];
 		}
+		void GetPoles(std::complex<T> (&poles)[order]) const
+		{
+			GetPolesAt(static_cast<T>(0), poles);
+		}
+		/** Roots of the reverse Bessel polynomial, solved once per order; there's no resonance */
+		static void GetPolesAt(const T, std::complex<T> (&poles)[order])
+		{
+			static const struct Roots
+			{
+				Roots()
+				{
+					T coeffs[order + 1];
+					for (uint_fast8_t i = 0; i <= order; ++i)
+						coeffs[i] = Math::BesselPolyReverse_t<T, order>::data[i];
+					Math::PolyRoots<T, order>(coeffs, poles);
+				}
+				std::complex<T> poles[order];
+			} roots;
+			std::copy(std::begin(roots.poles), std::end(roots.poles), std::begin(poles));
+		}
+		static T GetLeadingCoeff() { return Math::BesselPolyReverse_t<T, order>::data[order]; }
+		static constexpr const uint_fast8_t numTableResonances = 1;
+		static constexpr const T maxTableResonance = static_cast<T>(0);
 		const_iterator begin() const { return const_iterator(*this); }
 		const_iterator end() const { return const_iterator(*this, order + 1); }
 		const_iterator cbegin() const { return const_iterator(*this); }
 		const_iterator cend() const { return const_iterator(*this, order + 1); }
 	};
 
+	/**
+	 * Splits a prototype's poles into sections s^2 + u*s + v, lowest Q first. For odd orders the first section is
+	 * s + v instead.
+	 */
+	template<uint_fast8_t order, typename T>
+	inline void FactorSections(
+		const std::complex<T> (&poles)[order],
+		double (&sectionU)[(order + 1) / 2],
+		double (&sectionV)[(order + 1) / 2])
+	{
+		constexpr uint_fast8_t numSections = (order + 1) / 2;
+		constexpr bool bFirstOrder = (order % 2) != 0;
+		double realPoles[order];
+		uint_fast8_t numReal = 0;
+		uint_fast8_t k = bFirstOrder ? 1 : 0;
+		for (const std::complex<T>& pole : poles)
+		{
+			const double re = static_cast<double>(pole.real());
+			const double im = static_cast<double>(pole.imag());
+			if (std::abs(im) <= 1.0e-9 * std::max(1.0, std::abs(re)))
+				realPoles[numReal++] = re;
+			else if (im > 0.0 && k < numSections)
+			{
+				sectionU[k] = -2.0 * re;
+				sectionV[k] = re * re + im * im;
+				++k;
+			}
+		}
+		uint_fast8_t n = 0;
+		if constexpr (bFirstOrder)
+		{
+			sectionU[0] = 1.0;
+			sectionV[0] = (numReal > 0) ? -realPoles[n++] : 1.0;
+		}
+		for (; n + 1 < numReal && k < numSections; n += 2, ++k)
+		{
+			sectionU[k] = -(realPoles[n] + realPoles[n + 1]);
+			sectionV[k] = realPoles[n] * realPoles[n + 1];
+		}
+
+		// Q of s^2 + u*s + v is sqrt(v)/u; insertion sort since there are at most a handful
+		for (uint_fast8_t i = bFirstOrder ? 2 : 1; i < numSections; ++i)
+			for (uint_fast8_t j = i; j > (bFirstOrder ? 1 : 0) && std::sqrt(sectionV[j]) * sectionU[j - 1] < std::sqrt(sectionV[j - 1]) * sectionU[j]; --j)
+			{
+				std::swap(sectionU[j], sectionU[j - 1]);
+				std::swap(sectionV[j], sectionV[j - 1]);
+			}
+	}
+
+	/**
+	 * The same prewarped bilinear transform as DoRecalc, applied to each section on its own, where K is the cotangent
+	 * of half the cutoff's angle per sample. The prototype's gain goes on the first section.
+	 */
+	template<uint_fast8_t order, typename FloatType>
+	inline void TransformSections(
+		const double K,
+		const double gain,
+		const double (&sectionU)[(order + 1) / 2],
+		const double (&sectionV)[(order + 1) / 2],
+		FloatType (&b)[(order + 1) / 2][3],
+		FloatType (&a)[(order + 1) / 2][2])
+	{
+		constexpr uint_fast8_t numSections = (order + 1) / 2;
+		constexpr bool bFirstOrder = (order % 2) != 0;
+		const double K2 = K * K;
+		for (uint_fast8_t k = 0; k < numSections; ++k)
+		{
+			const double sectionGain = (k == 0) ? gain : 1.0;
+			if (bFirstOrder && k == 0)
+			{
+				const double invq0 = 1.0 / (K + sectionV[k]);
+				b[k][0] = static_cast<FloatType>(sectionGain * invq0);
+				b[k][1] = static_cast<FloatType>(sectionGain * invq0);
+				b[k][2] = static_cast<FloatType>(0);
+				a[k][0] = static_cast<FloatType>((sectionV[k] - K) * invq0);
+				a[k][1] = static_cast<FloatType>(0);
+				continue;
+			}
+			const double invq0 = 1.0 / (K2 + sectionU[k] * K + sectionV[k]);
+			b[k][0] = static_cast<FloatType>(sectionGain * invq0);
+			b[k][1] = static_cast<FloatType>(2.0 * sectionGain * invq0);
+			b[k][2] = static_cast<FloatType>(sectionGain * invq0);
+			a[k][0] = static_cast<FloatType>(2.0 * (sectionV[k] - K2) * invq0);
+			a[k][1] = static_cast<FloatType>((K2 - sectionU[k] * K + sectionV[k]) * invq0);
+		}
+	}
+
+	/**
+	 * Section coefficients of a Laplace prototype over a grid of cutoffs, and of resonances for prototypes that have
+	 * one, built on first use and shared by every filter of the prototype. Cutoffs are per sample and spaced evenly
+	 * within each octave, so a cutoff's place on the grid comes from its exponent and mantissa without a logarithm;
+	 * resonances are spaced evenly in pole radius. Coefficients between grid points are interpolated linearly, which
+	 * keeps sections stable since the stable (a1, a2) of a section form a triangle.
+	 */
+	template<typename LaplaceType>
+	class SectionTable
+	{
+		using T = typename LaplaceType::return_type;
+		static constexpr const uint_fast8_t order = LaplaceType::order;
+		static constexpr const uint_fast8_t numSections = (order + 1) / 2;
+		static constexpr const bool bFirstOrder = (order % 2) != 0;
+		static constexpr const uint_fast8_t numResonances = LaplaceType::numTableResonances;
+		static constexpr const int numOctaves = 16; // Cutoffs from 2^-17 to 2^-1 of the sample rate
+		static constexpr const size_t stepsPerOctave = 32;
+		static constexpr const size_t numCutoffs = numOctaves * stepsPerOctave + 1;
+		static constexpr const size_t entrySize = numSections * 3; // b0, a1, a2 per section
+
+	public:
+		static const SectionTable& Get()
+		{
+			static const SectionTable table;
+			return table;
+		}
+
+		/** Interpolates the sections at cutoff cycles per sample and resonance; false if they're off the grid */
+		template<typename FloatType>
+		bool Lookup(const double cutoff, const double resonance, FloatType (&b)[numSections][3], FloatType (&a)[numSections][2]) const
+		{
+			if (!(cutoff >= lowestCutoff && cutoff < 0.5))
+				return false;
+			int exponent;
+			const double mantissa = std::frexp(cutoff, &exponent);
+			const double cutoffPos = (static_cast<double>(exponent + numOctaves) + (mantissa + mantissa - 1.0)) * stepsPerOctave;
+			const size_t cutoffIdx = std::min(static_cast<size_t>(cutoffPos), numCutoffs - 2);
+			const double cutoffFrac = cutoffPos - static_cast<double>(cutoffIdx);
+
+			const double* lo = &entries[cutoffIdx * entrySize];
+			double entry[entrySize];
+			if constexpr (numResonances > 1)
+			{
+				if (!(resonance >= 0.0 && resonance <= static_cast<double>(LaplaceType::maxTableResonance)))
+					return false;
+				const double resPos = static_cast<double>(LaplaceType::GetPoleRadius(static_cast<T>(resonance))) * resScale;
+				const size_t resIdx = std::min(static_cast<size_t>(resPos), static_cast<size_t>(numResonances - 2));
+				const double resFrac = resPos - static_cast<double>(resIdx);
+				lo += resIdx * numCutoffs * entrySize;
+				const double* const hi = lo + numCutoffs * entrySize;
+				for (size_t n = 0; n < entrySize; ++n)
+				{
+					const double atLo = lo[n] + cutoffFrac * (lo[n + entrySize] - lo[n]);
+					const double atHi = hi[n] + cutoffFrac * (hi[n + entrySize] - hi[n]);
+					entry[n] = atLo + resFrac * (atHi - atLo);
+				}
+			}
+			else
+			{
+				for (size_t n = 0; n < entrySize; ++n)
+					entry[n] = lo[n] + cutoffFrac * (lo[n + entrySize] - lo[n]);
+			}
+
+			for (uint_fast8_t k = 0; k < numSections; ++k)
+			{
+				const double b0 = entry[k * 3];
+				const bool bSectionFirstOrder = bFirstOrder && k == 0;
+				b[k][0] = static_cast<FloatType>(b0);
+				b[k][1] = static_cast<FloatType>(bSectionFirstOrder ? b0 : 2.0 * b0);
+				b[k][2] = static_cast<FloatType>(bSectionFirstOrder ? 0.0 : b0);
+				a[k][0] = static_cast<FloatType>(entry[k * 3 + 1]);
+				a[k][1] = static_cast<FloatType>(entry[k * 3 + 2]);
+			}
+			return true;
+		}
+
+	private:
+		SectionTable()
+			: resScale(GetResScale()),
+			entries(numResonances * numCutoffs * entrySize)
+		{
+			const double gain = 1.0 / static_cast<double>(LaplaceType::GetLeadingCoeff());
+			for (size_t r = 0; r < numResonances; ++r)
+			{
+				// Even steps in pole radius, back to the resonance that gives each
+				const double radius = (numResonances > 1) ? static_cast<double>(r) / resScale : 0.0;
+				const double resonance = (numResonances > 1) ? std::pow(radius, static_cast<double>(order)) : 0.0;
+				std::complex<T> poles[order];
+				LaplaceType::GetPolesAt(static_cast<T>(resonance), poles);
+				double sectionU[numSections] = {};
+				double sectionV[numSections] = {};
+				FactorSections<order>(poles, sectionU, sectionV);
+				for (size_t c = 0; c < numCutoffs; ++c)
+				{
+					const double cutoff = std::ldexp(1.0 + static_cast<double>(c % stepsPerOctave) / stepsPerOctave,
+						static_cast<int>(c / stepsPerOctave) - numOctaves - 1);
+					const double K = std::tan(vQuarterTau<double>::value - vHalfTau<double>::value * cutoff);
+					double b[numSections][3];
+					double a[numSections][2];
+					TransformSections<order>(K, gain, sectionU, sectionV, b, a);
+					double* const entry = &entries[(r * numCutoffs + c) * entrySize];
+					for (uint_fast8_t k = 0; k < numSections; ++k)
+					{
+						entry[k * 3] = b[k][0];
+						entry[k * 3 + 1] = a[k][0];
+						entry[k * 3 + 2] = a[k][1];
+					}
+				}
+			}
+		}
+
+		static double GetResScale()
+		{
+			if constexpr (numResonances > 1)
+				return static_cast<double>(numResonances - 1) / static_cast<double>(LaplaceType::GetPoleRadius(LaplaceType::maxTableResonance));
+			else
+				return 0.0;
+		}
+
+		static constexpr const double lowestCutoff = 1.0 / static_cast<double>(1ull << (numOctaves + 1));
+
+		const double resScale; // Grid steps per unit of pole radius
+		Vector<double> entries;
+	};
+
+	/**
+	 * A Laplace prototype run as cascaded second-order sections, the first of them first-order for odd orders. The
+	 * sections are refactored only when the prototype's coefficients change; a cutoff change just re-runs each
+	 * section's bilinear transform, and ramps read their sections from a SectionTable instead. Sections stay stable at orders and cutoffs where a direct form blows up; float
+	 * sections run twice as many lanes but lose precision at low cutoffs, so double is the default.
+	 */
+	template<uint_fast8_t order, typename LaplaceType, bool bOwner = false, uint_fast8_t numch = 2, typename FloatType = double, ETopo eTopo = ETopo::TDF2>
+	class LaplaceSOSFilter : public FilterBase<bOwner>
+	{
+		static_assert(order > 0, "Filters need at least one pole");
+		static constexpr const uint_fast8_t numSections = (order + 1) / 2;
+		static constexpr const bool bFirstOrder = (order % 2) != 0;
+
+	public:
+		explicit LaplaceSOSFilter(
+			const float freq_init = 1000.0f,
+			const float res_init = 1.0f,
+			const float gainDB_init = 0.0f,
+			const uint_fast16_t controlUpdate_init = 1)
+			: FilterBase<bOwner>(freq_init, res_init, gainDB_init, controlUpdate_init),
+			laplace(*this),
+#if ALBUMBOT_FILTER_COEFF_TABLE
+			table(SectionTable<LaplaceType>::Get()),
+#endif
+			lastSampleRate(0)
+		{
+			for (uint_fast8_t k = 0; k < numSections; ++k)
+			{
+				for (uint_fast8_t ch = 0; ch < numch; ++ch)
+				{
+					z[k][ch][0] = static_cast<FloatType>(0);
+					z[k][ch][1] = static_cast<FloatType>(0);
+					for (uint_fast8_t n = 0; n < 3; ++n)
+						b1[k][ch][n] = static_cast<FloatType>(0);
+				}
+			}
+			for (uint_fast8_t n = 0; n <= order; ++n)
+				prototype[n] = NAN;
+		}
+
+		virtual void GetSamples(
+			Sample* const* const bufs,
+			const size_t numChannels,
+			const size_t numSamples,
+			const unsigned long sampleRate,
+			IAudioObject* const requester) noexcept override
+		{
+			if (numChannels != numch)
+			{
+				this->IncrementSampleNum(numSamples);
+				return;
+			}
+
+			const double deltaTime = 1.0 / static_cast<double>(sampleRate);
+			if (sampleRate != lastSampleRate)
+			{
+				lastSampleRate = sampleRate;
+				Recalc(deltaTime);
+			}
+
+			if (this->GetInputSamples(bufs, numChannels, numSamples, sampleRate) != AudioSum<bOwner>::EGetInputSamplesResult::SamplesWritten)
+			{
+				this->IncrementSampleNum(numSamples);
+				return;
+			}
+
+			if (this->SkipSilence(bufs, numChannels, numSamples, deltaTime, [this, deltaTime]() { RecalcControl(deltaTime); }))
+			{
+				for (uint_fast8_t k = 0; k < numSections; ++k)
+				{
+					for (uint_fast8_t ch = 0; ch < numch; ++ch)
+					{
+						z[k][ch][0] = static_cast<FloatType>(0);
+						z[k][ch][1] = static_cast<FloatType>(0);
+						for (uint_fast8_t n = 0; n < 3; ++n)
+							b1[k][ch][n] = static_cast<FloatType>(0);
+					}
+				}
+				return;
+			}
+
+			this->FilterSpans(numSamples, deltaTime,
+				[this, deltaTime]() { RecalcControl(deltaTime); },
+				[this, bufs](const size_t start, const size_t count)
+				{
+					// Runs too short to fill the pipeline go through one section at a time, with the same arithmetic
+					if (count >= numSections)
+						Topo<eTopo>::template DoCascadeBlock<FloatType, numSections, numch>(bufs, start, count, z, a, b, b1);
+					else
+						for (uint_fast8_t k = 0; k < numSections; ++k)
+							Topo<eTopo>::template DoFilterBlock<FloatType, 2, numch>(bufs, start, count, z[k], a[k], b[k], b1[k]);
+				});
+		}
+
+		virtual size_t GetNumChannels() const noexcept override { return numch; }
+
+	private:
+		void Recalc(const double deltaTime)
+		{
+			laplace.Update();
+			bool bPrototypeMoved = false;
+			for (uint_fast8_t n = 0; n <= order; ++n)
+			{
+				const double coeff = static_cast<double>(laplace[n]);
+				if (coeff != prototype[n])
+				{
+					prototype[n] = coeff;
+					bPrototypeMoved = true;
+				}
+			}
+			if (bPrototypeMoved)
+			{
+				using Complex = std::complex<typename LaplaceType::return_type>;
+				Complex poles[order];
+				laplace.GetPoles(poles);
+				FactorSections<order>(poles, sectionU, sectionV);
+			}
+
+			const double K = std::tan(vQuarterTau<double>::value - vHalfTau<double>::value * static_cast<double>(this->GetFrequency()) * deltaTime);
+			TransformSections<order>(K, 1.0 / prototype[order], sectionU, sectionV, b, a);
+		}
+
+		/** Control-rate recalculation, from the shared table where it covers the cutoff and resonance */
+		void RecalcControl(const double deltaTime)
+		{
+#if ALBUMBOT_FILTER_COEFF_TABLE
+			if (table.Lookup(static_cast<double>(this->GetFrequency()) * deltaTime, static_cast<double>(this->GetResonance()), b, a))
+				return;
+#endif
+			Recalc(deltaTime);
+		}
+
+	private:
+		LaplaceType laplace;
+#if ALBUMBOT_FILTER_COEFF_TABLE
+		const SectionTable<LaplaceType>& table;
+#endif
+		unsigned long lastSampleRate;
+		double prototype[order + 1];
+		double sectionU[numSections] = {};
+		double sectionV[numSections] = {};
+		FloatType b[numSections][3] = {};
+		FloatType a[numSections][2] = {};
+		FloatType b1[numSections][numch][3];
+		FloatType z[numSections][numch][2];
+	};
+
 	template<bool bOwner = false, uint_fast8_t numch = 2, ETopo eTopo = ETopo::TDF2, uint_fast8_t order = 4, typename LaplaceFloatType = double, typename FilterFloatType = double>
-	class LadderLP_Custom : public LaplaceFilter<order, LadderLPLaplace<LaplaceFloatType, order, bOwner>, bOwner, numch, FilterFloatType, eTopo>
+	class LadderLP_Custom : public LaplaceSOSFilter<order, LadderLPLaplace<LaplaceFloatType, order, bOwner>, bOwner, numch, FilterFloatType, eTopo>
 	{
-		using Super = LaplaceFilter<order, LadderLPLaplace<LaplaceFloatType, order, bOwner>, bOwner, numch, FilterFloatType, eTopo>;
+		using Super = LaplaceSOSFilter<order, LadderLPLaplace<LaplaceFloatType, order, bOwner>, bOwner, numch, FilterFloatType, eTopo>;
 
 	public:
 		explicit LadderLP_Custom(
@@ -567,9 +1287,9 @@ namespace json2wav::Filter
 	using LadderLP = LadderLP_Custom<bOwner, numch, eTopo>;
 
 	template<uint_fast8_t order, bool bOwner = false, uint_fast8_t numch = 2, ETopo eTopo = ETopo::TDF2, typename LaplaceFloatType = double, typename FilterFloatType = double>
-	class BesselLP_Custom : public LaplaceFilter<order, BesselLPLaplace<LaplaceFloatType, order>, bOwner, numch, FilterFloatType, eTopo>
+	class BesselLP_Custom : public LaplaceSOSFilter<order, BesselLPLaplace<LaplaceFloatType, order>, bOwner, numch, FilterFloatType, eTopo>
 	{
-		using Super = LaplaceFilter<order, BesselLPLaplace<LaplaceFloatType, order>, bOwner, numch, FilterFloatType, eTopo>;
+		using Super = LaplaceSOSFilter<order, BesselLPLaplace<LaplaceFloatType, order>, bOwner, numch, FilterFloatType, eTopo>;
 
 	public:
 		explicit BesselLP_Custom(
@@ -0,0 +1,373 @@
+// Copyright Dan Price 2026.
+
+#pragma once
+
+#include "IAudioObject.h"
+#include "Fader.h"
+#include "Panner.h"
+#include "MSProc.h"
+#include "Sample.h"
+#include "SampleKernels.h"
+#include "Utility.h"
+#include "Memory.h"
+#include "NodeNames.h"
+#include <algorithm>
+#include <cstdint>
+
+// Runs of faders, panners and M/S converters in an effect chain render as one node instead of one pass each
+#define ALBUMBOT_FUSE_POINTWISE 1
+
+namespace json2wav
+{
+	/**
+	 * Stands in for a run of pointwise effects, composing their gains, pan laws and M/S matrices into one 2x2 matrix per
+	 * sample. The absorbed nodes keep their parameters and events; their event timelines are merged here.
+	 */
+	class FusedPointwise : public AudioSum<>
+	{
+	public:
+		static bool IsPointwise(const AudioJoin<>* const node) noexcept
+		{
+			return dynamic_cast<const Fader<>*>(node) || dynamic_cast<const Panner<>*>(node)
+				|| dynamic_cast<const MSConverter<>*>(node) || dynamic_cast<const LRConverter<>*>(node);
+		}
+
+		/** Stages run in the order they're added, so add the input end of the run first */
+		bool AddStage(const SharedPtr<AudioJoin<>>& node)
+		{
+			Stage stage{ EStage::MSConverter, node, dynamic_cast<Fader<>*>(node.get()), dynamic_cast<Panner<>*>(node.get()) };
+			if (stage.fader)
+				stage.kind = EStage::Fader;
+			else if (stage.panner)
+				stage.kind = EStage::Panner;
+			else if (dynamic_cast<LRConverter<>*>(node.get()))
+				stage.kind = EStage::LRConverter;
+			else if (!dynamic_cast<MSConverter<>*>(node.get()))
+				return false;
+			stages.push_back(std::move(stage));
+			return true;
+		}
+
+		size_t GetNumStages() const noexcept
+		{
+			return stages.size();
+		}
+
+		virtual void GetSamples(
+			Sample* const* const bufs,
+			const size_t numChannels,
+			const size_t numSamples,
+			const unsigned long sampleRate,
+			IAudioObject* const requester) noexcept override
+		{
+			lastNumChannels = numChannels;
+			const EGetInputSamplesResult inputResult = this->GetInputSamples(bufs, numChannels, numSamples, sampleRate);
+			const size_t start = sampleNum;
+			sampleNum += numSamples;
+
+			const double deltaTime = 1.0 / static_cast<double>(sampleRate);
+
+			// A lone fader skips the block and its events when there was nothing to process, but a lone panner pans anyway
+			if (inputResult != EGetInputSamplesResult::SamplesWritten)
+			{
+				for (Stage& stage : stages)
+				{
+					if (stage.kind == EStage::Panner && numChannels == 2)
+						stage.panner->ApplyInPlace(bufs, numSamples, deltaTime);
+					else
+						stage.SkipSamples(numSamples);
+				}
+				return;
+			}
+
+			if (numChannels != 2)
+			{
+				// Only faders touch anything but stereo, so there's nothing to fuse
+				for (Stage& stage : stages)
+				{
+					if (stage.kind == EStage::Fader)
+						stage.fader->ApplyInPlace(bufs, numChannels, numSamples, deltaTime);
+					else
+						stage.SkipSamples(numSamples);
+				}
+				return;
+			}
+
+			const size_t end = start + numSamples;
+			for (size_t i = 0, n = start; i < numSamples; )
+			{
+				size_t next = end;
+				for (Stage& stage : stages)
+				{
+					stage.TriggerCurrentEvents();
+					next = std::min(next, stage.GetNextEventKey(n + 1, end));
+				}
+
+				const size_t count = next - n;
+				ProcessSpan(bufs, i, count, deltaTime);
+				for (Stage& stage : stages)
+					stage.SkipSamples(count);
+				i += count;
+				n = next;
+			}
+		}
+
+		virtual size_t GetNumChannels() const noexcept override
+		{
+			return (!stages.empty() && stages.back().kind == EStage::Fader) ? lastNumChannels : 2;
+		}
+
+	private:
+		static constexpr const size_t rampChunk = Fader<>::rampChunk;
+
+		enum class EStage : uint8_t
+		{
+			Fader, Panner, MSConverter, LRConverter
+		};
+
+		struct Stage
+		{
+			EStage kind;
+			SharedPtr<AudioJoin<>> node;
+			Fader<>* fader;
+			Panner<>* panner;
+
+			void TriggerCurrentEvents()
+			{
+				if (fader)
+					fader->TriggerCurrentEvents();
+				else if (panner)
+					panner->TriggerCurrentEvents();
+			}
+
+			size_t GetNextEventKey(const size_t from, const size_t end) const
+			{
+				return fader ? fader->GetNextEventKey(from, end) : panner ? panner->GetNextEventKey(from, end) : end;
+			}
+
+			void SkipSamples(const size_t count) noexcept
+			{
+				if (fader)
+					fader->SkipSamples(count);
+				else if (panner)
+					panner->SkipSamples(count);
+			}
+
+			bool IsRamping() const noexcept
+			{
+				return fader ? fader->IsRamping() : panner ? panner->IsRamping() : false;
+			}
+
+			/** m = (this stage's matrix) * m, with the stage holding still */
+			void Apply(float (&m)[2][2]) const noexcept
+			{
+				switch (kind)
+				{
+				case EStage::Fader: Scale(m, fader->GetGainFactor(), fader->GetGainFactor()); break;
+				case EStage::Panner: Scale(m, panner->GetLeftPanVolume(), panner->GetRightPanVolume()); break;
+				case EStage::MSConverter: SumDiff(m, MSConverter<>::Scale()); break;
+				case EStage::LRConverter: SumDiff(m, LRConverter<>::Scale()); break;
+				}
+			}
+
+			/** m[row][col][j] = (this stage's matrix for sample j) * m[...][j], stepping any ramp count samples */
+			void ApplyBlock(float (&m)[2][2][rampChunk], const size_t count, const double deltaTime) noexcept
+			{
+				float gains[2][rampChunk];
+				switch (kind)
+				{
+				case EStage::Fader:
+					break; // ProcessSpan gathers fader gains separately
+
+				case EStage::Panner:
+					panner->StepPanVolumes(deltaTime, gains[0], gains[1], count);
+					for (size_t row = 0; row < 2; ++row)
+						for (auto& x : m[row])
+							for (size_t j = 0; j < count; ++j)
+								x[j] *= gains[row][j];
+					break;
+
+				case EStage::MSConverter:
+				case EStage::LRConverter:
+					{
+						const float scale = (kind == EStage::LRConverter) ? LRConverter<>::Scale() : MSConverter<>::Scale();
+						for (size_t col = 0; col < 2; ++col)
+						{
+							for (size_t j = 0; j < count; ++j)
+							{
+								const float sum = m[0][col][j] + m[1][col][j];
+								const float diff = m[0][col][j] - m[1][col][j];
+								m[0][col][j] = scale*sum;
+								m[1][col][j] = scale*diff;
+							}
+						}
+					} break;
+				}
+			}
+
+		private:
+			static void Scale(float (&m)[2][2], const float left, const float right) noexcept
+			{
+				for (float& x : m[0])
+					x *= left;
+				for (float& x : m[1])
+					x *= right;
+			}
+
+			static void SumDiff(float (&m)[2][2], const float scale) noexcept
+			{
+				for (size_t col = 0; col < 2; ++col)
+				{
+					const float sum = m[0][col] + m[1][col];
+					const float diff = m[0][col] - m[1][col];
+					m[0][col] = scale*sum;
+					m[1][col] = scale*diff;
+				}
+			}
+		};
+
+		/** Samples [start, start + count) have no events among them */
+		void ProcessSpan(Sample* const* const bufs, const size_t start, const size_t count, const double deltaTime) noexcept
+		{
+			for (size_t i = start, end = start + count; i < end; )
+			{
+				bool bFaderRamping = false;
+				bool bMatrixRamping = false;
+				for (const Stage& stage : stages)
+				{
+					if (stage.kind == EStage::Fader)
+						bFaderRamping = bFaderRamping || stage.IsRamping();
+					else
+						bMatrixRamping = bMatrixRamping || stage.IsRamping();
+				}
+
+				if (!bFaderRamping && !bMatrixRamping)
+				{
+					// Nothing changes until the next event, so one matrix covers the rest of the span
+					float m[2][2] = { { 1.0f, 0.0f }, { 0.0f, 1.0f } };
+					for (const Stage& stage : stages)
+						stage.Apply(m);
+					kernel::Mix2x2(AsSpan(bufs[0] + i, end - i), AsSpan(bufs[1] + i, end - i), m);
+					return;
+				}
+
+				if (!bMatrixRamping)
+				{
+					// Only fader gains move, and they commute with every other stage, so the rest make one matrix that holds
+					// until the next event
+					float m[2][2] = { { 1.0f, 0.0f }, { 0.0f, 1.0f } };
+					for (const Stage& stage : stages)
+						if (stage.kind != EStage::Fader)
+							stage.Apply(m);
+					while (i < end && bFaderRamping)
+					{
+						const size_t chunk = std::min(end - i, rampChunk);
+						float gains[rampChunk];
+						StepFaderGains(gains, chunk, deltaTime);
+						kernel::Mix2x2(AsSpan(bufs[0] + i, chunk), AsSpan(bufs[1] + i, chunk), std::span<const float>(gains, chunk), m);
+						i += chunk;
+
+						bFaderRamping = false;
+						for (const Stage& stage : stages)
+							bFaderRamping = bFaderRamping || (stage.kind == EStage::Fader && stage.IsRamping());
+					}
+					continue;
+				}
+
+				// A matrix per sample, built up stage by stage across the chunk
+				const size_t chunk = std::min(end - i, rampChunk);
+				float gains[rampChunk];
+				StepFaderGains(gains, chunk, deltaTime);
+				float m[2][2][rampChunk];
+				for (size_t row = 0; row < 2; ++row)
+					for (size_t col = 0; col < 2; ++col)
+						std::fill_n(m[row][col], chunk, (row == col) ? 1.0f : 0.0f);
+				for (Stage& stage : stages)
+					stage.ApplyBlock(m, chunk, deltaTime);
+				Sample* const left = bufs[0] + i;
+				Sample* const right = bufs[1] + i;
+				for (size_t j = 0; j < chunk; ++j)
+				{
+					const float x = gains[j]*left[j].AsFloat32();
+					const float y = gains[j]*right[j].AsFloat32();
+					left[j] = m[0][0][j]*x + m[0][1][j]*y;
+					right[j] = m[1][0][j]*x + m[1][1][j]*y;
+				}
+
+				// Ramps can finish partway through a chunk, so look again after it
+				i += chunk;
+			}
+		}
+
+		/** Steps every fader count samples, gathering their gains into one per sample */
+		void StepFaderGains(float* const gains, const size_t count, const double deltaTime) noexcept
+		{
+			bool bGains = false;
+			for (Stage& stage : stages)
+			{
+				if (stage.kind != EStage::Fader)
+					continue;
+				if (bGains)
+				{
+					float faderGains[rampChunk];
+					stage.fader->StepGainFactors(deltaTime, faderGains, count);
+					kernel::Gain(std::span<float>(gains, count), std::span<const float>(faderGains, count));
+				}
+				else
+				{
+					stage.fader->StepGainFactors(deltaTime, gains, count);
+					bGains = true;
+				}
+			}
+			if (!bGains)
+				std::fill_n(gains, count, 1.0f);
+		}
+
+	private:
+		Vector<Stage> stages;
+		size_t sampleNum = 0;
+		size_t lastNumChannels = 2;
+	};
+
+	/**
+	 * Replaces each run of two or more pointwise effects in a chain built by JsonInterpreter::AddEffect (effects[i + 1]
+	 * feeds effects[i] and effects[0] feeds output) with a FusedPointwise, which takes the run's place in effects. Call
+	 * once the graph is complete: inputs added to effects.back() afterwards would miss a fused run there.
+	 */
+	inline void FusePointwiseChain(Vector<SharedPtr<AudioJoin<>>>& effects, const SharedPtr<AudioJoin<>>& output)
+	{
+		for (size_t first = 0; first < effects.size(); ++first)
+		{
+			size_t last = first;
+			while (last < effects.size() && effects[last] && FusedPointwise::IsPointwise(effects[last].get()))
+				++last;
+			if (last - first < 2)
+				continue;
+
+			SharedPtr<FusedPointwise> fused(MakeShared<FusedPointwise>());
+			for (size_t idx = last; idx-- > first;)
+				fused->AddStage(effects[idx]);
+
+			Vector<SharedPtr<IAudioObject>> inputs;
+			for (const auto& input : effects[last - 1]->GetInputs())
+				if (SharedPtr<IAudioObject> audioObject = Utility::Lock(input))
+					inputs.emplace_back(std::move(audioObject));
+			for (size_t idx = first; idx < last; ++idx)
+				effects[idx]->ClearInputs();
+			for (SharedPtr<IAudioObject>& input : inputs)
+				fused->AddInput(std::move(input));
+
+			if (const SharedPtr<AudioJoin<>>& consumer = (first == 0) ? output : effects[first - 1])
+			{
+				consumer->RemoveInput(effects[first]);
+				consumer->AddInput(fused);
+			}
+
+#ifdef ALBUMBOT_NODE_NAMES
+			NodeNames::Label(fused.get(), NodeNames::Find(effects[first].get()));
+#endif
+			effects.erase(effects.begin() + first + 1, effects.begin() + last);
+			effects[first] = std::move(fused);
+		}
+	}
+}
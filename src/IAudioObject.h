@@ -4,10 +4,18 @@
 
 #include "Utility.h"
 #include "Sample.h"
+#include "SampleKernels.h"
 #include "Memory.h"
+#include "RenderArena.h"
 #include "ZeroInit.h"
 #include "Oversampler.h"
+#include "BlockScratch.h"
+#include "AllocGuard.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include "RenderRange.h"
 #include <unordered_map>
+#include <algorithm>
 #include <iostream>
 #include <mutex>
 #include <utility>
@@ -46,6 +54,19 @@ namespace json2wav
 		virtual void OnRemovedFromInput(IAudioObject* const pFormerOutput) {}
 
 		virtual size_t GetSampleDelay() const noexcept { return 0; }
+
+		/**
+		 * How long this node's output can still depend on input it has already been given, until it decays below
+		 * 16-bit resolution; renders that start partway through a song warm up for at least this long.
+		 */
+		virtual size_t GetTailSamples(const unsigned long sampleRate) const noexcept { return 0; }
+
+	protected:
+		/** Tails add up along a chain; one that never decays stays that way */
+		static size_t AddTails(const size_t tail0, const size_t tail1) noexcept
+		{
+			return (tail0 > SIZE_MAX - tail1) ? SIZE_MAX : tail0 + tail1;
+		}
 	};
 
 	template<bool bOwner = false, bool bSmartPtr = true>
@@ -96,10 +117,20 @@ namespace json2wav
 			return *maxInputDelay;
 		}
 
+		virtual size_t GetTailSamples(const unsigned long sampleRate) const noexcept override
+		{
+			size_t maxTail = 0;
+			for (const auto& inwkptr : inputs)
+				if (const Utility::StrongPtr_t<IAudioObject, bSmartPtr> inptr = Utility::Lock(inwkptr))
+					if (const size_t inputTail = inptr->GetTailSamples(sampleRate); inputTail > maxTail)
+						maxTail = inputTail;
+			return maxTail;
+		}
+
 	protected:
 		enum class EGetInputSamplesResult
 		{
-			None, SamplesWritten, ChannelMismatch, BadAlloc, NullOutputBuffer, ExcessiveDelay
+			None, SamplesWritten, ChannelMismatch, BadAlloc, NullOutputBuffer
 		};
 
 		EGetInputSamplesResult GetInputSamples(
@@ -119,6 +150,10 @@ namespace json2wav
 			{
 				if (const Utility::StrongPtr_t<IAudioObject, bSmartPtr> inptr = Utility::Lock(inputs[0]))
 				{
+					const profile::InputsScope profileInputs;
+					const allocguard::NodeScope guardNode(*inptr);
+					const profile::Scope profileNode(*inptr, this, bufSize);
+					const trace::NodeSpan traceNode(*inptr, bufSize);
 					inptr->GetSamples(bufs, numChannels, bufSize, sampleRate, this);
 					return EGetInputSamplesResult::SamplesWritten;
 				}
@@ -127,101 +162,133 @@ namespace json2wav
 			}
 
 			size_t bufidx = 0;
+			size_t inplaceidx = inputs.size();
+			const bool bSumInPlace = IsSumJoin();
 
 			{
-#if ALBUMBOT_USE_PARALLELISM_TS
-				// Serial
+				const profile::InputsScope profileInputs;
+
+				// Delayed inputs render straight into their delay rings unless the block would wrap
 				using LockedInputType = std::pair<Utility::StrongPtr_t<IAudioObject, bSmartPtr>, Sample* const*>;
-				Vector<LockedInputType> lockedInputs;
+				ScratchVector<LockedInputType> lockedInputs(BlockScratch::Get());
 				lockedInputs.reserve(inputs.size());
+				inbufs.reserve(inputs.size());
+				rings.reserve(inputs.size());
+				targets.resize(inputs.size() * numChannels);
 				for (const auto& inwkptr : inputs)
 				{
 					if (Utility::StrongPtr_t<IAudioObject, bSmartPtr> inptr = Utility::Lock(inwkptr))
 					{
 						if (bufidx >= inbufs.size())
+						{
 							inbufs.emplace_back(numChannels, bufSize, false);
+							rings.emplace_back();
+						}
 						else
+						{
 							inbufs[bufidx].Reinitialize(numChannels, bufSize);
+						}
 						if (bufidx >= inbufs.size() || inbufs[bufidx].GetBufSize() != bufSize)
+						{
 							return EGetInputSamplesResult::BadAlloc;
-						lockedInputs.emplace_back(std::move(inptr), inbufs[bufidx++].get());
-					}
-				}
-
-				// Parallel
-				std::for_each(std::execution::parallel_policy, lockedInputs.begin(), lockedInputs.end(),
-					[this, numChannels, bufSize, sampleRate](const LockedInputType& lockedInput)
-					{ lockedInput.first->GetSamples(lockedInput.second, numChannels, bufSize, sampleRate, this); });
+						}
 
-#else
-				Vector<std::future<void>> futs;
-				futs.reserve(inputs.size());
-				inbufs.reserve(inputs.size());
-				dlybufs.reserve(inputs.size());
-				for (const auto& inwkptr : inputs)
-				{
-					if (const Utility::StrongPtr_t<IAudioObject, bSmartPtr> inptr = Utility::Lock(inwkptr))
-					{
-						if (bufidx >= inbufs.size())
+						Sample** const target = targets.data() + bufidx * numChannels;
+						if (const size_t delay = delays[bufidx]; delay > 0)
 						{
-							inbufs.emplace_back(numChannels, bufSize, false);
-							dlybufs.emplace_back(numChannels, delays[bufidx], false);
+							DelayRing& ring = rings[bufidx];
+							if (!ring.Reserve(numChannels, delay, bufSize))
+								return EGetInputSamplesResult::BadAlloc;
+							const bool bDirect = ring.pos + bufSize <= ring.buf.GetBufSize();
+							for (size_t ch = 0; ch < numChannels; ++ch)
+								target[ch] = bDirect ? ring.buf[ch] + ring.pos : inbufs[bufidx][ch];
 						}
-						else
+						else if (bSumInPlace && inplaceidx == inputs.size())
 						{
-							inbufs[bufidx].Reinitialize(numChannels, bufSize);
-							dlybufs[bufidx].Reinitialize(numChannels, delays[bufidx]);
+							// Summing joins accumulate into the output, so one undelayed input can render there directly
+							for (size_t ch = 0; ch < numChannels; ++ch)
+								target[ch] = bufs[ch];
+							inplaceidx = bufidx;
 						}
-						if (bufidx >= inbufs.size() || inbufs[bufidx].GetBufSize() != bufSize)
+						else
 						{
-							return EGetInputSamplesResult::BadAlloc;
+							for (size_t ch = 0; ch < numChannels; ++ch)
+								target[ch] = inbufs[bufidx][ch];
 						}
 
-						Sample* const* const inbuf(inbufs[bufidx++].get());
-						futs.emplace_back(std::async(std::launch::async,
-							[this, inptr, inbuf, numChannels, bufSize, sampleRate]()
-							{
-								inptr->GetSamples(inbuf, numChannels, bufSize, sampleRate, this);
-							}));
+						lockedInputs.emplace_back(std::move(inptr), target);
+						++bufidx;
 					}
 				}
+
+#if ALBUMBOT_USE_PARALLELISM_TS
+				std::for_each(std::execution::par, lockedInputs.begin(), lockedInputs.end(),
+					[this, numChannels, bufSize, sampleRate, bFastForward = FastForward::IsActive(), arena = RenderArena::Current()](const LockedInputType& lockedInput)
+					{
+						const FastForward::Scope fastForward(bFastForward);
+						const RenderArena::Use arenaScope(arena);
+						const BlockScratch::Scope scratchScope;
+						const allocguard::NodeScope guardNode(*lockedInput.first);
+						const profile::Scope profileNode(*lockedInput.first, this, bufSize);
+						const trace::NodeSpan traceNode(*lockedInput.first, bufSize);
+						lockedInput.first->GetSamples(lockedInput.second, numChannels, bufSize, sampleRate, this);
+					});
+#else
+				ScratchVector<std::future<void>> futs(BlockScratch::Get());
+				futs.reserve(lockedInputs.size());
+				for (const LockedInputType& lockedInput : lockedInputs)
+				{
+					// Each input renders on a fresh thread with its own scratch; the launch itself still allocates
+					const allocguard::Exempt launch;
+					trace::AddInFlight(1);
+					futs.emplace_back(std::async(std::launch::async,
+						[this, &lockedInput, numChannels, bufSize, sampleRate, bFastForward = FastForward::IsActive(), arena = RenderArena::Current()]()
+						{
+							{
+								const FastForward::Scope fastForward(bFastForward);
+								const RenderArena::Use arenaScope(arena);
+								const BlockScratch::Scope scratchScope;
+								const allocguard::NodeScope guardNode(*lockedInput.first);
+								const profile::Scope profileNode(*lockedInput.first, this, bufSize);
+								const trace::NodeSpan traceNode(*lockedInput.first, bufSize);
+								lockedInput.first->GetSamples(lockedInput.second, numChannels, bufSize, sampleRate, this);
+							}
+							trace::AddInFlight(-1);
+						}));
+				}
 #endif
 			}
 
 			const size_t bufsWritten(bufidx);
 			if (bufsWritten > 0)
 			{
+				// Blocks that didn't fit before the end of their ring were rendered into inbufs; wrap them in
+				for (size_t bufnum = 0; bufnum < bufsWritten; ++bufnum)
+					if (delays[bufnum] > 0)
+						rings[bufnum].Write(inbufs[bufnum].get(), numChannels, bufSize);
+
+				joinbufs.resize(bufsWritten);
 				for (size_t ch = 0; ch < numChannels; ++ch)
 				{
-					Sample* const chbuf = bufs[ch];
-
 					for (size_t bufnum = 0; bufnum < bufsWritten; ++bufnum)
 					{
-						Sample* const inbuf = inbufs[bufnum][ch];
-						const size_t delay = delays[bufnum];
-						if (delay > 0)
-						{
-							if (delay > bufSize)
-								return EGetInputSamplesResult::ExcessiveDelay;
-
-							Sample* const dlybuf = dlybufs[bufnum][ch];
-							if (work.size() < bufSize)
-								work.resize(bufSize);
-							for (size_t i = 0; i < bufSize; ++i)
-								work[i] = inbuf[i];
-							for (size_t i = 0; i < delay; ++i)
-							{
-								inbuf[i] = dlybuf[i];
-								dlybuf[i] = work[bufSize - delay + i];
-							}
-							for (size_t i = delay; i < bufSize; ++i)
-								inbuf[i] = work[i - delay];
-						}
+						if (const size_t delay = delays[bufnum]; delay > 0)
+							joinbufs[bufnum] = rings[bufnum].Read(ch, delay, bufSize, inbufs[bufnum][ch]);
+						else if (bufnum == inplaceidx)
+							joinbufs[bufnum] = bufs[ch];
+						else
+							joinbufs[bufnum] = inbufs[bufnum][ch];
 					}
+					if (inplaceidx < bufsWritten)
+						std::swap(joinbufs[0], joinbufs[inplaceidx]);
 
-					JoinChannel(ch, inbufs, chbuf, bufSize, bufsWritten);
+					JoinChannel(ch, joinbufs.data(), bufs[ch], bufSize, bufsWritten);
 				}
 
+				for (size_t bufnum = 0; bufnum < bufsWritten; ++bufnum)
+					if (delays[bufnum] > 0)
+						rings[bufnum].Advance(bufSize);
+
 				return EGetInputSamplesResult::SamplesWritten;
 			}
 
@@ -229,6 +296,73 @@ namespace json2wav
 		}
 
 	private:
+		/** Power-of-2 ring holding an input's recent output, read back at a fixed offset to delay it */
+		struct DelayRing
+		{
+			/** Sized for a full block up front; a longer block later grows the ring without losing its history */
+			bool Reserve(const size_t numChannels, const size_t delay, const size_t bufSize)
+			{
+				const size_t minLength = delay + std::max(bufSize, sampleChunkNum);
+				if (buf.GetNumChannels() != numChannels)
+				{
+					buf = SampleBuf(numChannels, Utility::NextPow2(minLength), false);
+					pos = 0;
+				}
+				else if (buf.GetBufSize() < minLength)
+				{
+					// Unroll the old ring so it ends at the new write position
+					const size_t oldLength = buf.GetBufSize();
+					SampleBuf grown(numChannels, Utility::NextPow2(minLength), false);
+					if (grown.GetNumChannels() != numChannels)
+						return false;
+					for (size_t ch = 0; ch < numChannels; ++ch)
+					{
+						kernel::Copy(AsSpan(grown[ch], oldLength - pos), AsSpan(buf[ch] + pos, oldLength - pos));
+						kernel::Copy(AsSpan(grown[ch] + oldLength - pos, pos), AsSpan(buf[ch], pos));
+					}
+					buf = std::move(grown);
+					pos = oldLength;
+				}
+				return buf.GetNumChannels() == numChannels;
+			}
+
+			void Write(Sample* const* const inbufs, const size_t numChannels, const size_t bufSize) noexcept
+			{
+				const size_t length = buf.GetBufSize();
+				if (pos + bufSize <= length)
+					return;
+
+				const size_t first = length - pos;
+				for (size_t ch = 0; ch < numChannels; ++ch)
+				{
+					kernel::Copy(AsSpan(buf[ch] + pos, first), AsSpan(inbufs[ch], first));
+					kernel::Copy(AsSpan(buf[ch], bufSize - first), AsSpan(inbufs[ch] + first, bufSize - first));
+				}
+			}
+
+			Sample* Read(const size_t ch, const size_t delay, const size_t bufSize, Sample* const scratch) noexcept
+			{
+				const size_t length = buf.GetBufSize();
+				const size_t start = (pos + length - delay) & (length - 1);
+				Sample* const chbuf = buf[ch];
+				if (start + bufSize <= length)
+					return chbuf + start;
+
+				const size_t first = length - start;
+				kernel::Copy(AsSpan(scratch, first), AsSpan(chbuf + start, first));
+				kernel::Copy(AsSpan(scratch + first, bufSize - first), AsSpan(chbuf, bufSize - first));
+				return scratch;
+			}
+
+			void Advance(const size_t bufSize) noexcept
+			{
+				pos = (pos + bufSize) & (buf.GetBufSize() - 1);
+			}
+
+			SampleBuf buf;
+			size_t pos = 0;
+		};
+
 		void CalculateInputDelays() const
 		{
 			if (!bCalculatingDelay)
@@ -256,9 +390,13 @@ namespace json2wav
 			}
 		}
 
+		/** Summing joins get the first undelayed input rendered into chbuf, passed as inbufs[0] */
+		virtual bool IsSumJoin() const noexcept { return false; }
+
+		/** inbufs holds channel ch of each written input, already delay-compensated; contents may be overwritten */
 		virtual void JoinChannel(
 			const size_t ch,
-			Vector<SampleBuf>& inbufs,
+			Sample* const* const inbufs,
 			Sample* const chbuf,
 			const size_t bufSize,
 			const size_t bufsWritten) noexcept = 0;
@@ -266,8 +404,9 @@ namespace json2wav
 	private:
 		Vector<InputPtr> inputs;
 		Vector<SampleBuf> inbufs;
-		Vector<SampleBuf> dlybufs;
-		Vector<Sample> work;
+		Vector<DelayRing> rings;
+		Vector<Sample*> targets;
+		Vector<Sample*> joinbufs;
 		mutable Vector<size_t> delays;
 		mutable zeroinit_t<size_t> maxInputDelay;
 		mutable bool bCalculatingDelay = false;
@@ -278,35 +417,60 @@ namespace json2wav
 	public:
 		void JoinChannel(
 			const size_t ch,
-			Vector<SampleBuf>& inbufs,
+			Sample* const* const inbufs,
 			Sample* const chbuf,
 			const size_t bufSize,
 			const size_t bufsWritten) noexcept
 		{
-			// Pairwise summation
-			for (size_t skip = 1; skip < bufsWritten; skip <<= 1)
-			{
-				for (size_t bufnum = skip; bufnum < bufsWritten; bufnum += skip << 1)
-				{
-					Sample* const inbuflo = inbufs[bufnum - skip][ch];
-					Sample* const inbufhi = inbufs[bufnum][ch];
-					for (size_t i = 0; i < bufSize; ++i)
-						inbuflo[i] += inbufhi[i];
-				}
-			}
-			const Sample* const inbuf = inbufs[0][ch];
-			for (size_t i = 0; i < bufSize; ++i)
-				chbuf[i] = inbuf[i];
+			// Accumulate in place: one pass per input
+			const std::span<float> out(AsSpan(chbuf, bufSize));
+			if (inbufs[0] != chbuf)
+				kernel::Copy(out, AsSpan(inbufs[0], bufSize));
+			for (size_t bufnum = 1; bufnum < bufsWritten; ++bufnum)
+				kernel::Add(out, AsSpan(inbufs[bufnum], bufSize));
 		}
 	};
 
 	template<bool bOwner = false, bool bSmartPtr = true>
 	class AudioSum : public AudioJoin<bOwner, bSmartPtr>
 	{
+	protected:
+		/** Whether FastForward is active and every channel of bufs is silent */
+		static bool IsFastForwardingSilence(const Sample* const* const bufs, const size_t numChannels, const size_t bufSize) noexcept
+		{
+			if (!FastForward::IsActive())
+				return false;
+			for (size_t ch = 0; ch < numChannels; ++ch)
+				if (!kernel::IsZero(AsSpan(bufs[ch], bufSize)))
+					return false;
+			return true;
+		}
+
+		/**
+		 * For effects that, as built, turn silence into silence and are left as they were: whether the block of input in
+		 * bufs can go through untouched while fast-forwarding. Never again once any sound has come through.
+		 */
+		bool SkipAtRest(const Sample* const* const bufs, const size_t numChannels, const size_t bufSize) noexcept
+		{
+			if (!bAtRest)
+				return false;
+			for (size_t ch = 0; ch < numChannels; ++ch)
+			{
+				if (!kernel::IsZero(AsSpan(bufs[ch], bufSize)))
+				{
+					bAtRest = false;
+					return false;
+				}
+			}
+			return FastForward::IsActive();
+		}
+
 	private:
+		virtual bool IsSumJoin() const noexcept override { return true; }
+
 		virtual void JoinChannel(
 			const size_t ch,
-			Vector<SampleBuf>& inbufs,
+			Sample* const* const inbufs,
 			Sample* const chbuf,
 			const size_t bufSize,
 			const size_t bufsWritten) noexcept override
@@ -316,76 +480,106 @@ namespace json2wav
 
 	private:
 		AudioSumJoin sumjoin;
+		bool bAtRest = true;
 	};
 
+	/**
+	 * Multiplies its inputs at 2x: each one is upsampled once into flat, aligned scratch and multiplied into a running
+	 * product, which is downsampled once at the end. Filter states sit in flat per-channel rows that only grow when the
+	 * channel or input count does, so steady-state blocks don't allocate.
+	 */
 	class RingModJoin
 	{
 	public:
+		/** Samples by which the product lags its inputs: one trip up to 2x and back down */
+		static constexpr size_t GetDelay(const size_t numInputs) noexcept
+		{
+			return (numInputs > 1) ? oversampling::delay441_x2 : 0;
+		}
+
 		void JoinChannel(
 			const size_t ch,
-			Vector<SampleBuf>& inbufs,
+			Sample* const* const inbufs,
 			Sample* const chbuf,
 			const size_t bufSize,
 			const size_t bufsWritten) noexcept
+		{
+			if (bufsWritten < 2)
+			{
+				kernel::Copy(AsSpan(chbuf, bufSize), AsSpan(inbufs[0], bufSize));
+				return;
+			}
+
+			ReserveScratch(bufSize << 1);
+			double* const product = scratch.data()->x;
+			JoinChannelOversampled(ch, inbufs, product, bufSize, bufsWritten);
+			downs[ch].process_unsafe(bufSize, product, chbuf);
+		}
+
+		/** Leaves the product at 2x in productX2 (2*bufSize samples) for a caller that carries on oversampled */
+		void JoinChannelOversampled(
+			const size_t ch,
+			Sample* const* const inbufs,
+			double* const ALBUMBOT_RESTRICT productX2,
+			const size_t bufSize,
+			const size_t bufsWritten) noexcept
 		{
 			const size_t bufSizeX2 = bufSize << 1;
+			Reserve(ch + 1, bufsWritten);
+			ReserveScratch(bufSizeX2);
 
-			if (us2.size() <= ch)
+			double* const ALBUMBOT_RESTRICT upsampled = scratch.data()[scratchStride].x;
+			oversampling::upsampler441_x2<double>* const chups = ups.data() + ch * inputSlots;
+			chups[0].process_unsafe(bufSize, inbufs[0], productX2);
+			for (size_t bufnum = 1; bufnum < bufsWritten; ++bufnum)
 			{
-				us2.resize(ch + 1);
-				ds2.resize(ch + 1);
+				chups[bufnum].process_unsafe(bufSize, inbufs[bufnum], upsampled);
+				for (size_t i = 0; i < bufSizeX2; ++i)
+					productX2[i] *= upsampled[i];
 			}
+		}
+
+	private:
+		static constexpr const size_t scratchLineSize = 8;
+
+		struct alignas(64) ScratchLine
+		{
+			double x[scratchLineSize];
+		};
 
-			if (worklo.size() < bufSizeX2)
+		void Reserve(const size_t numChannels, const size_t numInputs)
+		{
+			if (numChannels > downs.size() || numInputs > inputSlots)
 			{
-				worklo.resize(bufSizeX2);
-				workhi.resize(bufSizeX2);
+				// Move each channel's filter states into the wider rows so nothing restarts
+				const size_t newSlots = std::max(numInputs, inputSlots);
+				const size_t newChannels = std::max(numChannels, downs.size());
+				Vector<oversampling::upsampler441_x2<double>> grown(newChannels * newSlots);
+				for (size_t c = 0; c < downs.size(); ++c)
+					for (size_t k = 0; k < inputSlots; ++k)
+						grown[c * newSlots + k] = ups[c * inputSlots + k];
+				ups = std::move(grown);
+				inputSlots = newSlots;
+				downs.resize(newChannels);
 			}
+		}
 
-			// Upsampled x2 pairwise multiplication
-			double* const workbuflo = worklo.data();
-			double* const workbufhi = workhi.data();
-			auto& chus(us2[ch]);
-			auto& chds(ds2[ch]);
-			for (size_t skip = 1, dsidx = 0; skip < bufsWritten; skip <<= 1, ++dsidx)
+		void ReserveScratch(const size_t bufSizeX2)
+		{
+			const size_t stride = (bufSizeX2 + scratchLineSize - 1) / scratchLineSize;
+			if (stride > scratchStride)
 			{
-				const size_t usidxlo = dsidx << 1;
-				const size_t usidxhi = usidxlo + 1;
-				if (chus.size() <= usidxhi)
-					chus.resize(usidxhi + 1);
-				if (chds.size() <= dsidx)
-					chds.resize(dsidx + 1);
-				auto& vuslo(chus[usidxlo]);
-				auto& vushi(chus[usidxhi]);
-				auto& vds(chds[dsidx]);
-				for (size_t bufnum = skip, osidx = 0; bufnum < bufsWritten; bufnum += skip << 1, ++osidx)
-				{
-					Sample* const inbuflo = inbufs[bufnum - skip][ch];
-					Sample* const inbufhi = inbufs[bufnum       ][ch];
-					if (vuslo.size() <= osidx)
-					{
-						vuslo.resize(osidx + 1);
-						vushi.resize(osidx + 1);
-						vds.resize(osidx + 1);
-					}
-					vuslo[osidx].process_unsafe(bufSize, inbuflo, workbuflo);
-					vushi[osidx].process_unsafe(bufSize, inbufhi, workbufhi);
-					for (size_t i = 0; i < bufSizeX2; ++i)
-						workbuflo[i] *= workbufhi[i];
-					vds[osidx].process_unsafe(bufSize, workbuflo, inbuflo);
-				}
+				scratchStride = stride;
+				scratch.resize(2 * stride);
 			}
-
-			const Sample* const inbuf = inbufs[0][ch];
-			for (size_t i = 0; i < bufSize; ++i)
-				chbuf[i] = inbuf[i];
 		}
 
 	private:
-		Vector<double> worklo;
-		Vector<double> workhi;
-		Vector<Vector<Vector<oversampling::upsampler441_x2<double>>>> us2;
-		Vector<Vector<Vector<oversampling::downsampler441_x2<double>>>> ds2;
+		Vector<oversampling::upsampler441_x2<double>> ups; // [channel][input], inputSlots per channel
+		Vector<oversampling::downsampler441_x2<double>> downs; // [channel]
+		Vector<ScratchLine> scratch; // The product, then the upsampled input, scratchStride lines each
+		size_t inputSlots = 0;
+		size_t scratchStride = 0;
 	};
 
 	template<bool bOwner = false, bool bSmartPtr = true>
@@ -394,13 +588,13 @@ namespace json2wav
 	public:
 		virtual size_t GetSampleDelay() const noexcept override
 		{
-			return AudioJoin<bOwner, bSmartPtr>::GetSampleDelay() + Utility::ceil_log2(this->GetInputs().size())*128;
+			return AudioJoin<bOwner, bSmartPtr>::GetSampleDelay() + RingModJoin::GetDelay(this->GetInputs().size());
 		}
 
 	private:
 		virtual void JoinChannel(
 			const size_t ch,
-			Vector<SampleBuf>& inbufs,
+			Sample* const* const inbufs,
 			Sample* const chbuf,
 			const size_t bufSize,
 			const size_t bufsWritten) noexcept override
@@ -418,7 +612,7 @@ namespace json2wav
 	public:
 		virtual size_t GetSampleDelay() const noexcept override
 		{
-			return AudioJoin<bOwner, bSmartPtr>::GetSampleDelay() + Utility::ceil_log2(this->GetInputs().size())*128;
+			return AudioJoin<bOwner, bSmartPtr>::GetSampleDelay() + RingModJoin::GetDelay(this->GetInputs().size());
 		}
 
 		void SetBalance(const float balanceVal)
@@ -434,38 +628,57 @@ namespace json2wav
 	private:
 		virtual void JoinChannel(
 			const size_t ch,
-			Vector<SampleBuf>& inbufs,
+			Sample* const* const inbufs,
 			Sample* const chbuf,
 			const size_t bufSize,
 			const size_t bufsWritten) noexcept override
 		{
-			if (ch >= sumDelays.size())
-				sumDelays.resize(ch + 1);
-			Vector<Sample>& sumdly = sumDelays[ch];
-			const size_t dlylen = Utility::ceil_log2(inbufs.size())*128;
-			if (sumdly.size() < dlylen)
-				sumdly.resize(dlylen);
-			inbufsCopy = inbufs;
-			sumbuf.Reinitialize(1, bufSize);
+			// The sum lands after the previous block's tail, so reading from the start of the line delays it to match the ring mod
+			const size_t dlylen = RingModJoin::GetDelay(this->GetInputs().size());
+			Sample* const line = ReserveSumLine(ch, dlylen, bufSize);
+			sumjoin.JoinChannel(ch, inbufs, line + dlylen, bufSize, bufsWritten);
 			rmjoin.JoinChannel(ch, inbufs, chbuf, bufSize, bufsWritten);
-			Sample* const sumout = sumbuf[0];
-			sumjoin.JoinChannel(ch, inbufsCopy, sumout, bufSize, bufsWritten);
+
 			const float rmamp = 0.5f - 0.5f*(*balance); // -1 is all ring mod; 1 is no ring mod
 			const float sumamp = 0.5f + 0.5f*(*balance); // 1 is all sum; -1 is no sum
-			for (size_t i = 0; i < dlylen; ++i)
-				chbuf[i] = rmamp*chbuf[i] + sumamp*sumdly[i];
-			for (size_t i = dlylen; i < bufSize; ++i)
-				chbuf[i] = rmamp*chbuf[i] + sumamp*sumout[i - dlylen];
-			for (size_t i = 0; i < dlylen; ++i)
-				sumdly[i] = sumout[bufSize - dlylen + i];
+			const std::span<float> out(AsSpan(chbuf, bufSize));
+			kernel::Gain(out, rmamp);
+			kernel::AddGain(out, AsSpan(line, bufSize), sumamp);
+			std::copy_n(line + bufSize, dlylen, line);
+		}
+
+		/** Channel ch's delay line: dlylen samples of the last sum's tail, then room for bufSize more */
+		Sample* ReserveSumLine(const size_t ch, const size_t dlylen, const size_t bufSize)
+		{
+			if (dlylen != sumDelay)
+			{
+				sumLines.clear();
+				sumLineStride = 0;
+				sumDelay = dlylen;
+			}
+
+			if (dlylen + bufSize > sumLineStride)
+			{
+				const size_t stride = dlylen + bufSize;
+				const size_t numLines = (sumLineStride > 0) ? sumLines.size() / sumLineStride : 0;
+				Vector<Sample> grown(numLines * stride);
+				for (size_t line = 0; line < numLines; ++line)
+					std::copy_n(sumLines.data() + line * sumLineStride, dlylen, grown.data() + line * stride);
+				sumLines = std::move(grown);
+				sumLineStride = stride;
+			}
+
+			if (sumLines.size() < (ch + 1) * sumLineStride)
+				sumLines.resize((ch + 1) * sumLineStride);
+			return sumLines.data() + ch * sumLineStride;
 		}
 
 	private:
 		RingModJoin rmjoin;
 		AudioSumJoin sumjoin;
-		Vector<SampleBuf> inbufsCopy;
-		SampleBuf sumbuf;
-		Vector<Vector<Sample>> sumDelays;
+		Vector<Sample> sumLines; // [channel][sumLineStride]
+		size_t sumLineStride = 0;
+		size_t sumDelay = 0;
 		zeroinit_t<float> balance;
 	};
 
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "Memory.h"
+#include "BlockScratch.h"
 
 #ifdef ALBUMBOT_DEBUGNEW
 #include "StdMapWrapper.h"
@@ -390,9 +391,10 @@ namespace json2wav
 			return foundevents->second;
 		}
 
-		Vector<size_t> GetEventKeysInRange(const size_t start, const size_t end) const
+		/** Keys are in block scratch memory while rendering; see BlockScratch */
+		ScratchVector<size_t> GetEventKeysInRange(const size_t start, const size_t end) const
 		{
-			Vector<size_t> keys;
+			ScratchVector<size_t> keys(BlockScratch::Get());
 
 			if (start < end)
 			{
@@ -420,6 +422,25 @@ namespace json2wav
 			bRefreshEvents = true;
 		}
 
+		/** Sample number of the first pending event in [start, end), or end if there is none */
+		size_t GetNextEventKey(const size_t start, const size_t end) const
+		{
+			const auto it = GetEventsMap().lower_bound(start);
+			return (it != GetEventsMap().end() && it->first < end) ? it->first : end;
+		}
+
+		/** For a node that runs this object from its own loop (see FusedPointwise): fires the events at the current sample */
+		void TriggerCurrentEvents()
+		{
+			TriggerEvents(currentSampleNum);
+		}
+
+		/** For a node that runs this object from its own loop: moves past samples it has processed */
+		void SkipSamples(const size_t deltasamples) noexcept
+		{
+			IncrementSampleNum(deltasamples);
+		}
+
 	protected:
 		void SetSampleNum(const size_t newSampleNum) noexcept
 		{
@@ -433,9 +454,22 @@ namespace json2wav
 
 		template<typename ProcSampFunc>
 		void ProcessEvents(const size_t numSamples, ProcSampFunc&& ProcessSample)
+		{
+			ProcessEventSpans(numSamples, [&ProcessSample](const size_t start, const size_t count)
+				{
+					for (size_t i = start; i < start + count; ++i)
+					{
+						ProcessSample(i);
+					}
+				});
+		}
+
+		/** Like ProcessEvents, but hands ProcessSpan(start, count) each run of samples between events at once */
+		template<typename ProcSpanFunc>
+		void ProcessEventSpans(const size_t numSamples, ProcSpanFunc&& ProcessSpan)
 		{
 			const size_t sampleNum = GetSampleNum();
-			Vector<size_t> eventkeys(GetEventKeysInRange(sampleNum, sampleNum + numSamples));
+			ScratchVector<size_t> eventkeys(GetEventKeysInRange(sampleNum, sampleNum + numSamples));
 			size_t keyIdx = 0;
 
 			for (size_t i = 0, n = sampleNum; i < numSamples; )
@@ -448,9 +482,11 @@ namespace json2wav
 				}
 
 				const size_t k = (eventkeys.size() > keyIdx) ? eventkeys[keyIdx] : sampleNum + numSamples;
-				for ( ; n < k; ++n, ++i)
+				if (n < k)
 				{
-					ProcessSample(i);
+					ProcessSpan(i, k - n);
+					i += k - n;
+					n = k;
 				}
 
 				if (eventkeys.size() > keyIdx)
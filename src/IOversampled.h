@@ -0,0 +1,31 @@
+// Copyright Dan Price 2026.
+
+#pragma once
+
+#include <cstddef>
+
+namespace json2wav
+{
+	/**
+	 * A node whose nonlinear processing runs at twice the sample rate, between an oversampling::upsampler441_x2 and a
+	 * downsampler441_x2. An OversampledIsland runs several of them back to back at 2x with one trip up and down.
+	 */
+	class IOversampledX2
+	{
+	public:
+		virtual ~IOversampledX2() noexcept {}
+
+		/** Whether ProcessOversampled can stand in for GetSamples with the node's current settings */
+		virtual bool CanProcessOversampled() const noexcept = 0;
+
+		/** Processes numSamples samples' worth of input already at 2x, 2*numSamples per channel, in place */
+		virtual void ProcessOversampled(
+			double* const* const bufsX2,
+			const size_t numChannels,
+			const size_t numSamples,
+			const unsigned long sampleRate) noexcept = 0;
+
+		/** Delay ProcessOversampled adds at the base rate, on top of the island's trip up and down */
+		virtual size_t GetOversampledDelay() const noexcept = 0;
+	};
+}
@@ -5,6 +5,7 @@
 #include "Synth.h"
 #include "CircleQueue.h"
 #include "Memory.h"
+#include "BlockScratch.h"
 #include "FastSin.h"
 #include "InfiniSaw.gen.h"
 #include <utility>
@@ -185,7 +186,7 @@ namespace json2wav
 		{
 			if (jumps.empty())
 				return;
-			Vector<double> buf64;
+			ScratchVector<double> buf64(BlockScratch::Get());
 			buf64.reserve(numSamples);
 			for (size_t i = 0; i < numSamples; ++i)
 				buf64.push_back(static_cast<double>(buf[i].AsFloat32()));
@@ -328,13 +329,12 @@ namespace json2wav
 			}
 
 			Sample* const buf = bufs[0];
-			Vector<double> buf64;
-			buf64.resize(numSamples, 0.0);
+			ScratchVector<double> buf64(numSamples, 0.0, BlockScratch::Get());
 			buf_amp_cache.clear();
 			buf_amp_cache.reserve(numSamples);
 			const double deltaTime = 1.0 / static_cast<double>(sampleRate);
-			Vector<std::pair<size_t, std::pair<double, float>>> sampleStreamJumps;
-			GetSynthSamples(bufs, numChannels, numSamples, false, [this, &buf64, /*sampleRate,*/ deltaTime, &sampleStreamJumps](const size_t i)
+			ScratchVector<std::pair<size_t, std::pair<double, float>>> sampleStreamJumps(BlockScratch::Get());
+			GetSynthSamples(bufs, numChannels, numSamples, false, deltaTime, [this, &buf64, /*sampleRate,*/ deltaTime, &sampleStreamJumps](const size_t i)
 				{
 					CHECK_NEAR_SPIKE(i);
 
@@ -454,6 +454,43 @@ namespace json2wav
 		}
 
 	private:
+		/**
+		 * Steps the waveform exactly as rendering would, lookahead included, but computes no jumps and applies no bleps.
+		 * Blep residue due from before the skip is dropped, which only touches the first few samples after it.
+		 */
+		virtual bool SkipSamples(const size_t numSamples, const double deltaTime) noexcept override
+		{
+			ProcessEvents(numSamples, [this, deltaTime](const size_t i)
+				{
+					double waveformPhase;
+					float amp;
+					float freq;
+					GetNextWaveformSample(nullptr, deltaTime, waveformPhase, amp, freq);
+					const auto foundit = std::find(hardSyncs.begin(), hardSyncs.end(), i);
+					if (foundit != hardSyncs.end())
+					{
+						SetPhase(PreciseRamp(0.0, 1.0f, ERampShape::Instant));
+					}
+					PeekNextWaveformSample(nullptr, deltaTime, waveformPhase, amp, freq);
+					if (foundit != hardSyncs.end())
+					{
+						hardSyncs.erase(foundit);
+					}
+				});
+
+#if defined(INFINISAW_ANTIALIAS) && INFINISAW_ANTIALIAS
+			double waveformPhase;
+			float amp;
+			float freq;
+			PeekNextWaveformSample(nullptr, deltaTime, waveformPhase, amp, freq, blep_peek);
+			while (!antiAliasQueue.empty())
+			{
+				antiAliasQueue.pop_idx();
+			}
+#endif
+			return true;
+		}
+
 		float GetAmpAtBufIdx(const size_t buf_idx) const
 		{
 			return buf_amp_cache[buf_idx];
@@ -584,12 +621,12 @@ namespace json2wav
 			return wavePos;
 		}
 
-		void GetJumpsInPhaseRange(const double phase1, const double phase2, const size_t smpnum, const double smpval, const bool bHardSync, Vector<std::pair<size_t, std::pair<double, float>>>& sampleStreamJumps)
+		void GetJumpsInPhaseRange(const double phase1, const double phase2, const size_t smpnum, const double smpval, const bool bHardSync, ScratchVector<std::pair<size_t, std::pair<double, float>>>& sampleStreamJumps)
 		{
 			GetJumpsInPhaseRange(phase1, phase2, smpnum, static_cast<float>(smpval), bHardSync, sampleStreamJumps);
 		}
 
-		void GetJumpsInPhaseRange(const double phase1, const double phase2, const size_t smpnum, const float smpval, const bool bHardSync, Vector<std::pair<size_t, std::pair<double, float>>>& sampleStreamJumps)
+		void GetJumpsInPhaseRange(const double phase1, const double phase2, const size_t smpnum, const float smpval, const bool bHardSync, ScratchVector<std::pair<size_t, std::pair<double, float>>>& sampleStreamJumps)
 		{
 			if (phase1 < 0.0)
 			{
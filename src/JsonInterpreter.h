@@ -20,7 +20,12 @@
 #include "Compressor.h"
 #include "FDNVerb.h"
 #include "MSProc.h"
+#include "FusedPointwise.h"
+#include "OversampledIsland.h"
 #include "Memory.h"
+#include "Random.h"
+#include "StemCache.h"
+#include "NodeNames.h"
 #include <string>
 #include <utility>
 #include <iostream>
@@ -424,6 +429,7 @@ namespace json2wav
 			bool bNoteAmpsDB;
 			size_t numDuplications;
 			double transpose;
+			uint64_t stemKey = 0;
 		};
 
 		struct BusData
@@ -490,6 +496,30 @@ namespace json2wav
 			wav.AddInput(mainout->volume);
 		}
 
+		/** Renders without writing the WAV, recording what the render cost in stats */
+		void SetRenderStats(RenderStats* const stats) noexcept
+		{
+			wav.SetRenderStats(stats);
+		}
+
+		/** Renders only the given window of the song */
+		void SetRenderRange(const RenderRange* const range) noexcept
+		{
+			wav.SetRenderRange(range);
+		}
+
+		/** Renders the song as one of segmentRender's copies */
+		void SetSegmentRender(SegmentRender* const segmentRender) noexcept
+		{
+			wav.SetSegmentRender(segmentRender);
+		}
+
+		/** Plays unchanged parts and busses from cache and records the rest into it */
+		void SetStemCache(StemCache* const cache) noexcept
+		{
+			stemCache = cache;
+		}
+
 	private:
 		JsonInterpreterType(JsonInterpreterType& parent)
 			: mode(nullptr),
@@ -502,7 +532,11 @@ namespace json2wav
 			partdatas(parent.partdatas),
 			mainout(parent.mainout),
 			currentbus(mainout),
-			bIsChild(true)
+			bIsChild(true),
+			stemCache(parent.stemCache)
+#ifdef ALBUMBOT_NODE_NAMES
+			, jsonpath(parent.jsonpath)
+#endif
 		{
 			mode = &top;
 			top.NoOutput();
@@ -511,15 +545,15 @@ namespace json2wav
 		}
 
 	private:
-		virtual void OnPushNode(std::string&& nodekey) override { mode->OnPushNode(std::move(nodekey)); }
-		virtual void OnPushNode() override { mode->OnPushNode(); }
-		virtual void OnNextNode(std::string&& nodekey) override { mode->OnNextNode(std::move(nodekey)); }
-		virtual void OnNextNode() override { mode->OnNextNode(); }
-		virtual void OnPopNode() override { mode->OnPopNode(); }
-		virtual void OnString(std::string&& value) override { mode->OnString(std::move(value)); }
-		virtual void OnNumber(double value) override { mode->OnNumber(value); }
-		virtual void OnBool(bool value) override { mode->OnBool(value); }
-		virtual void OnNull() override { mode->OnNull(); }
+		virtual void OnPushNode(std::string&& nodekey) override { PathPush(nodekey); StemHash(StemCache::PushKey, nodekey); mode->OnPushNode(std::move(nodekey)); }
+		virtual void OnPushNode() override { PathPush(); StemHash(StemCache::PushIndex); mode->OnPushNode(); }
+		virtual void OnNextNode(std::string&& nodekey) override { PathNext(nodekey); StemHash(StemCache::NextKey, nodekey); mode->OnNextNode(std::move(nodekey)); }
+		virtual void OnNextNode() override { PathNext(); StemHash(StemCache::NextIndex); mode->OnNextNode(); }
+		virtual void OnPopNode() override { PathPop(); StemHash(StemCache::Pop); mode->OnPopNode(); }
+		virtual void OnString(std::string&& value) override { StemHash(StemCache::String, value); mode->OnString(std::move(value)); }
+		virtual void OnNumber(double value) override { StemHash(StemCache::Number, value); mode->OnNumber(value); }
+		virtual void OnBool(bool value) override { StemHash(StemCache::Bool, uint64_t(value)); mode->OnBool(value); }
+		virtual void OnNull() override { StemHash(StemCache::Null); mode->OnNull(); }
 
 	private:
 		class InterpreterMode : public IJsonWalker
@@ -533,6 +567,121 @@ namespace json2wav
 			JsonInterpreter& rthis;
 		};
 
+#ifdef ALBUMBOT_NODE_NAMES
+		void PathPush(const std::string& nodekey) { SongSeed::PathPush(nodekey); jsonpath.emplace_back(nodekey, std::string::npos); }
+		void PathPush() { SongSeed::PathPush(); jsonpath.emplace_back(std::string(), 0); }
+		void PathNext(const std::string& nodekey) { SongSeed::PathNext(nodekey); if (!jsonpath.empty()) jsonpath.back().first = nodekey; }
+		void PathNext() { SongSeed::PathNext(); if (!jsonpath.empty()) ++jsonpath.back().second; }
+		void PathPop() { SongSeed::PathPop(); if (!jsonpath.empty()) jsonpath.pop_back(); }
+
+		/** Path of the value being walked, e.g. mixer/busses[0]/fx[1]; cut after the last element of array "through" */
+		std::string JsonPath(const char* const through = nullptr) const
+		{
+			size_t numSegments = jsonpath.size();
+			if (through)
+			{
+				for (size_t seg = jsonpath.size(); seg > 0; --seg)
+				{
+					if (jsonpath[seg - 1].first == through)
+					{
+						const bool bArray = seg < jsonpath.size() && jsonpath[seg].second != std::string::npos;
+						numSegments = bArray ? seg + 1 : seg;
+						break;
+					}
+				}
+			}
+
+			std::string path;
+			for (size_t seg = 0; seg < numSegments; ++seg)
+			{
+				if (jsonpath[seg].second != std::string::npos)
+					path += '[' + std::to_string(jsonpath[seg].second) + ']';
+				else
+					path += (path.empty() ? "" : "/") + jsonpath[seg].first;
+			}
+			return path;
+		}
+
+		template<typename NodeType>
+		void ProfileLabel(const SharedPtr<NodeType>& node, const char* const through)
+		{
+			NodeNames::Label(node.get(), JsonPath(through));
+		}
+#else
+		void PathPush(const std::string& nodekey) { SongSeed::PathPush(nodekey); }
+		void PathPush() { SongSeed::PathPush(); }
+		void PathNext(const std::string& nodekey) { SongSeed::PathNext(nodekey); }
+		void PathNext() { SongSeed::PathNext(); }
+		void PathPop() { SongSeed::PathPop(); }
+
+		template<typename NodeType>
+		void ProfileLabel(const SharedPtr<NodeType>&, const char* const) {}
+#endif
+
+		template<typename... ArgTypes>
+		void StemHash(const StemCache::EEvent event, const ArgTypes&... args) noexcept
+		{
+			if (stemCache)
+				stemCache->HashEvent(event, args...);
+		}
+
+		void StemBegin()
+		{
+			if (stemCache)
+				stemCache->BeginSubtree();
+		}
+
+		uint64_t StemEnd() noexcept
+		{
+			return stemCache ? stemCache->EndSubtree() : 0;
+		}
+
+		/** Puts a stem under every bus, keyed by its place in the mixer and the keys of everything feeding it */
+		uint64_t InsertBusStems(BusData& bus, const uint64_t busId)
+		{
+			uint64_t busKey = stemCache->BusKey(samplerate, busId);
+			for (size_t busidx = 0; busidx < bus.busses.size(); ++busidx)
+				busKey = HashMix(busKey, InsertBusStems(*bus.busses[busidx], HashMix(busId, busidx + 1)));
+			for (const PartData& partdata : partdatas)
+				for (const SharedPtr<BusData>& output : partdata.outputs)
+					if (output.get() == &bus)
+						busKey = HashMix(busKey, partdata.stemKey);
+			stemCache->Insert(*bus.volume, busKey);
+			return busKey;
+		}
+
+#if ALBUMBOT_FUSE_POINTWISE || ALBUMBOT_OVERSAMPLED_ISLANDS
+		/** Fuses runs in the effect chains under bus, then in every part's chain if bus is the main out */
+		void FuseEffectChains(BusData& bus)
+		{
+			FuseEffectChain(bus.effects, bus.volume);
+			for (const SharedPtr<BusData>& child : bus.busses)
+				if (child)
+					FuseEffectChains(*child);
+
+			if (&bus != mainout.get())
+				return;
+
+			for (PartData& partdata : partdatas)
+			{
+				if (partdata.outputMult)
+					FuseEffectChain(partdata.effects, partdata.outputMult);
+				else if (!partdata.outputFaders.empty())
+					FuseEffectChain(partdata.effects, partdata.outputFaders[0]);
+			}
+		}
+
+		static void FuseEffectChain(Vector<SharedPtr<AudioJoin<>>>& effects, const SharedPtr<AudioJoin<>>& output)
+		{
+#if ALBUMBOT_FUSE_POINTWISE
+			FusePointwiseChain(effects, output);
+#endif
+#if ALBUMBOT_OVERSAMPLED_ISLANDS
+			FuseOversampledChain(effects, output);
+#endif
+		}
+#endif
+
 		void PushMode(InterpreterMode* const nextmode, std::function<void(void*)> callback)
 		{
 			modestack.push_back(std::make_pair(mode, std::move(callback)));
@@ -665,9 +814,21 @@ namespace json2wav
 			void OnNode(std::string&& nodekey)
 			{
 				if (nodekey == "meta")
+				{
 					this->rthis.mode = &this->rthis.meta;
+					this->rthis.StemBegin();
+				}
 				else if (nodekey == "mixer")
-					this->rthis.mode = &this->rthis.mixer;
+				{
+					// Bus effects draw their seeds as they're built, so the song's seed has to be known by then
+					if (!this->rthis.meta.Visited())
+						this->error("Meta must come before mixer");
+					else
+					{
+						this->rthis.mode = &this->rthis.mixer;
+						this->rthis.StemBegin();
+					}
+				}
 				else if (nodekey == "parts")
 					if (!this->rthis.meta.Visited())
 						this->error("Meta must come before parts");
@@ -691,22 +852,34 @@ namespace json2wav
 #ifdef ALBUMBOT_DEBUGNEW
 					{
 						const double maptime = QueryMapTime();
-						std::cout << "Spent " << maptime << " seconds in std::map so far\n";
+						std::cerr << "Spent " << maptime << " seconds in std::map so far\n";
 						json2wav::PrintAllocTimes("just before rendering wav");
 					}
 #endif
 					const unsigned long sr = this->rthis.samplerate;
 					const unsigned long songlen = (unsigned long)std::ceil(static_cast<float>(sr) * this->rthis.timelen) + sr;
+					const size_t numSamples = songlen + sampleChunkNum - (songlen % sampleChunkNum);
+#if ALBUMBOT_FUSE_POINTWISE || ALBUMBOT_OVERSAMPLED_ISLANDS
+					this->rthis.FuseEffectChains(*this->rthis.mainout);
+#endif
+					StemCache* const stemCache = this->rthis.stemCache;
+					if (stemCache)
+					{
+						this->rthis.InsertBusStems(*this->rthis.mainout, 0);
+						stemCache->Prepare(numSamples);
+					}
 					this->rthis.wav.Write(
 						(this->rthis.name + ".wav").c_str(),
-						songlen + sampleChunkNum - (songlen % sampleChunkNum),
+						numSamples,
 						this->rthis.samplerate,
 						ESampleType::Int16);
+					if (stemCache)
+						stemCache->Commit();
 #ifdef ALBUMBOT_DEBUGNEW
 					{
 						json2wav::PrintAllocTimes("just after rendering wav");
 						const double maptime = QueryMapTime();
-						std::cout << "Spent " << maptime << " seconds in std::map while rendering wav\n";
+						std::cerr << "Spent " << maptime << " seconds in std::map while rendering wav\n";
 					}
 #endif
 				}
@@ -721,7 +894,7 @@ namespace json2wav
 		public:
 			Meta(JsonInterpreter& rthisInit, InterpreterMode* const pupInit)
 				: NonErrorMode(rthisInit, pupInit),
-				name(rthisInit, this), tempo(rthisInit, this), key(rthisInit, this),
+				name(rthisInit, this), tempo(rthisInit, this), key(rthisInit, this), seed(rthisInit, this),
 				bVisited(false)
 			{
 			}
@@ -742,6 +915,8 @@ namespace json2wav
 					this->rthis.mode = &tempo;
 				else if (nodekey == "key")
 					this->rthis.mode = &key;
+				else if (nodekey == "seed")
+					this->rthis.mode = &seed;
 				// Meta can contain anything, so no invalid keys, but tempo and key are required
 			}
 
@@ -752,6 +927,8 @@ namespace json2wav
 			{
 				bVisited = true;
 				this->up();
+				if (const uint64_t metaHash = this->rthis.StemEnd(); this->rthis.stemCache && !this->rthis.bIsChild)
+					this->rthis.stemCache->SetMetaHash(metaHash);
 				if (this->rthis.name.empty())
 					this->rthis.name = "music";
 				if (this->rthis.beatlen == 0.0)
@@ -818,10 +995,35 @@ namespace json2wav
 				}
 			};
 
+			class SongSeedParam : public NonErrorMode
+			{
+			public:
+				SongSeedParam(JsonInterpreter& rthisInit, InterpreterMode* const pupInit)
+					: NonErrorMode(rthisInit, pupInit)
+				{
+				}
+
+			private:
+				virtual std::string ModeName() const override { return "Meta::Seed"; }
+
+			private:
+				virtual void OnNumber(double value) override
+				{
+					if (!(value >= 0.0 && value < 18446744073709551616.0) || value != std::floor(value))
+						this->error("Seed must be a non-negative integer");
+					else
+					{
+						SongSeed::SetSeed(static_cast<uint64_t>(value));
+						this->up();
+					}
+				}
+			};
+
 		private:
 			Name name;
 			Tempo tempo;
 			Key key;
+			SongSeedParam seed;
 
 		private:
 			bool bVisited;
@@ -848,6 +1050,9 @@ namespace json2wav
 			virtual void OnPopNode() override
 			{
 				bVisited = true;
+				this->rthis.ProfileLabel(this->rthis.currentbus->volume, "mixer");
+				if (const uint64_t mixerHash = this->rthis.StemEnd(); this->rthis.stemCache && !this->rthis.bIsChild)
+					this->rthis.stemCache->SetMixerHash(mixerHash);
 				this->up();
 			}
 
@@ -879,7 +1084,10 @@ namespace json2wav
 					{
 						this->rthis.PushMode(&this->rthis.effects, [](void*) {});
 						this->rthis.addEffect = [this](SharedPtr<AudioJoin<>> effect)
-							{ this->rthis.currentbus->AddEffect(std::move(effect)); };
+							{
+								this->rthis.ProfileLabel(effect, "fx");
+								this->rthis.currentbus->AddEffect(std::move(effect));
+							};
 					}
 					else if (nodekey == "busses")
 						this->rthis.PushMode(&this->rthis.mixer.busses, [](void*) {});
@@ -935,6 +1143,7 @@ namespace json2wav
 				{
 					this->rthis.currentbus->AddBus();
 					this->rthis.currentbus = this->rthis.currentbus->busses.back();
+					this->rthis.ProfileLabel(this->rthis.currentbus->volume, "busses");
 				}
 
 				void OnNode()
@@ -992,6 +1201,7 @@ namespace json2wav
 			virtual void OnPushNode(std::string&& nodekey) override
 			{
 				this->rthis.mode = &part;
+				this->rthis.StemBegin();
 				if (this->rthis.partdatas.size() == 0)
 				{
 					auto emplacepair = partdatamap.emplace(std::make_pair(nodekey, 0));
@@ -1009,6 +1219,7 @@ namespace json2wav
 			virtual void OnPushNode() override
 			{
 				this->rthis.mode = &part;
+				this->rthis.StemBegin();
 				if (this->rthis.partdatas.size() == 0)
 					this->rthis.partdatas.emplace_back();
 				// Otherwise a preset
@@ -1016,6 +1227,7 @@ namespace json2wav
 			virtual void OnNextNode(std::string&& nodekey) override
 			{
 				this->rthis.mode = &part;
+				this->rthis.StemBegin();
 				auto emplacepair = partdatamap.emplace(std::make_pair(nodekey, this->rthis.partdatas.size()));
 				if (emplacepair.second)
 				{
@@ -1028,6 +1240,7 @@ namespace json2wav
 			virtual void OnNextNode() override
 			{
 				this->rthis.mode = &part;
+				this->rthis.StemBegin();
 				this->rthis.partdatas.emplace_back();
 			}
 			virtual void OnPopNode() override
@@ -1066,6 +1279,7 @@ namespace json2wav
 						this->rthis.PushMode(&this->rthis.effects, [](void*) {});
 						this->rthis.addEffect = [this](SharedPtr<AudioJoin<>> effect)
 						{
+							this->rthis.ProfileLabel(effect, "fx");
 							this->rthis.partdatas.back().effectsToAdd.emplace_back(std::move(effect));
 						};
 					}
@@ -1081,6 +1295,7 @@ namespace json2wav
 				virtual void OnPopNode() override
 				{
 					this->up();
+					const uint64_t partHash = this->rthis.StemEnd();
 					if (this->rthis.bIsChild)
 						return;
 
@@ -1192,6 +1407,27 @@ namespace json2wav
 						if (const float partend = endtime + synth->GetRelease(); partend > this->rthis.timelen)
 							this->rthis.timelen = partend;
 					}
+
+					if (StemCache* const stemCache = this->rthis.stemCache)
+					{
+						partdata.stemKey = stemCache->PartKey(this->rthis.samplerate, partHash);
+						stemCache->Insert(*outnode, partdata.stemKey);
+					}
+
+#ifdef ALBUMBOT_NODE_NAMES
+					{
+						const std::string partpath(this->rthis.JsonPath());
+						for (size_t outidx = 0; outidx < partdata.outputFaders.size(); ++outidx)
+							NodeNames::Label(partdata.outputFaders[outidx].get(), partpath + "/outputs[" + std::to_string(outidx) + "]");
+						NodeNames::Label(partdata.outputMult.get(), partpath + "/outputs");
+						size_t synthidx = 0;
+						for (auto& synth : partdata.instrument)
+						{
+							const SharedPtr<IAudioObject> synthnode(synth);
+							NodeNames::Label(synthnode.get(), partpath + "/instrument[" + std::to_string(synthidx++) + "]");
+						}
+					}
+#endif
 				}
 
 			private:
@@ -3329,6 +3565,7 @@ namespace json2wav
 			static constexpr const uint64_t ParamReleaseBit = 0x1000;
 			static constexpr const uint64_t ParamStereoLinkBit = 0x2000;
 			static constexpr const uint64_t ParamDryVolumeBit = 0x4000;
+			static constexpr const uint64_t ParamDecimationBit = 0x8000;
 
 			static constexpr const uint64_t ParamsNone = 0;
 			static constexpr const uint64_t ParamsFreq = ParamFreqBit;
@@ -3355,7 +3592,7 @@ namespace json2wav
 			static constexpr const uint64_t ParamsDelay = ParamDelayBit;
 			static constexpr const uint64_t ParamsFeedback = ParamFeedbackBit;
 			static constexpr const uint64_t ParamsDelayFeedback = ParamDelayBit | ParamFeedbackBit;
-			static constexpr const uint64_t ParamsCompressor = 0x7f00;
+			static constexpr const uint64_t ParamsCompressor = 0xff00;
 
 			static constexpr const uint64_t EffectsParams[static_cast<size_t>(EValidEffects::NUM)] = {
 				ParamFreqBit | ParamQBit | ParamTopoBit, // BiquadLP
@@ -3459,6 +3696,7 @@ namespace json2wav
 					attack_ms(0.0),
 					release_ms(0.0),
 					dryVolume_db(0.0),
+					decimation(0.0),
 					bLink(false),
 					paramsSet(0ull)
 				{
@@ -3682,6 +3920,17 @@ namespace json2wav
 						else
 							this->InvalidKeyError(std::move(nodekey));
 					}
+					else if (nodekey == "decimation" || nodekey == "controldecimation")
+					{
+						if (EffectsParams[static_cast<size_t>(eEffect)] & ParamDecimationBit)
+							this->rthis.PushMode(&this->rthis.paramNum, [this](void* pvalue)
+								{
+									decimation = *static_cast<double*>(pvalue);
+									paramsSet |= ParamDecimationBit;
+								});
+						else
+							this->InvalidKeyError(std::move(nodekey));
+					}
 					else if (nodekey == "link" || nodekey == "stereolink")
 					{
 						if (EffectsParams[static_cast<size_t>(eEffect)] & ParamStereoLinkBit)
@@ -3979,33 +4228,26 @@ namespace json2wav
 						{
 							this->error("Must specify delay amount");
 						}
+						else if (!(paramsSet & ParamFreqBit))
+						{
+							this->rthis.addEffect(CreateDelay<DelayFilter::None>());
+						}
 						else
 						{
-							SharedPtr<Delay<>> delayptr;
-							if (paramsSet & ParamFeedbackBit)
-								delayptr = MakeShared<Delay<>>(
-									static_cast<float>(delay),
-									static_cast<float>(feedback),
-									fbt);
-							else
-								delayptr = MakeShared<Delay<>>(
-									static_cast<float>(delay));
-							if (paramsSet & ParamFreqBit)
+							const bool bDF2 = (paramsSet & ParamTopoBit) != 0;
+							switch ((paramsSet & ParamOrderBit) ? static_cast<unsigned int>(order) : 2u)
 							{
-								uint_fast8_t uOrder = 2;
-								Filter::ETopo eTopo = Filter::ETopo::TDF2;
-								if (paramsSet & ParamOrderBit)
-									uOrder = static_cast<uint_fast8_t>(order);
-								if (paramsSet & ParamTopoBit)
-									eTopo = Filter::ETopo::DF2;
-								delayptr->SetBesselFilter(
-									1.0f / static_cast<float>(this->rthis.samplerate),
-									static_cast<float>(freq),
-									uOrder,
-									2,
-									eTopo);
+							case 0:
+							case 1: AddBesselDelay<1>(bDF2); break;
+							case 2: AddBesselDelay<2>(bDF2); break;
+							case 3: AddBesselDelay<3>(bDF2); break;
+							case 4: AddBesselDelay<4>(bDF2); break;
+							case 5: AddBesselDelay<5>(bDF2); break;
+							case 6: AddBesselDelay<6>(bDF2); break;
+							case 7: AddBesselDelay<7>(bDF2); break;
+							default:
+							case 8: AddBesselDelay<8>(bDF2); break;
 							}
-							this->rthis.addEffect(std::move(delayptr));
 						}
 						break;
 					case EValidEffects::Distortion:
@@ -4057,6 +4299,12 @@ namespace json2wav
 						break;
 					case EValidEffects::Compressor:
 					{
+						if ((paramsSet & ParamDecimationBit) && !(decimation >= 1.0 &&
+							decimation <= static_cast<double>(CompressorParams::MaxControlDecimation) && decimation == std::floor(decimation)))
+						{
+							this->error("Invalid compressor decimation (must be a whole number 1-256)");
+							break;
+						}
 						SharedPtr<Compressor<>> ptr(MakeShared<Compressor<>>());
 						CompressorParams comparams;
 						if (paramsSet & ParamThresholdBit)
@@ -4087,6 +4335,8 @@ namespace json2wav
 							comparams.df2 = true;
 						else
 							comparams.df2 = false;
+						if (paramsSet & ParamDecimationBit)
+							comparams.controlDecimation = static_cast<size_t>(decimation);
 						if (!(paramsSet & ParamStereoLinkBit))
 							bLink = false;
 						ptr->SetParams(comparams, bLink);
@@ -4117,6 +4367,32 @@ namespace json2wav
 					}
 				}
 
+				template<typename FeedbackFilter>
+				SharedPtr<Delay<false, FeedbackFilter>> CreateDelay() const
+				{
+					if (paramsSet & ParamFeedbackBit)
+						return MakeShared<Delay<false, FeedbackFilter>>(static_cast<float>(delay), static_cast<float>(feedback), fbt);
+					return MakeShared<Delay<false, FeedbackFilter>>(static_cast<float>(delay));
+				}
+
+				template<uint_fast8_t order>
+				void AddBesselDelay(const bool bDF2)
+				{
+					if (bDF2)
+						AddBesselDelay<order, Filter::ETopo::DF2>();
+					else
+						AddBesselDelay<order, Filter::ETopo::TDF2>();
+				}
+
+				template<uint_fast8_t order, Filter::ETopo eTopo>
+				void AddBesselDelay()
+				{
+					SharedPtr<Delay<false, DelayFilter::BesselLP<order, eTopo>>> delayptr(
+						CreateDelay<DelayFilter::BesselLP<order, eTopo>>());
+					delayptr->GetFeedbackFilter().Recalc(1.0f / static_cast<float>(this->rthis.samplerate), static_cast<float>(freq));
+					this->rthis.addEffect(std::move(delayptr));
+				}
+
 			private:
 				EValidEffects eEffect;
 				double freq;
@@ -4134,6 +4410,7 @@ namespace json2wav
 				double attack_ms;
 				double release_ms;
 				double dryVolume_db;
+				double decimation;
 				bool bLink;
 				uint64_t paramsSet;
 			};
@@ -4310,6 +4587,10 @@ namespace json2wav
 		SharedPtr<BusData> currentbus;
 		std::function<void(SharedPtr<AudioJoin<>>)> addEffect;
 		bool bIsChild;
+		StemCache* stemCache = nullptr;
+#ifdef ALBUMBOT_NODE_NAMES
+		Vector<std::pair<std::string, size_t>> jsonpath; // Key, or array index if not npos
+#endif
 	};
 
 	template<bool bLog>
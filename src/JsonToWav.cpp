@@ -3,43 +3,132 @@
 #include "JsonToWav.h"
 #include "JsonInterpreter.h"
 #include "JsonParser.h"
+#include "NodeNames.h"
+#include "Random.h"
+#include "StemCache.h"
+#include "SegmentRender.h"
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <optional>
+#include <cstdlib>
+
+namespace
+{
+	// The WAV file is closed by the time parsing returns; only the console needs flushing
+	[[noreturn]] void FastExit() noexcept
+	{
+		std::cout.flush();
+		std::cerr.flush();
+		std::_Exit(0);
+	}
+}
 
 namespace json2wav
 {
-	int JsonToWav(const char* const filename, const bool bLog)
+	namespace
+	{
+		/**
+		 * Parses and renders one copy of the song. Its graph nodes and events are freed together once it returns;
+		 * copies of a segmented render are parsed one inside the other, so every copy is alive while they render.
+		 */
+		bool ParseSong(const std::string& strfilename, const bool bLog, const bool bFastExit, RenderStats* const stats,
+			const std::optional<uint64_t> seed, const StemCacheOptions* const stemCacheOptions, const RenderRange* const range,
+			SegmentRender* const segments)
+		{
+			std::ifstream jsonfile(strfilename);
+			if (!jsonfile)
+				return false;
+			JsonParser p;
+			bool bParsed = false;
+			RenderArena::Scope arenaScope;
+			SongSeed::Scope seedScope(seed);
+			std::optional<StemCache> stemCache;
+			// Stems are only ever recorded whole
+			if (stemCacheOptions && !range && !segments)
+				stemCache.emplace(stemCacheOptions->dir, stemCacheOptions->maxBytes, stats);
+			if (bLog)
+			{
+				JsonInterpreter_Logging i(strfilename.substr(0, strfilename.find_last_of(".")));
+				i.SetRenderStats(stats);
+				i.SetStemCache(stemCache ? &*stemCache : nullptr);
+				i.SetRenderRange(range);
+				i.SetSegmentRender(segments);
+				bParsed = p.parse(jsonfile, i);
+				if (bParsed && bFastExit)
+					FastExit();
+			}
+			else
+			{
+				JsonInterpreter i(strfilename.substr(0, strfilename.find_last_of(".")));
+				i.SetRenderStats(stats);
+				i.SetStemCache(stemCache ? &*stemCache : nullptr);
+				i.SetRenderRange(range);
+				i.SetSegmentRender(segments);
+				bParsed = p.parse(jsonfile, i);
+				if (bParsed && bFastExit)
+					FastExit();
+			}
+			return bParsed;
+		}
+	}
+
+	int JsonToWav(const char* const filename, const bool bLog, const bool bFastExit, RenderStats* const stats,
+		const std::optional<uint64_t> seed, const StemCacheOptions* const stemCacheOptions, const RenderRange* const range,
+		const SegmentOptions* const segmentOptions)
 	{
 #ifdef ALBUMBOT_DEBUGNEW
 		json2wav::PrintAllocTimes("at start of JsonToWav()");
 #endif
 		const std::string strfilename(filename);
-		std::ifstream jsonfile(strfilename);
-		if (!jsonfile)
+		if (!std::ifstream(strfilename))
+			return -1;
+		bool bParsed = false;
+		bool bSeamsOk = true;
+		const bool bSegmented = segmentOptions && segmentOptions->numSegments > 1;
+		if (stemCacheOptions && (range || bSegmented))
+		{
+			std::cerr << "--cache can't be combined with --from, --to or --segments; stems are only recorded from whole renders.\n";
 			return -1;
-		JsonParser p;
-		if (bLog)
+		}
+		if (bSegmented)
 		{
-			JsonInterpreter_Logging i(strfilename.substr(0, strfilename.find_last_of(".")));
-			const bool bParsed = p.parse(jsonfile, i);
-			if (!bParsed)
+			if (range)
 			{
-				std::cerr << "Parse error; invalid JSON.\n";
-				return -2;
+				std::cerr << "--from and --to can't be combined with --segments.\n";
+				return -1;
 			}
+
+			// Copies after the first are parsed quietly; they would log the same thing again
+			std::optional<SegmentRender> segments;
+			segments.emplace(segmentOptions->numSegments, segmentOptions->bCheckSeams,
+				[&strfilename, stats, seed, &segments]()
+				{
+					return ParseSong(strfilename, false, false, stats, seed, nullptr, nullptr, &*segments);
+				});
+			// Fast exit would skip failing the run on bad seams
+			bParsed = ParseSong(strfilename, bLog, bFastExit && !segmentOptions->bCheckSeams, stats, seed, nullptr, nullptr,
+				&*segments);
+			bSeamsOk = segments->SeamsOk();
 		}
 		else
 		{
-			JsonInterpreter i(strfilename.substr(0, strfilename.find_last_of(".")));
-			const bool bParsed = p.parse(jsonfile, i);
-			if (!bParsed)
-			{
-				std::cerr << "Parse error; invalid JSON.\n";
-				return -2;
-			}
+			bParsed = ParseSong(strfilename, bLog, bFastExit, stats, seed, stemCacheOptions, range, nullptr);
+		}
+		SampleBuf::ReleaseUnusedMemory();
+#ifdef ALBUMBOT_NODE_NAMES
+		NodeNames::Clear();
+#endif
+		if (!bParsed)
+		{
+			std::cerr << "Parse error; invalid JSON.\n";
+			return -2;
+		}
+		if (!bSeamsOk)
+		{
+			std::cerr << "Segmented render strayed from the serial render past " << SegmentRender::MaxSeamError << ".\n";
+			return -3;
 		}
 		return 0;
 	}
 }
-
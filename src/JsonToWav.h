@@ -2,8 +2,39 @@
 
 #pragma once
 
+#include "RenderStats.h"
+#include "RenderRange.h"
+#include <optional>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
 namespace json2wav
 {
-	int JsonToWav(const char* const filename, const bool bLog);
-}
+	/** Where rendered part and bus stems are kept between renders, and how large that directory may grow */
+	struct StemCacheOptions
+	{
+		std::string dir;
+		uint64_t maxBytes = 1024ull * 1024 * 1024;
+	};
 
+	/** Renders the song as numSegments stretches at once, each on its own copy of the graph */
+	struct SegmentOptions
+	{
+		size_t numSegments = 4;
+		bool bCheckSeams = false; // Also renders serially, reports how far the segmented render strays and how much faster it was
+	};
+
+	/**
+	 * With bFastExit, a successfully rendered song ends the process without tearing down its graph.
+	 * With stats, the song is rendered but not written, and stats records what the render cost.
+	 * A seed overrides the one in the song's meta; songs without either render with seed 0.
+	 * With stemCache, parts and busses whose inputs haven't changed since an earlier render are played from disk.
+	 * With range, only that window of the song is rendered and written; a stem cache is an error then (-1).
+	 * With segments, the song is rendered in parallel segments; a range or a stem cache is an error then (-1).
+	 * A seam check that finds the segments straying from the serial render past SegmentRender::MaxSeamError returns -3.
+	 */
+	int JsonToWav(const char* const filename, const bool bLog, const bool bFastExit = false, RenderStats* const stats = nullptr,
+		const std::optional<uint64_t> seed = std::nullopt, const StemCacheOptions* const stemCache = nullptr,
+		const RenderRange* const range = nullptr, const SegmentOptions* const segments = nullptr);
+}
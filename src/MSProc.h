@@ -18,9 +18,13 @@ namespace json2wav
 			IAudioObject* const requester) noexcept override
 		{
 			this->GetInputSamples(bufs, numChannels, bufSize, sampleRate);
-			if (numChannels != 2)
-				return;
+			if (numChannels == 2)
+				ApplyInPlace(bufs, bufSize);
+		}
 
+		/** Converts the stereo samples already in bufs; also used by chains that absorb it */
+		static void ApplyInPlace(Sample* const* const bufs, const size_t bufSize) noexcept
+		{
 			for (size_t i = 0; i < bufSize; ++i)
 			{
 				const float sum = bufs[0][i].AsFloat32() + bufs[1][i].AsFloat32();
@@ -42,6 +46,12 @@ namespace json2wav
 		{
 			return 2;
 		}
+
+		/** Gain the sum and difference are scaled by */
+		static constexpr float Scale() noexcept
+		{
+			return bHalfAmp ? 0.5f : 1.0f;
+		}
 	};
 
 	template<bool bOwner = false>
@@ -415,6 +415,10 @@ r[15] = (((v[0]-v[1])-(v[2]-v[3]))-((v[4]-v[5])-(v[6]-v[7])))-(((v[8]-v[9])-(v[1
 				return r;
 			}
 
+			/** Row i of the matrix picks element GetSource(i) of the vector, negated if IsInverted(i) */
+			size_t GetSource(const size_t i) const { return shuffle[i]; }
+			bool IsInverted(const size_t i) const { return invert[i]; }
+
 			template<typename T>
 			SquareMatrix<n, T> ToSquareMatrix() const
 			{
@@ -5,6 +5,7 @@
 #include "ArenaBumpAllocator.h"
 #include "CachedArenaAllocator.h"
 #include "MemoryCommon.h"
+#include "RenderArena.h"
 #include "Logging.h"
 #include <vector>
 #include <array>
@@ -797,6 +798,8 @@ namespace json2wav
 #ifdef JSON2WAV_CUSTOM_SMARTPTRS
 		return MakeSharedImpl<T>(std::forward<Ts>(Params)...);
 #else
+		if (RenderArena* const arena = RenderArena::Current())
+			return std::allocate_shared<T>(RenderArenaAllocator<T>(arena), std::forward<Ts>(Params)...);
 		return std::make_shared<T>(std::forward<Ts>(Params)...);
 #endif
 	}
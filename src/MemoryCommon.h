@@ -6,6 +6,7 @@
 #include <string>
 #include <stdexcept>
 #include <shared_mutex>
+#include <atomic>
 #include <utility>
 #include <cstdint>
 #include <cstddef>
@@ -23,13 +24,78 @@ namespace json2wav
 	inline constexpr size_t InvalidSize() { return static_cast<size_t>(-1); }
 	inline constexpr uint32_t InvalidUint32() { return static_cast<uint32_t>(-1); }
 
-	struct AllocationTransaction
+	/**
+	 * Pins the calling thread's allocator heap for the lifetime of an allocation so TearDown waits for it, without touching any
+	 * shared cache line. While a TearDown is under way the pin falls back to the allocator's shared lock instead.
+	 */
+	class ThreadHeapPin
 	{
-		explicit AllocationTransaction(std::shared_mutex& Mutex, std::byte* StorageInit = nullptr)
-			: Lock(Mutex), Storage(StorageInit), StartByte(InvalidSize()), NumBytes(0), AlignBytes(0), TrackingIndex(InvalidUint32()), ObjectSerial(InvalidUint32())
+	public:
+		ThreadHeapPin() noexcept : Busy(nullptr) {}
+
+		ThreadHeapPin(std::atomic<uint32_t>& BusyInit, const std::atomic<uint32_t>& TearingDown, std::shared_mutex& Mutex)
+			: Busy(&BusyInit)
+		{
+			const uint32_t Depth = Busy->load(std::memory_order_relaxed);
+			Busy->store(Depth + 1);
+
+			// A nested pin is already covered by the outer one
+			if (Depth == 0 && TearingDown.load())
+			{
+				Busy->store(0);
+				Busy = nullptr;
+				Lock = std::shared_lock<std::shared_mutex>(Mutex);
+			}
+		}
+
+		ThreadHeapPin(ThreadHeapPin&& Other) noexcept
+			: Busy(Other.Busy), Lock(std::move(Other.Lock))
 		{
+			Other.Busy = nullptr;
 		}
+
+		ThreadHeapPin& operator=(ThreadHeapPin&& Other) noexcept
+		{
+			if (&Other != this)
+			{
+				Release();
+				Busy = Other.Busy;
+				Lock = std::move(Other.Lock);
+				Other.Busy = nullptr;
+			}
+			return *this;
+		}
+
+		ThreadHeapPin(const ThreadHeapPin&) = delete;
+		ThreadHeapPin& operator=(const ThreadHeapPin&) = delete;
+
+		~ThreadHeapPin() noexcept
+		{
+			Release();
+		}
+
+	private:
+		void Release() noexcept
+		{
+			if (Busy)
+			{
+				Busy->store(Busy->load(std::memory_order_relaxed) - 1, std::memory_order_release);
+				Busy = nullptr;
+			}
+		}
+
+	private:
+		std::atomic<uint32_t>* Busy;
 		std::shared_lock<std::shared_mutex> Lock;
+	};
+
+	struct AllocationTransaction
+	{
+		explicit AllocationTransaction(ThreadHeapPin&& PinInit, std::byte* StorageInit = nullptr)
+			: Pin(std::move(PinInit)), Storage(StorageInit), StartByte(InvalidSize()), NumBytes(0), AlignBytes(0), TrackingIndex(InvalidUint32()), ObjectSerial(InvalidUint32())
+		{
+		}
+		ThreadHeapPin Pin;
 		std::byte* Storage;
 		size_t StartByte;
 		uint32_t NumBytes;
@@ -0,0 +1,90 @@
+// Copyright Dan Price 2026.
+
+#pragma once
+
+#if defined(ALBUMBOT_PROFILE) || defined(ALBUMBOT_TRACE) || defined(ALBUMBOT_ALLOCGUARD)
+#define ALBUMBOT_NODE_NAMES
+#endif
+
+#ifdef ALBUMBOT_NODE_NAMES
+#include "Macros.h"
+#include <unordered_map>
+#include <string>
+#include <shared_mutex>
+#include <mutex>
+#include <typeinfo>
+#include <utility>
+#include <cstdlib>
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+namespace json2wav
+{
+	/** Names for graph nodes in profiles and traces; the interpreter labels the nodes it creates with their JSON path */
+	class NodeNames
+	{
+	private:
+		struct Registry
+		{
+			std::shared_mutex mtx;
+			std::unordered_map<const void*, std::string> labels;
+		};
+
+		DEFINE_STATIC_PROPERTY(Registry, Registry);
+
+		static std::string Demangle(const char* const name)
+		{
+#ifdef __GNUG__
+			int status = 0;
+			if (char* const demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status))
+			{
+				std::string result(demangled);
+				std::free(demangled);
+				return result;
+			}
+#endif
+			return name;
+		}
+
+	public:
+		/** Drops namespaces and template arguments: json2wav::Fader<false, true> -> Fader */
+		static std::string ShortTypeName(const std::type_info& type)
+		{
+			std::string name(Demangle(type.name()));
+			if (const size_t templ = name.find('<'); templ != std::string::npos)
+				name.resize(templ);
+			if (const size_t ns = name.rfind("::"); ns != std::string::npos)
+				name.erase(0, ns + 2);
+			return name;
+		}
+
+		template<typename NodeType>
+		static void Label(const NodeType* const node, std::string path)
+		{
+			if (!node)
+				return;
+			Registry& registry = GetRegistry();
+			std::unique_lock lock(registry.mtx);
+			registry.labels[static_cast<const void*>(node)] = std::move(path) + ':' + ShortTypeName(typeid(*node));
+		}
+
+		/** Empty if the node was never labelled */
+		static std::string Find(const void* const node)
+		{
+			Registry& registry = GetRegistry();
+			std::shared_lock lock(registry.mtx);
+			const auto found = registry.labels.find(node);
+			return (found != registry.labels.end()) ? found->second : std::string();
+		}
+
+		/** Call once a song's graph is gone, before its addresses can be reused */
+		static void Clear()
+		{
+			Registry& registry = GetRegistry();
+			std::unique_lock lock(registry.mtx);
+			registry.labels.clear();
+		}
+	};
+}
+#endif
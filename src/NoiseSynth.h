@@ -4,7 +4,6 @@
 
 #include "Synth.h"
 #include "Random.h"
-#include "Thread.h"
 
 #define STANFORD_PINK 0
 
@@ -15,7 +14,7 @@ namespace json2wav
 	{
 	public:
 		NoiseSynth(const float ampInit = 0.0f)
-			: BasicSynth(1000.0f, ampInit), z1(0.0f), z2(0.0f), z3(0.0f)
+			: BasicSynth(1000.0f, ampInit), rng(-1.0f, 1.0f), z1(0.0f), z2(0.0f), z3(0.0f)
 		{
 		}
 
@@ -29,7 +28,7 @@ namespace json2wav
 
 			const double deltaTime = 1.0 / (double)sampleRate;
 			Sample* const buf = bufs[0];
-			GetSynthSamples(bufs, numChannels, numSamples, true, [this, buf, deltaTime](const size_t i)
+			GetSynthSamples(bufs, numChannels, numSamples, true, deltaTime, [this, buf, deltaTime](const size_t i)
 				{
 
 #if STANFORD_PINK
@@ -69,8 +68,6 @@ namespace json2wav
 					//static constexpr const float b3 = 0.0f * amp_norm;
 #endif
 
-					thread_local ThreadSafeStatic<RNG> rng(-1.0f, 1.0f);
-
 					Increment(deltaTime);
 					const float smpIn = GetAmplitude() * rng();
 					const float mid = smpIn - a1*z1 - a2*z2 - a3*z3;
@@ -86,6 +83,24 @@ namespace json2wav
 		}
 
 	private:
+		/** Moves the noise on by the draws rendering would have made; the pinking filter's memory is dropped */
+		virtual bool SkipSamples(const size_t numSamples, const double deltaTime) noexcept override
+		{
+			this->ProcessEventSpans(numSamples, [this, deltaTime](const size_t start, size_t count)
+				{
+					for ( ; count > 0 && IsRamping(); --count)
+						Increment(deltaTime);
+					IncrementSteady(count);
+				});
+			rng.Discard(numSamples);
+			z1 = 0.0f;
+			z2 = 0.0f;
+			z3 = 0.0f;
+			return true;
+		}
+
+	private:
+		RNG rng; // Seeded while the song is built so the noise doesn't depend on which thread renders it
 		float z1, z2, z3;
 	};
 }
@@ -0,0 +1,217 @@
+// Copyright Dan Price 2026.
+
+#pragma once
+
+#include "IAudioObject.h"
+#include "IOversampled.h"
+#include "Oversampler.h"
+#include "Sample.h"
+#include "Utility.h"
+#include "Memory.h"
+#include "NodeNames.h"
+#include <algorithm>
+
+// Runs of 2x-oversampled effects in an effect chain share one trip up to 2x and back down
+#define ALBUMBOT_OVERSAMPLED_ISLANDS 1
+
+namespace json2wav
+{
+	/**
+	 * Stands in for a run of effects that each oversample by 2, upsampling once where the run starts, running every
+	 * stage's ProcessOversampled at 2x and downsampling once where it ends. A ring mod at the input end multiplies the
+	 * inputs at 2x and hands the product straight on; further along a chain it has one input and passes it through.
+	 */
+	class OversampledIsland : public AudioJoin<>
+	{
+	public:
+		static bool CanJoin(AudioJoin<>* const node) noexcept
+		{
+			if (dynamic_cast<RingMod<>*>(node))
+				return true;
+			const IOversampledX2* const oversampled = dynamic_cast<IOversampledX2*>(node);
+			return oversampled && oversampled->CanProcessOversampled();
+		}
+
+		/** Stages run in the order they're added, so add the input end of the run first */
+		bool AddStage(const SharedPtr<AudioJoin<>>& node)
+		{
+			if (dynamic_cast<RingMod<>*>(node.get()))
+			{
+				if (nodes.empty())
+					bMultiplyInputs = true;
+				nodes.push_back(node);
+				return true;
+			}
+
+			IOversampledX2* const oversampled = dynamic_cast<IOversampledX2*>(node.get());
+			if (!oversampled || !oversampled->CanProcessOversampled())
+				return false;
+			nodes.push_back(node);
+			stages.push_back(oversampled);
+			return true;
+		}
+
+		size_t GetNumStages() const noexcept
+		{
+			return nodes.size();
+		}
+
+		virtual void GetSamples(
+			Sample* const* const bufs,
+			const size_t numChannels,
+			const size_t numSamples,
+			const unsigned long sampleRate,
+			IAudioObject* const requester) noexcept override
+		{
+			lastNumChannels = numChannels;
+			Reserve(numChannels, numSamples);
+			bJoinedX2 = false;
+			if (this->GetInputSamples(bufs, numChannels, numSamples, sampleRate) != EGetInputSamplesResult::SamplesWritten)
+				return;
+
+			// A lone input skips JoinChannel, so it still needs to go up
+			if (!bJoinedX2)
+				for (size_t ch = 0; ch < numChannels; ++ch)
+					ups[ch].process_unsafe(numSamples, bufs[ch], bufsX2[ch]);
+
+			for (IOversampledX2* const stage : stages)
+				stage->ProcessOversampled(bufsX2.data(), numChannels, numSamples, sampleRate);
+
+			for (size_t ch = 0; ch < numChannels; ++ch)
+				downs[ch].process_unsafe(numSamples, bufsX2[ch], bufs[ch]);
+		}
+
+		virtual size_t GetNumChannels() const noexcept override
+		{
+			if (lastNumChannels > 0)
+				return lastNumChannels;
+
+			size_t numChannels = 0;
+			for (const InputPtr& input : this->GetInputs())
+				if (const SharedPtr<IAudioObject> locked = Utility::Lock(input))
+					numChannels = std::max(numChannels, locked->GetNumChannels());
+			return numChannels;
+		}
+
+		virtual size_t GetSampleDelay() const noexcept override
+		{
+			size_t delay = AudioJoin<>::GetSampleDelay() + oversampling::delay441_x2;
+			for (const IOversampledX2* const stage : stages)
+				delay += stage->GetOversampledDelay();
+			return delay;
+		}
+
+		/** The absorbed nodes have no inputs left, so their tails are their own */
+		virtual size_t GetTailSamples(const unsigned long sampleRate) const noexcept override
+		{
+			size_t tail = AudioJoin<>::GetTailSamples(sampleRate);
+			for (const SharedPtr<AudioJoin<>>& node : nodes)
+				tail = this->AddTails(tail, node->GetTailSamples(sampleRate));
+			return tail;
+		}
+
+	private:
+		virtual bool IsSumJoin() const noexcept override
+		{
+			return !bMultiplyInputs;
+		}
+
+		virtual void JoinChannel(
+			const size_t ch,
+			Sample* const* const inputBufs,
+			Sample* const chbuf,
+			const size_t bufSize,
+			const size_t bufsWritten) noexcept override
+		{
+			if (bMultiplyInputs)
+			{
+				rmjoin.JoinChannelOversampled(ch, inputBufs, bufsX2[ch], bufSize, bufsWritten);
+				bJoinedX2 = true;
+			}
+			else
+			{
+				sumjoin.JoinChannel(ch, inputBufs, chbuf, bufSize, bufsWritten);
+			}
+		}
+
+		void Reserve(const size_t numChannels, const size_t numSamples)
+		{
+			if (numChannels > ups.size())
+			{
+				ups.resize(numChannels);
+				downs.resize(numChannels);
+			}
+
+			const size_t stride = numSamples << 1;
+			if (stride > strideX2 || numChannels > bufsX2.size())
+			{
+				strideX2 = std::max(strideX2, stride);
+				bufsX2.resize(std::max(bufsX2.size(), numChannels));
+				samplesX2.resize(bufsX2.size() * strideX2);
+				for (size_t ch = 0; ch < bufsX2.size(); ++ch)
+					bufsX2[ch] = samplesX2.data() + ch * strideX2;
+			}
+		}
+
+	private:
+		Vector<SharedPtr<AudioJoin<>>> nodes;
+		Vector<IOversampledX2*> stages;
+		RingModJoin rmjoin;
+		AudioSumJoin sumjoin;
+		Vector<oversampling::upsampler441_x2<double>> ups;
+		Vector<oversampling::downsampler441_x2<double>> downs;
+		Vector<double> samplesX2; // [channel][strideX2]
+		Vector<double*> bufsX2;
+		size_t strideX2 = 0;
+		size_t lastNumChannels = 0;
+		bool bMultiplyInputs = false;
+		bool bJoinedX2 = false;
+	};
+
+	/**
+	 * Replaces each run of two or more effects that can share a trip through 2x, in a chain built by
+	 * JsonInterpreter::AddEffect, with an OversampledIsland. A ring mod with several inputs can only be the input end of
+	 * a run. Like FusePointwiseChain, call it once the graph is complete.
+	 */
+	inline void FuseOversampledChain(Vector<SharedPtr<AudioJoin<>>>& effects, const SharedPtr<AudioJoin<>>& output)
+	{
+		for (size_t first = 0; first < effects.size(); ++first)
+		{
+			size_t last = first;
+			while (last < effects.size() && effects[last] && OversampledIsland::CanJoin(effects[last].get()))
+			{
+				const bool bMultiplies = dynamic_cast<RingMod<>*>(effects[last].get()) && effects[last]->GetInputs().size() > 1;
+				++last;
+				if (bMultiplies)
+					break;
+			}
+			if (last - first < 2)
+				continue;
+
+			SharedPtr<OversampledIsland> island(MakeShared<OversampledIsland>());
+			for (size_t idx = last; idx-- > first;)
+				island->AddStage(effects[idx]);
+
+			Vector<SharedPtr<IAudioObject>> inputs;
+			for (const auto& input : effects[last - 1]->GetInputs())
+				if (SharedPtr<IAudioObject> audioObject = Utility::Lock(input))
+					inputs.emplace_back(std::move(audioObject));
+			for (size_t idx = first; idx < last; ++idx)
+				effects[idx]->ClearInputs();
+			for (SharedPtr<IAudioObject>& input : inputs)
+				island->AddInput(std::move(input));
+
+			if (const SharedPtr<AudioJoin<>>& consumer = (first == 0) ? output : effects[first - 1])
+			{
+				consumer->RemoveInput(effects[first]);
+				consumer->AddInput(island);
+			}
+
+#ifdef ALBUMBOT_NODE_NAMES
+			NodeNames::Label(island.get(), NodeNames::Find(effects[first].get()));
+#endif
+			effects.erase(effects.begin() + first + 1, effects.begin() + last);
+			effects[first] = std::move(island);
+		}
+	}
+}
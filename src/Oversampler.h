@@ -316,6 +316,9 @@ namespace json2wav::oversampling
 
 	}
 
+	/** Samples by which a trip up through upsampler441_x2 and back down through downsampler441_x2 delays a signal */
+	constexpr const size_t delay441_x2 = 128;
+
 	template<typename sample_t>
 	class upsampler441_x2
 	{
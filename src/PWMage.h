@@ -424,7 +424,7 @@ namespace json2wav
 			const double deltaTime = 1.0 / static_cast<double>(sampleRate);
 			do
 			{
-				this->GetSynthSamples(bufs, 2, numSamples, false, [this, bufs, deltaTime](const size_t i)
+				this->GetSynthSamples(bufs, 2, numSamples, false, deltaTime, [this, bufs, deltaTime](const size_t i)
 					{
 						constexpr const double one_third = 1.0/3.0;
 						constexpr const double two_thirds = 2.0/3.0;
@@ -6,7 +6,11 @@
 #include "IControlObject.h"
 #include "Ramp.h"
 #include "FastSin.h"
+#include "SampleKernels.h"
+#include <algorithm>
+#include <span>
 #include <utility>
+#include <cmath>
 #include <cstdint>
 
 namespace json2wav
@@ -38,6 +42,36 @@ namespace json2wav
 		Linear3dB, Linear6dB//, Linear4_5dB, Circular3dB, Circular4_5dB, Circular6dB
 	};
 
+	/** sin(x*tau/4) for x in [0, 1], interpolated from 1025 points to within 4e-7 */
+	class PanLawTable
+	{
+	public:
+		static const PanLawTable& Get()
+		{
+			static const PanLawTable table;
+			return table;
+		}
+
+		float operator()(const float x) const noexcept
+		{
+			const float pos = x * static_cast<float>(numSteps);
+			const size_t idx = std::min(static_cast<size_t>(pos), numSteps - 1);
+			const float frac = pos - static_cast<float>(idx);
+			return values[idx] + frac * (values[idx + 1] - values[idx]);
+		}
+
+	private:
+		PanLawTable()
+		{
+			for (size_t idx = 0; idx <= numSteps; ++idx)
+				values[idx] = static_cast<float>(std::sin(QuarterTau<double>() * static_cast<double>(idx) / static_cast<double>(numSteps)));
+		}
+
+	private:
+		static constexpr const size_t numSteps = 1024;
+		float values[numSteps + 1];
+	};
+
 	inline float GetPanVolume(const EPanLaw panlaw, const float pan)
 	{
 		const float panNormalized = (pan + 1.0f) * 0.5f;
@@ -45,7 +79,10 @@ namespace json2wav
 		{
 		case EPanLaw::Linear6dB: return panNormalized;
 		default:
-		case EPanLaw::Linear3dB: return FastSin<6>(QuarterTau<float>() * panNormalized);
+		case EPanLaw::Linear3dB:
+			if (panNormalized >= 0.0f && panNormalized <= 1.0f)
+				return PanLawTable::Get()(panNormalized);
+			return FastSin<6>(QuarterTau<float>() * panNormalized);
 		}
 	}
 
@@ -53,6 +90,9 @@ namespace json2wav
 	class Panner : public AudioSum<bOwner>, public ControlObject<PannerEvent<bOwner>>
 	{
 	public:
+		/** Ramps are stepped this many samples at a time */
+		static constexpr const size_t rampChunk = 64;
+
 		Panner(const float panInit = 0.0f, const EPanLaw panLawInit = EPanLaw::Linear3dB)
 			: panlaw(panLawInit), pan(panInit)
 		{
@@ -82,15 +122,57 @@ namespace json2wav
 				return;
 			}
 
-			const double deltaTime = 1.0 / static_cast<double>(sampleRate);
-			this->ProcessEvents(numSamples, [this, bufs, deltaTime](const size_t i)
+			ApplyInPlace(bufs, numSamples, 1.0 / static_cast<double>(sampleRate));
+		}
+
+		/** Pans the stereo samples already in bufs, running its events; also used by chains that absorb it */
+		void ApplyInPlace(Sample* const* const bufs, const size_t numSamples, const double deltaTime) noexcept
+		{
+			this->ProcessEventSpans(numSamples, [this, bufs, deltaTime](const size_t start, const size_t count)
 				{
-					pan_ramp.Increment(pan, deltaTime);
-					bufs[0][i] *= GetLeftPanVolume();
-					bufs[1][i] *= GetRightPanVolume();
+					float left[rampChunk], right[rampChunk];
+					for (size_t i = start, end = start + count; i < end; )
+					{
+						if (!IsRamping())
+						{
+							// Nothing moves the pan until the next event
+							kernel::Pan(AsSpan(bufs[0] + i, end - i), AsSpan(bufs[1] + i, end - i), GetLeftPanVolume(), GetRightPanVolume());
+							return;
+						}
+
+						const size_t chunk = std::min(rampChunk, end - i);
+						StepPanVolumes(deltaTime, left, right, chunk);
+						kernel::Gain(AsSpan(bufs[0] + i, chunk), std::span<const float>(left, chunk));
+						kernel::Gain(AsSpan(bufs[1] + i, chunk), std::span<const float>(right, chunk));
+						i += chunk;
+					}
 				});
 		}
 
+		/** Advances the pan ramp count samples, writing each channel's gain for each */
+		void StepPanVolumes(const double deltaTime, float* const left, float* const right, const size_t count) noexcept
+		{
+			if (!IsRamping())
+			{
+				std::fill_n(left, count, GetLeftPanVolume());
+				std::fill_n(right, count, GetRightPanVolume());
+				return;
+			}
+
+			pan_ramp.IncrementBlock(pan, deltaTime, right, count);
+			for (size_t j = 0; j < count; ++j)
+			{
+				left[j] = GetPanVolume(panlaw, -right[j]);
+				right[j] = GetPanVolume(panlaw, right[j]);
+			}
+		}
+
+		/** While false, the channel gains stay put until the next event */
+		bool IsRamping() const noexcept
+		{
+			return pan_ramp.IsActive();
+		}
+
 		virtual size_t GetNumChannels() const noexcept override
 		{
 			return 2;
@@ -0,0 +1,67 @@
+// Copyright Dan Price 2026.
+
+#pragma once
+
+#include <complex>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace json2wav
+{
+	namespace Math
+	{
+		/**
+		 * Finds the roots of coeffs[0] + coeffs[1]*s + ... + coeffs[order]*s^order by Aberth-Ehrlich iteration in long
+		 * double. Meant to be solved once and cached; repeated roots converge slowly and lose precision.
+		 */
+		template<typename T, size_t order>
+		void PolyRoots(const T (&coeffs)[order + 1], std::complex<T> (&roots)[order])
+		{
+			using Real = long double;
+			using Complex = std::complex<Real>;
+			static_assert(order > 0, "Constants have no roots");
+
+			Real monic[order + 1];
+			for (size_t n = 0; n <= order; ++n)
+				monic[n] = static_cast<Real>(coeffs[n]) / static_cast<Real>(coeffs[order]);
+
+			// Start on a circle of the roots' geometric mean radius, turned off the real axis so conjugates separate
+			const Real radius = std::pow(std::abs(monic[0]), static_cast<Real>(1) / static_cast<Real>(order));
+			const Real tau = static_cast<Real>(6.283185307179586476925286766559L);
+			Complex z[order];
+			for (size_t k = 0; k < order; ++k)
+				z[k] = std::polar((radius > 0) ? radius : static_cast<Real>(1), tau * (static_cast<Real>(k) + static_cast<Real>(0.25)) / static_cast<Real>(order));
+
+			for (size_t iter = 0; iter < 500; ++iter)
+			{
+				Real maxStep = 0;
+				for (size_t k = 0; k < order; ++k)
+				{
+					Complex p(monic[order]);
+					Complex dp(0);
+					for (size_t n = order; n-- > 0;)
+					{
+						dp = dp * z[k] + p;
+						p = p * z[k] + monic[n];
+					}
+					if (p == Complex(0))
+						continue;
+					const Complex newton = p / dp;
+					Complex repulsion(0);
+					for (size_t j = 0; j < order; ++j)
+						if (j != k)
+							repulsion += static_cast<Real>(1) / (z[k] - z[j]);
+					const Complex step = newton / (static_cast<Real>(1) - newton * repulsion);
+					z[k] -= step;
+					maxStep = std::max(maxStep, std::abs(step) / std::max(std::abs(z[k]), static_cast<Real>(1)));
+				}
+				if (maxStep < static_cast<Real>(1.0e-18L))
+					break;
+			}
+
+			for (size_t k = 0; k < order; ++k)
+				roots[k] = std::complex<T>(static_cast<T>(z[k].real()), static_cast<T>(z[k].imag()));
+		}
+	}
+}
@@ -0,0 +1,266 @@
+// Copyright Dan Price 2026.
+
+#pragma once
+
+#ifdef ALBUMBOT_PROFILE
+#include "AllocGuard.h"
+#include "NodeNames.h"
+#include "Macros.h"
+#include <unordered_map>
+#include <map>
+#include <vector>
+#include <string>
+#include <shared_mutex>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <typeinfo>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <utility>
+#include <type_traits>
+#include <cstdint>
+#endif
+
+#include <string>
+#include <cstddef>
+
+namespace json2wav::profile
+{
+#ifdef ALBUMBOT_PROFILE
+	/**
+	 * Per-node render costs. Inclusive time is the wall time of a node's GetSamples call; self time is that minus the time
+	 * the node spent waiting on its inputs. Nodes are labelled with the JSON path that created them.
+	 */
+	class Profiler
+	{
+	private:
+		struct NodeStats
+		{
+			std::string label;
+			std::string typeName;
+			std::atomic<uint64_t> selfNs = 0;
+			std::atomic<uint64_t> inclusiveNs = 0;
+			std::atomic<uint64_t> calls = 0;
+			std::atomic<uint64_t> samples = 0;
+			size_t numUnlabelledInputs = 0;
+		};
+
+		struct EdgeStats
+		{
+			std::atomic<uint64_t> ns = 0;
+			std::atomic<uint64_t> calls = 0;
+		};
+
+		struct Frame
+		{
+			uint64_t childNs;
+		};
+
+		std::shared_mutex mtx;
+		std::unordered_map<const void*, NodeStats> nodes;
+		std::map<std::pair<const void*, const void*>, EdgeStats> edges;
+
+		DEFINE_STATIC_PROPERTY(Profiler, Instance);
+		DEFINE_THREADLOCAL_PROPERTY(Frame*, CurrentFrame, nullptr);
+
+		template<typename MapType, typename KeyType>
+		auto& Find(MapType& map, const KeyType& key, const std::type_info* const type, const void* const requester)
+		{
+			{
+				std::shared_lock lock(mtx);
+				if (const auto found = map.find(key); found != map.end())
+					return found->second;
+			}
+
+			const allocguard::Exempt firstCall;
+			std::unique_lock lock(mtx);
+			auto& value = map.try_emplace(key).first->second;
+			if constexpr (std::is_same_v<std::decay_t<decltype(value)>, NodeStats>)
+			{
+				if (value.typeName.empty())
+				{
+					value.typeName = NodeNames::ShortTypeName(*type);
+					// Nodes the interpreter didn't create, like those inside a synth, are named after whoever pulls them first
+					if (std::string label = NodeNames::Find(key); !label.empty())
+						value.label = std::move(label);
+					else if (const auto parent = nodes.find(requester); parent != nodes.end())
+						value.label = parent->second.label + '/' + value.typeName + '[' + std::to_string(parent->second.numUnlabelledInputs++) + ']';
+					else
+						value.label = value.typeName;
+				}
+			}
+			return value;
+		}
+
+		static double Ms(const uint64_t ns) { return static_cast<double>(ns) * 0.000001; }
+
+		static std::string DotEscape(const std::string& str)
+		{
+			std::string escaped;
+			for (const char c : str)
+			{
+				if (c == '"' || c == '\\')
+					escaped.push_back('\\');
+				escaped.push_back(c);
+			}
+			return escaped;
+		}
+
+	public:
+		/** Times one GetSamples call of node, made on behalf of requester */
+		class Scope
+		{
+		public:
+			template<typename NodeType>
+			Scope(const NodeType& node, const void* const requesterInit, const size_t numSamplesInit) noexcept
+				: stats(Get().Find(Get().nodes, static_cast<const void*>(&node), &typeid(node), requesterInit)),
+				requester(requesterInit), numSamples(numSamplesInit),
+				frame{ 0 }, prevFrame(GetCurrentFrame()), start(std::chrono::steady_clock::now())
+			{
+				GetCurrentFrame() = &frame;
+				edge = &Get().Find(Get().edges, std::make_pair(static_cast<const void*>(&node), requester), nullptr, nullptr);
+			}
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+			~Scope() noexcept
+			{
+				const uint64_t inclusive = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now() - start).count());
+				GetCurrentFrame() = prevFrame;
+				stats.inclusiveNs += inclusive;
+				stats.selfNs += (inclusive > frame.childNs) ? inclusive - frame.childNs : 0;
+				++stats.calls;
+				stats.samples += numSamples;
+				edge->ns += inclusive;
+				++edge->calls;
+			}
+
+		private:
+			NodeStats& stats;
+			EdgeStats* edge;
+			const void* requester;
+			size_t numSamples;
+			Frame frame;
+			Frame* prevFrame;
+			std::chrono::steady_clock::time_point start;
+		};
+
+		/** Time the current node spends waiting on its inputs, which may render on other threads */
+		class InputsScope
+		{
+		public:
+			InputsScope() noexcept : frame(GetCurrentFrame()), start(std::chrono::steady_clock::now()) {}
+			InputsScope(const InputsScope&) = delete;
+			InputsScope& operator=(const InputsScope&) = delete;
+			~InputsScope() noexcept
+			{
+				if (frame)
+					frame->childNs += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+						std::chrono::steady_clock::now() - start).count());
+			}
+
+		private:
+			Frame* frame;
+			std::chrono::steady_clock::time_point start;
+		};
+
+		static Profiler& Get() { return GetInstance(); }
+
+		/** Prints a table sorted by self time, writes a Graphviz graph with edges weighted by cost, and resets */
+		void Report(const std::string& name)
+		{
+			std::unique_lock lock(mtx);
+			std::vector<std::pair<const void*, const NodeStats*>> sorted;
+			uint64_t totalSelfNs = 0;
+			for (const auto& [node, stats] : nodes)
+			{
+				sorted.emplace_back(node, &stats);
+				totalSelfNs += stats.selfNs;
+			}
+			std::sort(sorted.begin(), sorted.end(),
+				[](const auto& a, const auto& b) { return a.second->selfNs > b.second->selfNs; });
+			const double totalSelf = (totalSelfNs > 0) ? static_cast<double>(totalSelfNs) : 1.0;
+
+			std::cout << "Profile for " << name << ":\n";
+			std::cout << std::setw(10) << "self ms" << std::setw(8) << "self %" << std::setw(11) << "incl ms"
+				<< std::setw(9) << "calls" << std::setw(12) << "samples" << std::setw(10) << "ns/smp" << "  node\n";
+			for (const auto& [node, stats] : sorted)
+			{
+				const uint64_t samples = stats->samples;
+				std::cout << std::fixed << std::setprecision(2)
+					<< std::setw(10) << Ms(stats->selfNs)
+					<< std::setw(8) << 100.0 * static_cast<double>(stats->selfNs) / totalSelf
+					<< std::setw(11) << Ms(stats->inclusiveNs)
+					<< std::setw(9) << stats->calls
+					<< std::setw(12) << samples
+					<< std::setw(10) << ((samples > 0) ? static_cast<double>(stats->selfNs) / static_cast<double>(samples) : 0.0)
+					<< "  " << stats->label << '\n';
+			}
+			std::cout << std::defaultfloat;
+
+			const std::string dotname(name + ".profile.dot");
+			std::ofstream dot(dotname);
+			dot << "digraph \"" << DotEscape(name) << "\" {\n\trankdir=LR;\n\tnode [shape=box];\n";
+			std::unordered_map<const void*, size_t> ids;
+			for (const auto& [node, stats] : sorted)
+			{
+				const size_t id = ids.size();
+				ids[node] = id;
+				const double frac = static_cast<double>(stats->selfNs) / totalSelf;
+				dot << "\tn" << id << " [label=\"" << DotEscape(stats->label) << "\\nself " << std::fixed << std::setprecision(2)
+					<< Ms(stats->selfNs) << " ms (" << 100.0 * frac << "%)\", style=filled, fillcolor=\"0.0 "
+					<< std::setprecision(3) << frac << " 1.0\"];\n";
+			}
+			ids.emplace(nullptr, ids.size());
+			dot << "\tn" << ids[nullptr] << " [label=\"" << DotEscape(name) << "\", shape=ellipse];\n";
+			for (const auto& [key, edge] : edges)
+			{
+				const auto from = ids.find(key.first);
+				const auto to = ids.find(key.second);
+				if (from == ids.end() || to == ids.end())
+					continue;
+				const double frac = static_cast<double>(edge.ns) / totalSelf;
+				dot << "\tn" << from->second << " -> n" << to->second << " [label=\"" << std::setprecision(2) << Ms(edge.ns)
+					<< " ms\", penwidth=" << 1.0 + 9.0 * std::min(frac, 1.0) << "];\n";
+			}
+			dot << "}\n" << std::defaultfloat;
+			std::cout << "Wrote " << dotname << '\n';
+
+			nodes.clear();
+			edges.clear();
+		}
+	};
+
+	using Scope = Profiler::Scope;
+	using InputsScope = Profiler::InputsScope;
+
+	inline void Report(const std::string& name)
+	{
+		Profiler::Get().Report(name);
+	}
+#else
+	class Scope
+	{
+	public:
+		template<typename NodeType>
+		Scope(const NodeType&, const void*, size_t) noexcept {}
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+
+	class InputsScope
+	{
+	public:
+		InputsScope() noexcept {}
+		InputsScope(const InputsScope&) = delete;
+		InputsScope& operator=(const InputsScope&) = delete;
+	};
+
+	inline void Report(const std::string&) {}
+#endif
+}
@@ -367,6 +367,43 @@ namespace json2wav
 			return true;
 		}
 
+		/** Increments count times, writing each new value to out; linear ramps fill the block in one vectorizable pass */
+		void IncrementBlock(ValueType& currentValue, const double deltaTime, ValueType* const out, const size_t count)
+		{
+			size_t i = 0;
+			if (shape == ERampShape::Linear && time > 0.0 && count > 0)
+			{
+				// Increment steps a linear ramp by (target - value)/(samples left), which is the same step every sample
+				const double samplesLeft = std::ceil(time / deltaTime);
+				const size_t numSteps = (samplesLeft < static_cast<double>(count)) ? static_cast<size_t>(samplesLeft) : count;
+				const ValueType start = currentValue;
+				const ValueType step = static_cast<ValueType>((topTail[1] - start) * deltaTime / time);
+				for (size_t j = 0; j < numSteps; ++j)
+					out[j] = start + step * static_cast<ValueType>(j + 1);
+
+				if (static_cast<double>(numSteps) >= samplesLeft)
+				{
+					out[numSteps - 1] = topTail[1];
+					time = 0.0;
+				}
+				else
+				{
+					time -= static_cast<double>(numSteps) * deltaTime;
+				}
+				currentValue = out[numSteps - 1];
+				i = numSteps;
+			}
+
+			for (; i < count; ++i)
+			{
+				Increment(currentValue, deltaTime);
+				out[i] = currentValue;
+			}
+		}
+
+		/** Whether Increment would still change the value it ramps */
+		bool IsActive() const noexcept { return time > 0.0; }
+
 		double GetTimeLength() const noexcept { return (std::isnan(timeLength)) ? time : timeLength; }
 
 		ERampShape GetShape() const noexcept { return shape; }
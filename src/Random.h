@@ -3,10 +3,14 @@
 #pragma once
 
 #include "Memory.h"
+#include "Macros.h"
 #include <random>
+#include <optional>
+#include <string>
 #include <utility>
 #include <new>
 #include <mutex>
+#include <cstdint>
 
 namespace json2wav
 {
@@ -116,8 +120,172 @@ namespace json2wav
 		alignas(std::seed_seq) mutable unsigned char mem[sizeof(std::seed_seq)];
 	};
 
+	/** splitmix64 finalizer; also used to combine hashes */
+	constexpr uint64_t HashMix(uint64_t x) noexcept
+	{
+		x += 0x9e3779b97f4a7c15ull;
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+		return x ^ (x >> 31);
+	}
+
+	constexpr uint64_t HashMix(const uint64_t a, const uint64_t b) noexcept
+	{
+		return HashMix(a ^ HashMix(b));
+	}
+
+	/** FNV-1a */
+	inline uint64_t HashString(const std::string& str) noexcept
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (const char c : str)
+			hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+		return hash;
+	}
+
+	/**
+	 * Seeds for the song being built on this thread. While a scope is open, RandomSeed() mixes the song seed with the
+	 * JSON path the interpreter has reached and how many seeds were already drawn there, so each node gets the same
+	 * stream on every render whichever thread later runs it. Nodes must draw their seeds while they are being built.
+	 */
+	class SongSeed
+	{
+	private:
+		struct Level
+		{
+			uint64_t parent;
+			uint64_t hash;
+			uint64_t index;
+			uint64_t numDraws;
+		};
+
+		DEFINE_THREADLOCAL_PROPERTY(SongSeed*, Current, nullptr)
+
+		uint64_t Top() const noexcept
+		{
+			return path.empty() ? 0 : path.back().hash;
+		}
+
+	public:
+		/** Makes a song seed current for its lifetime; a seed given here overrides the one the song asks for */
+		class Scope;
+
+		static SongSeed* Current() noexcept
+		{
+			return GetCurrent();
+		}
+
+		static uint64_t GetSeed() noexcept
+		{
+			const SongSeed* const current = Current();
+			return current ? current->seed : 0;
+		}
+
+		/** Identifies the streams drawn at the current path */
+		static uint64_t PathKey() noexcept
+		{
+			const SongSeed* const current = Current();
+			return current ? HashMix(current->seed, current->Top()) : 0;
+		}
+
+		/** The seed from the song's meta; ignored if the scope was given one */
+		static void SetSeed(const uint64_t seed) noexcept
+		{
+			if (SongSeed* const current = Current(); current && !current->bOverridden)
+				current->seed = seed;
+		}
+
+		static void PathPush(const std::string& key)
+		{
+			if (SongSeed* const current = Current())
+			{
+				const uint64_t parent = current->Top();
+				current->path.push_back({ parent, HashMix(parent, HashString(key)), 0, 0 });
+			}
+		}
+
+		static void PathPush()
+		{
+			if (SongSeed* const current = Current())
+			{
+				const uint64_t parent = current->Top();
+				current->path.push_back({ parent, HashMix(parent, HashMix(0)), 0, 0 });
+			}
+		}
+
+		static void PathNext(const std::string& key) noexcept
+		{
+			if (SongSeed* const current = Current(); current && !current->path.empty())
+			{
+				Level& level = current->path.back();
+				level.hash = HashMix(level.parent, HashString(key));
+				level.numDraws = 0;
+			}
+		}
+
+		static void PathNext() noexcept
+		{
+			if (SongSeed* const current = Current(); current && !current->path.empty())
+			{
+				Level& level = current->path.back();
+				level.hash = HashMix(level.parent, HashMix(++level.index));
+				level.numDraws = 0;
+			}
+		}
+
+		static void PathPop() noexcept
+		{
+			if (SongSeed* const current = Current(); current && !current->path.empty())
+				current->path.pop_back();
+		}
+
+		/** Next seed for the current path */
+		Seed Draw() noexcept
+		{
+			uint64_t& numDraws = path.empty() ? rootDraws : path.back().numDraws;
+			const uint64_t lo = HashMix(HashMix(seed, Top()), numDraws++);
+			return Seed(lo, HashMix(lo));
+		}
+
+	private:
+		uint64_t seed = 0;
+		bool bOverridden = false;
+		Vector<Level> path;
+		uint64_t rootDraws = 0;
+	};
+
+	class SongSeed::Scope
+	{
+	public:
+		explicit Scope(const std::optional<uint64_t> seedOverride = std::nullopt)
+			: prev(GetCurrent())
+		{
+			if (seedOverride)
+			{
+				songSeed.seed = *seedOverride;
+				songSeed.bOverridden = true;
+			}
+			GetCurrent() = &songSeed;
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+		~Scope() noexcept
+		{
+			GetCurrent() = prev;
+		}
+
+	private:
+		SongSeed songSeed;
+		SongSeed* const prev;
+	};
+
+	/** Deterministic under a SongSeed::Scope, otherwise drawn from the system's entropy source */
 	inline Seed RandomSeed()
 	{
+		if (SongSeed* const songSeed = SongSeed::Current())
+			return songSeed->Draw();
 		static std::mutex mtx;
 		static std::random_device rd;
 		std::scoped_lock lock(mtx);
@@ -125,6 +293,14 @@ namespace json2wav
 		return seed;
 	}
 
+	/** Seed for a sub-stream, drawn from a generator that was itself seeded */
+	inline Seed SplitSeed(std::mt19937_64& seeder)
+	{
+		const uint64_t lo = seeder();
+		const uint64_t hi = seeder();
+		return Seed(lo, hi);
+	}
+
 	template<bool b64> struct MT_by_size { using type = std::mt19937; };
 	template<> struct MT_by_size<true> { using type = std::mt19937_64; };
 	template<typename T> struct MT { using type = typename MT_by_size<sizeof(T) >= 8>::type; };
@@ -146,6 +322,12 @@ namespace json2wav
 			return dist(mt);
 		}
 
+		/** Skips numDraws values; only for distributions that take one number from the engine per value */
+		void Discard(const unsigned long long numDraws)
+		{
+			mt.discard(numDraws);
+		}
+
 		void SetDist(const T arg1, const T arg2)
 		{
 			dist.param({ arg1, arg2 });
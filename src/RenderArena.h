@@ -0,0 +1,216 @@
+// Copyright Dan Price 2026.
+
+#pragma once
+
+#include "Macros.h"
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+
+namespace json2wav
+{
+	/**
+	 * Bump allocator for everything one song creates (graph nodes, events). Deallocating only counts down;
+	 * the blocks are freed together once the song's scope has closed and the last allocation is gone.
+	 */
+	class RenderArena
+	{
+	private:
+		static constexpr const size_t BlockSize = 1024 * 1024;
+		static constexpr const size_t MaxBumpSize = BlockSize / 8;
+
+		struct BlockHeader
+		{
+			BlockHeader* next;
+		};
+		static constexpr const size_t HeaderSize = (sizeof(BlockHeader) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+		DEFINE_THREADLOCAL_PROPERTY(RenderArena*, Current, nullptr)
+
+	public:
+		/** Makes a new arena current on this thread for its lifetime; MakeShared allocates from the current arena */
+		class Scope
+		{
+		public:
+			Scope()
+				: arena(new RenderArena()), prev(GetCurrent())
+			{
+				GetCurrent() = arena;
+			}
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+			~Scope() noexcept
+			{
+				GetCurrent() = prev;
+				arena->Close();
+			}
+
+		private:
+			RenderArena* const arena;
+			RenderArena* const prev;
+		};
+
+		/** Makes another thread's arena current on this one, for work handed to a worker thread */
+		class Use
+		{
+		public:
+			explicit Use(RenderArena* const arena) noexcept
+				: prev(GetCurrent())
+			{
+				GetCurrent() = arena;
+			}
+
+			Use(const Use&) = delete;
+			Use& operator=(const Use&) = delete;
+
+			~Use() noexcept
+			{
+				GetCurrent() = prev;
+			}
+
+		private:
+			RenderArena* const prev;
+		};
+
+		static RenderArena* Current() noexcept
+		{
+			return GetCurrent();
+		}
+
+		/** Bytes handed out so far, including what has since been deallocated */
+		size_t GetNumBytes() const noexcept
+		{
+			return numAllocatedBytes.load(std::memory_order_relaxed);
+		}
+
+		/** Allocations made so far, including those since deallocated */
+		size_t GetNumAllocations() const noexcept
+		{
+			return numAllocations.load(std::memory_order_relaxed);
+		}
+
+		void* Allocate(const size_t numBytes, const size_t alignBytes)
+		{
+			std::scoped_lock lock(mtx);
+			++numLive;
+			numAllocations.store(numAllocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			numAllocatedBytes.store(numAllocatedBytes.load(std::memory_order_relaxed) + numBytes, std::memory_order_relaxed);
+
+			if (numBytes + alignBytes > MaxBumpSize)
+				return AlignPtr(NewBlock(numBytes + alignBytes), alignBytes);
+
+			unsigned char* mem = AlignPtr(bump, alignBytes);
+			if (!bump || mem + numBytes > bumpEnd)
+			{
+				bump = NewBlock(BlockSize);
+				bumpEnd = bump + BlockSize;
+				mem = AlignPtr(bump, alignBytes);
+			}
+			bump = mem + numBytes;
+			return mem;
+		}
+
+		void Deallocate() noexcept
+		{
+			bool bRelease = false;
+			{
+				std::scoped_lock lock(mtx);
+				bRelease = --numLive == 0 && bClosed;
+			}
+			if (bRelease)
+				delete this;
+		}
+
+	private:
+		RenderArena() noexcept
+			: blocks(nullptr), bump(nullptr), bumpEnd(nullptr), numLive(0), numAllocations(0), numAllocatedBytes(0), bClosed(false)
+		{
+		}
+
+		~RenderArena() noexcept
+		{
+			while (blocks)
+			{
+				BlockHeader* const next = blocks->next;
+				std::free(blocks);
+				blocks = next;
+			}
+		}
+
+		void Close() noexcept
+		{
+			bool bRelease = false;
+			{
+				std::scoped_lock lock(mtx);
+				bClosed = true;
+				bRelease = numLive == 0;
+			}
+			if (bRelease)
+				delete this;
+		}
+
+		static unsigned char* AlignPtr(unsigned char* const ptr, const size_t alignBytes) noexcept
+		{
+			const uintptr_t addr = reinterpret_cast<uintptr_t>(ptr);
+			return ptr + (((addr + alignBytes - 1) & ~static_cast<uintptr_t>(alignBytes - 1)) - addr);
+		}
+
+		unsigned char* NewBlock(const size_t payloadBytes)
+		{
+			void* const mem = std::malloc(HeaderSize + payloadBytes);
+			if (!mem)
+				throw std::bad_alloc();
+			BlockHeader* const block = static_cast<BlockHeader*>(mem);
+			block->next = blocks;
+			blocks = block;
+			return static_cast<unsigned char*>(mem) + HeaderSize;
+		}
+
+	private:
+		std::mutex mtx;
+		BlockHeader* blocks;
+		unsigned char* bump;
+		unsigned char* bumpEnd;
+		size_t numLive;
+		std::atomic<size_t> numAllocations;
+		std::atomic<size_t> numAllocatedBytes;
+		bool bClosed;
+	};
+
+	/** std allocator over a RenderArena, for allocate_shared */
+	template<typename T>
+	class RenderArenaAllocator
+	{
+	public:
+		using value_type = T;
+
+		explicit RenderArenaAllocator(RenderArena* const arenaInit) noexcept : arena(arenaInit) {}
+
+		template<typename U>
+		RenderArenaAllocator(const RenderArenaAllocator<U>& other) noexcept : arena(other.arena) {}
+
+		T* allocate(const size_t n)
+		{
+			return static_cast<T*>(arena->Allocate(n * sizeof(T), alignof(T)));
+		}
+
+		void deallocate(T* const, const size_t) noexcept
+		{
+			arena->Deallocate();
+		}
+
+		template<typename U>
+		bool operator==(const RenderArenaAllocator<U>& other) const noexcept { return arena == other.arena; }
+
+		template<typename U>
+		friend class RenderArenaAllocator;
+
+	private:
+		RenderArena* arena;
+	};
+}
@@ -0,0 +1,54 @@
+// Copyright Dan Price 2026.
+
+#pragma once
+
+#include "Macros.h"
+#include <optional>
+
+namespace json2wav
+{
+	/**
+	 * The window of a song to render, in seconds. Everything before the window is fast-forwarded, except for a warm-up
+	 * plus the graph's latency, which are rendered and thrown away so effects hold what they would have held in a full
+	 * render by the time the window starts.
+	 */
+	struct RenderRange
+	{
+		double fromSeconds = 0.0;
+		std::optional<double> toSeconds; // The end of the song if unset
+		std::optional<double> warmupSeconds; // The graph's longest tail if unset; see IAudioObject::GetTailSamples
+
+		// Floor on warm-ups sized from tails, for the short memories nodes don't declare (filters, blep residue)
+		static constexpr const double MinWarmupSeconds = 0.25;
+	};
+
+	/**
+	 * Set while rendering the part of a song before a window's warm-up. Synths that can advance their state without
+	 * synthesizing do so and output silence. Filters and effects that would only carry that silence through, having
+	 * nothing left ringing in them, pass it on without running; everything else downstream runs as usual. It is set
+	 * per thread, and nodes that render their inputs on other threads carry it over, so graphs rendering different
+	 * windows at once don't see each other's.
+	 */
+	class FastForward
+	{
+		DEFINE_THREADLOCAL_PROPERTY(bool, Active, false)
+
+	public:
+		class Scope
+		{
+		public:
+			explicit Scope(const bool bActivate = true) noexcept : bPrev(GetActive()) { GetActive() = bActivate; }
+			~Scope() noexcept { GetActive() = bPrev; }
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+		private:
+			const bool bPrev;
+		};
+
+		static bool IsActive() noexcept
+		{
+			return GetActive();
+		}
+	};
+}
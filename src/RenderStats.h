@@ -0,0 +1,21 @@
+// Copyright Dan Price 2026.
+
+#pragma once
+
+#include <cstddef>
+
+namespace json2wav
+{
+	/** What rendering one song cost. A render given one of these skips writing the WAV and fills it in. */
+	struct RenderStats
+	{
+		size_t numSamples = 0;
+		unsigned long sampleRate = 0;
+		size_t numBlocks = 0;
+		double renderSeconds = 0.0; // Wall time of the block loop alone, without building the graph
+		size_t arenaAllocations = 0;
+		size_t arenaBytes = 0;
+		size_t stemHits = 0; // Stems played from the stem cache, if one was used
+		size_t stemMisses = 0;
+	};
+}
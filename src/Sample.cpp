@@ -1,21 +1,100 @@
 // Copyright Dan Price 2026.
 
 #include "Sample.h"
+#include <vector>
 #include <exception>
 
-static constexpr const size_t MaxBytes = 4ull * 1024ull * 1024ull * 1024ull;
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
 
-#define ALBUMBOT_USE_MALLOC 1
+// Address space reserved per pool region. Pages are committed lazily, so this only costs address space.
+#ifndef ALBUMBOT_SAMPLE_RESERVE_BYTES
+#define ALBUMBOT_SAMPLE_RESERVE_BYTES (64ull * 1024ull * 1024ull * 1024ull)
+#endif
 
-#if ALBUMBOT_USE_MALLOC
-#define ALBUMBOT_MAX_BYTES_PTR std::malloc(MaxBytes)
-#else
-static char thebytes[MaxBytes] = { 0 };
-#define ALBUMBOT_MAX_BYTES_PTR thebytes
+// Commit/release granularity; keep it a multiple of the 2 MB huge page size
+#ifndef ALBUMBOT_SAMPLE_COMMIT_BYTES
+#define ALBUMBOT_SAMPLE_COMMIT_BYTES (32ull * 1024ull * 1024ull)
 #endif
 
+// Set to 1 to advise transparent huge pages on committed chunks
+#ifndef ALBUMBOT_SAMPLE_HUGEPAGES
+#define ALBUMBOT_SAMPLE_HUGEPAGES 0
+#endif
+
+static constexpr const size_t ReserveBytes = ALBUMBOT_SAMPLE_RESERVE_BYTES;
+static constexpr const size_t CommitBytes = ALBUMBOT_SAMPLE_COMMIT_BYTES;
+static_assert(CommitBytes > 0 && (CommitBytes & (CommitBytes - 1)) == 0, "Commit granularity must be a power of 2");
+static_assert(ReserveBytes % CommitBytes == 0, "Reservation must be a whole number of commit chunks");
+
 namespace
 {
+	namespace VirtualMemory
+	{
+		void* Reserve(const size_t size) noexcept
+		{
+#ifdef _WIN32
+			return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+			void* const mem = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+			return (mem == MAP_FAILED) ? nullptr : mem;
+#endif
+		}
+
+		void Unreserve(void* const mem, const size_t size) noexcept
+		{
+#ifdef _WIN32
+			(void)size;
+			VirtualFree(mem, 0, MEM_RELEASE);
+#else
+			munmap(mem, size);
+#endif
+		}
+
+		bool Commit(void* const mem, const size_t size) noexcept
+		{
+#ifdef _WIN32
+			return VirtualAlloc(mem, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+			if (mprotect(mem, size, PROT_READ | PROT_WRITE) != 0)
+				return false;
+#if ALBUMBOT_SAMPLE_HUGEPAGES && defined(MADV_HUGEPAGE)
+			madvise(mem, size, MADV_HUGEPAGE);
+#endif
+			return true;
+#endif
+		}
+
+		// Drop the physical pages but keep the range committed
+		void Discard(void* const mem, const size_t size) noexcept
+		{
+#ifdef _WIN32
+			VirtualAlloc(mem, size, MEM_RESET, PAGE_READWRITE);
+#else
+			madvise(mem, size, MADV_DONTNEED);
+#endif
+		}
+
+		// Drop the physical pages and return the range to reserved-only
+		void Decommit(void* const mem, const size_t size) noexcept
+		{
+#ifdef _WIN32
+			VirtualFree(mem, size, MEM_DECOMMIT);
+#else
+			madvise(mem, size, MADV_DONTNEED);
+			mprotect(mem, size, PROT_NONE);
+#endif
+		}
+	}
 
 	class MemoryPool
 	{
@@ -53,22 +132,31 @@ namespace
 		{
 		};
 
-	private:
-		MemoryPool() : memory(ALBUMBOT_MAX_BYTES_PTR), totalmemsize(MaxBytes), blocksizes_end(0), freeblocks_end(0), alignment(8)
+		struct Region
 		{
-			if (!memory)
-			{
-				std::terminate();
-			}
+			void* reservation;
+			size_t reservationsize;
+			unsigned char* base;
+			size_t size;
+			size_t committed;
 
-			if (!push_freeblock(memory, totalmemsize))
+			bool contains(const void* const mem) const noexcept
 			{
-				std::terminate();
+				const unsigned char* const bytes = static_cast<const unsigned char*>(mem);
+				return bytes >= base && bytes < base + size;
 			}
+		};
+
+	private:
+		MemoryPool() : livebytes(0), alignment(json2wav::sampleAlignment)
+		{
 		}
 		~MemoryPool() noexcept
 		{
-			std::free(memory);
+			for (const Region& region : regions)
+			{
+				VirtualMemory::Unreserve(region.reservation, region.reservationsize);
+			}
 		}
 
 	public:
@@ -84,28 +172,19 @@ namespace
 			if (memsizerequest > 0)
 			{
 				const size_t memsize = memsizerequest + (alignment - (((memsizerequest - 1) % alignment) + 1));
-				for (size_t freeblocks_idx = 0; freeblocks_idx < freeblocks_end; ++freeblocks_idx)
+				for (size_t freeblocks_idx = 0; freeblocks_idx < freeblocks.size(); ++freeblocks_idx)
 				{
 					if (freeblocks[freeblocks_idx].size >= memsize)
 					{
-						void* const mem = freeblocks[freeblocks_idx].mem;
-						push_blocksize(mem, memsize);
-						void* const newblock = static_cast<void*>(static_cast<unsigned char*>(mem) + memsize);
-						const size_t newblocksize = freeblocks[freeblocks_idx].size - memsize;
-
-						if (newblocksize == 0)
-						{
-							remove_freeblock(freeblocks_idx);
-						}
-						else
-						{
-							freeblocks[freeblocks_idx].assign(newblock, newblocksize);
-						}
-
-						return mem;
+						return take_freeblock(freeblocks_idx, memsize);
 					}
 				}
 
+				if (reserve_region(memsize))
+				{
+					return take_freeblock(freeblocks.size() - 1, memsize);
+				}
+
 				throw json2wav::OutOfSampleMemory();
 			}
 
@@ -120,133 +199,202 @@ namespace
 			}
 
 			const size_t blocksizes_idx = find_blocksize(mem);
-			if (blocksizes_idx < blocksizes_end)
+			if (blocksizes_idx < blocksizes.size())
 			{
 				void* const nextblock = static_cast<void*>(static_cast<unsigned char*>(mem) + blocksizes[blocksizes_idx].size);
-				const size_t nextblockfree_idx = find_freeblock(nextblock);
+				const size_t nextblockfree_idx = find_region(mem)->contains(nextblock) ? find_freeblock(nextblock) : freeblocks.size();
 
-				if (nextblockfree_idx < freeblocks_end)
+				if (nextblockfree_idx < freeblocks.size())
 				{
 					freeblocks[nextblockfree_idx].mem = mem;
 					freeblocks[nextblockfree_idx].size += blocksizes[blocksizes_idx].size;
 				}
 				else
 				{
-					push_freeblock(blocksizes[blocksizes_idx]);
+					freeblocks.push_back(blocksizes[blocksizes_idx]);
 				}
 
-				remove_blocksize(blocksizes_idx);
+				livebytes -= blocksizes[blocksizes_idx].size;
+				remove_memsizepair(blocksizes, blocksizes_idx);
 			}
 		}
 
-	private:
-		bool push_blocksize(void* const mem, const size_t size)
+		size_t GetLiveBytes() const noexcept
 		{
-			return push_memsizepair(blocksizes, blocksizes_end, blocksizes_size, mem, size);
+			return livebytes;
 		}
 
-		bool push_blocksize(const MemSizePair& memsize)
+		size_t GetCommittedBytes() const noexcept
 		{
-			return push_memsizepair(blocksizes, blocksizes_end, blocksizes_size, memsize);
+			size_t committed = 0;
+			for (const Region& region : regions)
+			{
+				committed += region.committed;
+			}
+			return committed;
 		}
 
-		bool push_freeblock(void* const mem, const size_t size)
+		// Gives the pages of unused chunks back to the OS. Everything above the highest live block is decommitted;
+		// whole chunks inside free blocks below that stay committed but lose their physical pages.
+		void ReleaseMemory() noexcept
 		{
-			return push_memsizepair(freeblocks, freeblocks_end, freeblocks_size, mem, size);
+			for (Region& region : regions)
+			{
+				size_t highwater = 0;
+				for (const MemSizePair& block : blocksizes)
+				{
+					if (region.contains(block.mem))
+					{
+						const size_t blockend = static_cast<size_t>(static_cast<unsigned char*>(block.mem) - region.base) + block.size;
+						if (blockend > highwater)
+						{
+							highwater = blockend;
+						}
+					}
+				}
+
+				const size_t keep = round_up(highwater, CommitBytes);
+				if (keep < region.committed)
+				{
+					VirtualMemory::Decommit(region.base + keep, region.committed - keep);
+					region.committed = keep;
+				}
+			}
+
+			for (const MemSizePair& block : freeblocks)
+			{
+				const Region* const region = find_region(block.mem);
+				const size_t blockstart = static_cast<size_t>(static_cast<unsigned char*>(block.mem) - region->base);
+				const size_t blockend = blockstart + block.size;
+				const size_t first = round_up(blockstart, CommitBytes);
+				const size_t last = ((blockend < region->committed) ? blockend : region->committed) & ~(CommitBytes - 1);
+				if (first < last)
+				{
+					VirtualMemory::Discard(region->base + first, last - first);
+				}
+			}
 		}
 
-		bool push_freeblock(const MemSizePair& memsize)
+	private:
+		static constexpr size_t round_up(const size_t size, const size_t granularity) noexcept
 		{
-			return push_memsizepair(freeblocks, freeblocks_end, freeblocks_size, memsize);
+			return (size + granularity - 1) & ~(granularity - 1);
 		}
 
-		bool push_memsizepair(
-			MemSizePair* const memsizearr,
-			size_t& memsizearr_end,
-			const size_t memsizearr_size,
-			void* const mem,
-			const size_t size)
+		void* take_freeblock(const size_t freeblocks_idx, const size_t memsize)
 		{
-			if (memsizearr_end < memsizearr_size)
+			void* const mem = freeblocks[freeblocks_idx].mem;
+			if (!commit_through(mem, memsize))
+			{
+				throw json2wav::OutOfSampleMemory();
+			}
+
+			blocksizes.emplace_back(mem, memsize);
+			livebytes += memsize;
+			void* const newblock = static_cast<void*>(static_cast<unsigned char*>(mem) + memsize);
+			const size_t newblocksize = freeblocks[freeblocks_idx].size - memsize;
+
+			if (newblocksize == 0)
 			{
-				memsizearr[memsizearr_end++].assign(mem, size);
-				return true;
+				remove_memsizepair(freeblocks, freeblocks_idx);
 			}
-			return false;
+			else
+			{
+				freeblocks[freeblocks_idx].assign(newblock, newblocksize);
+			}
+
+			return mem;
 		}
 
-		bool push_memsizepair(
-			MemSizePair* const memsizearr,
-			size_t& memsizearr_end,
-			const size_t memsizearr_size,
-			const MemSizePair& memsize)
+		bool commit_through(void* const mem, const size_t memsize) noexcept
 		{
-			if (memsizearr_end < memsizearr_size)
+			Region* const region = find_region(mem);
+			const size_t end = static_cast<size_t>(static_cast<unsigned char*>(mem) - region->base) + memsize;
+			if (end > region->committed)
 			{
-				memsizearr[memsizearr_end++] = memsize;
-				return true;
+				const size_t newcommitted = round_up(end, CommitBytes);
+				if (!VirtualMemory::Commit(region->base + region->committed, newcommitted - region->committed))
+				{
+					return false;
+				}
+				region->committed = newcommitted;
 			}
-			return false;
+			return true;
 		}
 
-		bool remove_blocksize(const size_t idx)
+		// Reserve a new region big enough for minsize, backing off if the address space is constrained
+		bool reserve_region(const size_t minsize)
 		{
-			return remove_memsizepair(blocksizes, blocksizes_end, blocksizes_size, idx);
+			const size_t minregionsize = round_up(minsize, CommitBytes);
+			size_t regionsize = (minregionsize > ReserveBytes) ? minregionsize : ReserveBytes;
+			while (true)
+			{
+				// One extra chunk so the base can be aligned to the commit granularity (and huge pages)
+				const size_t reservationsize = regionsize + CommitBytes;
+				if (void* const reservation = VirtualMemory::Reserve(reservationsize))
+				{
+					unsigned char* const base = reinterpret_cast<unsigned char*>(round_up(reinterpret_cast<uintptr_t>(reservation), CommitBytes));
+					regions.push_back(Region{ reservation, reservationsize, base, regionsize, 0 });
+					freeblocks.emplace_back(base, regionsize);
+					return true;
+				}
+
+				if (regionsize / 2 < minregionsize)
+				{
+					return false;
+				}
+				regionsize = round_up(regionsize / 2, CommitBytes);
+			}
 		}
 
-		bool remove_freeblock(const size_t idx)
+		Region* find_region(const void* const mem) noexcept
 		{
-			return remove_memsizepair(freeblocks, freeblocks_end, freeblocks_size, idx);
+			for (Region& region : regions)
+			{
+				if (region.contains(mem))
+				{
+					return &region;
+				}
+			}
+			return nullptr;
 		}
 
-		bool remove_memsizepair(
-			MemSizePair* const memsizearr,
-			size_t& memsizearr_end,
-			const size_t memsizearr_size,
-			const size_t idx)
+		static void remove_memsizepair(std::vector<MemSizePair>& memsizearr, const size_t idx) noexcept
 		{
-			if (idx < memsizearr_end)
+			if (idx < memsizearr.size())
 			{
-				memsizearr[idx] = memsizearr[--memsizearr_end];
-				return true;
+				memsizearr[idx] = memsizearr.back();
+				memsizearr.pop_back();
 			}
-			return false;
 		}
 
-		size_t find_blocksize(void* const mem)
+		size_t find_blocksize(void* const mem) const noexcept
 		{
-			return find_memsizepair(blocksizes, blocksizes_end, mem);
+			return find_memsizepair(blocksizes, mem);
 		}
 
-		size_t find_freeblock(void* const mem)
+		size_t find_freeblock(void* const mem) const noexcept
 		{
-			return find_memsizepair(freeblocks, freeblocks_end, mem);
+			return find_memsizepair(freeblocks, mem);
 		}
 
-		size_t find_memsizepair(
-			MemSizePair* const memsizearr,
-			const size_t memsizearr_end,
-			void* const mem)
+		static size_t find_memsizepair(const std::vector<MemSizePair>& memsizearr, void* const mem) noexcept
 		{
-			for (size_t idx = 0; idx < memsizearr_end; ++idx)
+			for (size_t idx = 0; idx < memsizearr.size(); ++idx)
 			{
 				if (memsizearr[idx].mem == mem)
 				{
 					return idx;
 				}
 			}
-			return memsizearr_end;
+			return memsizearr.size();
 		}
 
 	private:
-		void* const memory;
-		const size_t totalmemsize;
-		static constexpr const size_t blocksizes_size = MaxBytes / json2wav::sampleChunkSize;
-		MemSizePair blocksizes[blocksizes_size];
-		size_t blocksizes_end;
-		static constexpr const size_t freeblocks_size = MaxBytes / json2wav::sampleChunkSize;
-		MemSizePair freeblocks[freeblocks_size];
-		size_t freeblocks_end;
+		std::vector<Region> regions;
+		std::vector<MemSizePair> blocksizes;
+		std::vector<MemSizePair> freeblocks;
+		size_t livebytes;
 		const size_t alignment;
 	};
 
@@ -256,24 +404,27 @@ namespace
 
 namespace json2wav
 {
-	Sample* SampleBuf::salloc(const size_t numsamples)
+	void* SampleBuf::balloc(const size_t numBytes)
 	{
-		return static_cast<Sample*>(mempool.GetMemory(numsamples * sizeof(Sample)));
+		return mempool.GetMemory(numBytes);
 	}
 
-	void SampleBuf::sfree(Sample* const mem) noexcept
+	void SampleBuf::bfree(void* const mem) noexcept
 	{
 		mempool.FreeMemory(mem);
 	}
 
-	Sample** SampleBuf::challoc(const size_t numchannels)
+	void SampleBuf::ReleaseUnusedMemory() noexcept
 	{
-		return static_cast<Sample**>(mempool.GetMemory(numchannels * sizeof(Sample*)));
+		std::scoped_lock lock(allocmtx);
+		mempool.ReleaseMemory();
 	}
 
-	void SampleBuf::chfree(Sample** const mem) noexcept
+	void SampleBuf::GetPoolBytes(size_t& liveBytes, size_t& committedBytes) noexcept
 	{
-		mempool.FreeMemory(mem);
+		std::scoped_lock lock(allocmtx);
+		liveBytes = mempool.GetLiveBytes();
+		committedBytes = mempool.GetCommittedBytes();
 	}
 
 	std::mutex SampleBuf::allocmtx;
@@ -4,11 +4,15 @@
 
 #include "FastSin.h"
 #include <new>
+#include <span>
+#include <memory>
+#include <type_traits>
 #include <stdexcept>
 #include <random>
 #include <mutex>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <cmath>
 
 #define INT24_MAX static_cast<int32_t>(8388607)
@@ -28,20 +32,32 @@ namespace json2wav
 		return (sampleType == ESampleType::Int16) ? 2 : (sampleType == ESampleType::Int24) ? 3 : 4;
 	}
 
+	/**
+	 * Generator behind dither(), one per thread so concurrent renders don't share it; reseed it on the thread that
+	 * converts a song to make the conversion repeatable
+	 */
+	inline std::mt19937& DitherEngine()
+	{
+		thread_local std::mt19937 mt([]()
+			{
+				static std::mutex mtx;
+				static std::random_device rd;
+				std::scoped_lock lock(mtx);
+				return rd();
+			}());
+		return mt;
+	}
+
 	inline float dither()
 	{
-		static std::random_device rd;
-		static std::mt19937 mt(rd());
-		static std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
-		return dist(mt);
+		std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+		return dist(DitherEngine());
 	}
 
 	struct Sample
 	{
 	public:
 		Sample() : data(0.0f) {}
-		Sample(const Sample& other) : data(other.data) {}
-		Sample(Sample&& other) noexcept : data(other.data) {}
 		explicit Sample(const float dataInit) : data(dataInit) {}
 
 		int16_t AsInt16() const
@@ -94,11 +110,6 @@ namespace json2wav
 			return *this;
 		}
 
-		Sample& operator=(const Sample& other)
-		{
-			data = other.data;
-			return *this;
-		}
 		Sample& operator+=(const Sample& other)
 		{
 			data += other.data;
@@ -120,44 +131,74 @@ namespace json2wav
 			return *this;
 		}
 
-		Sample& operator=(Sample&& other) noexcept
-		{
-			data = other.data;
-			return *this;
-		}
-
 	private:
 		float data;
 	};
 
+	static_assert(std::is_trivially_copyable_v<Sample> && std::is_standard_layout_v<Sample>, "Sample must stay a plain float");
+
+	constexpr const size_t sampleAlignment = 64;
+	constexpr const size_t sampleAlignmentNum = sampleAlignment / sizeof(Sample);
+
+	/** Number of samples between the starts of consecutive channels of a SampleBuf */
+	constexpr inline size_t GetSampleStride(const size_t bufSize) noexcept
+	{
+		return (bufSize + sampleAlignmentNum - 1) & ~(sampleAlignmentNum - 1);
+	}
+
+	inline std::span<float> AsSpan(Sample* const buf, const size_t numSamples) noexcept
+	{
+		return std::span<float>(reinterpret_cast<float*>(buf), numSamples);
+	}
+
+	inline std::span<const float> AsSpan(const Sample* const buf, const size_t numSamples) noexcept
+	{
+		return std::span<const float>(reinterpret_cast<const float*>(buf), numSamples);
+	}
+
+	/** Multichannel buffer in a single sampleAlignment-aligned allocation: the channel pointer table followed by
+	 *  the channels at a padded stride, so every channel starts on an alignment boundary */
 	class SampleBuf
 	{
 	private:
-		static Sample* salloc(const size_t numSamples);
-		static void sfree(Sample* const mem) noexcept;
-		static Sample** challoc(const size_t numChannels);
-		static void chfree(Sample** const mem) noexcept;
+		static void* balloc(const size_t numBytes);
+		static void bfree(void* const mem) noexcept;
 
 		static std::mutex allocmtx;
 
+		static constexpr size_t GetTableBytes(const size_t numChannels) noexcept
+		{
+			return (numChannels * sizeof(Sample*) + sampleAlignment - 1) & ~(sampleAlignment - 1);
+		}
+
 		static Sample** InitializeBufs(const size_t bufSize, const size_t numChannels)
 		{
-			Sample** const bufs = [numChannels]() { std::scoped_lock lock(allocmtx); return challoc(numChannels); }();
+			if (numChannels == 0)
+				return nullptr;
+
+			const size_t stride = GetSampleStride(bufSize);
+			const size_t tableBytes = GetTableBytes(numChannels);
+			const size_t numBytes = tableBytes + numChannels * stride * sizeof(Sample);
+			void* const mem = [numBytes]() { std::scoped_lock lock(allocmtx); return balloc(numBytes); }();
+			Sample** const bufs = static_cast<Sample**>(mem);
 			if (bufs)
 			{
+				Sample* const data = reinterpret_cast<Sample*>(static_cast<unsigned char*>(mem) + tableBytes);
+				for (size_t i = 0; i < numChannels * stride; ++i)
+					new (data + i) Sample();
 				for (size_t ch = 0; ch < numChannels; ++ch)
-				{
-					Sample* const buf = [bufSize]() { std::scoped_lock lock(allocmtx); return salloc(bufSize); }();
-					if (buf)
-						for (size_t i = 0; i < bufSize; ++i)
-							new (buf + i) Sample();
-					bufs[ch] = buf;
-				}
+					bufs[ch] = data + ch * stride;
 			}
 			return bufs;
 		}
 
 	public:
+		/** Return sample memory that no live SampleBuf is using to the OS, e.g. once a song has finished rendering */
+		static void ReleaseUnusedMemory() noexcept;
+
+		/** Bytes of sample memory held by live SampleBufs, and bytes the pool has committed */
+		static void GetPoolBytes(size_t& liveBytes, size_t& committedBytes) noexcept;
+
 		SampleBuf() noexcept
 			: bufs(nullptr), numChannels(0), bufSize(0), bInitialized(false), bZeroOnReinit(true)
 		{
@@ -171,15 +212,7 @@ namespace json2wav
 			bZeroOnReinit(other.bZeroOnReinit)
 		{
 			if (bufs)
-			{
-				for (size_t ch = 0; ch < numChannels; ++ch)
-				{
-					Sample* const buf = bufs[ch];
-					const Sample* const otherBuf = other.bufs[ch];
-					for (size_t smpnum = 0; smpnum < bufSize; ++smpnum)
-						buf[smpnum] = otherBuf[smpnum];
-				}
-			}
+				std::memcpy(bufs[0], other.bufs[0], numChannels * GetStride() * sizeof(Sample));
 		}
 
 		SampleBuf(SampleBuf&& other) noexcept
@@ -214,12 +247,7 @@ namespace json2wav
 				bZeroOnReinit = other.bZeroOnReinit;
 
 				for (size_t ch = 0; ch < numChannels; ++ch)
-				{
-					Sample* const buf = bufs[ch];
-					const Sample* const otherBuf = other.bufs[ch];
-					for (size_t smpnum = 0; smpnum < bufSize; ++smpnum)
-						buf[smpnum] = otherBuf[smpnum];
-				}
+					std::memcpy(bufs[ch], other.bufs[ch], bufSize * sizeof(Sample));
 			}
 
 			return *this;
@@ -274,6 +302,21 @@ namespace json2wav
 		Sample** get() noexcept { return bufs; }
 		const Sample* const* get() const noexcept { return bufs; }
 
+		size_t GetStride() const noexcept { return GetSampleStride(bufSize); }
+
+		std::span<float> GetSpan(const size_t chnum) noexcept
+		{
+			if (chnum >= numChannels)
+				return std::span<float>();
+			return std::span<float>(std::assume_aligned<sampleAlignment>(reinterpret_cast<float*>(bufs[chnum])), bufSize);
+		}
+		std::span<const float> GetSpan(const size_t chnum) const noexcept
+		{
+			if (chnum >= numChannels)
+				return std::span<const float>();
+			return std::span<const float>(std::assume_aligned<sampleAlignment>(reinterpret_cast<const float*>(bufs[chnum])), bufSize);
+		}
+
 		Sample* GetChannel(const size_t chnum) noexcept
 		{
 			return (chnum < numChannels) ? bufs[chnum] : nullptr;
@@ -321,12 +364,8 @@ namespace json2wav
 
 		void zero() noexcept
 		{
-			for (size_t ch = 0; ch < numChannels; ++ch)
-			{
-				Sample* buf(bufs[ch]);
-				for (size_t idx = 0; idx < bufSize; ++idx)
-					buf[idx] = 0.0f;
-			}
+			if (bufs)
+				std::memset(static_cast<void*>(bufs[0]), 0, numChannels * GetStride() * sizeof(Sample));
 		}
 
 		void SetZeroOnReinit(const bool bZeroOnReinitVal) noexcept
@@ -339,18 +378,8 @@ namespace json2wav
 		{
 			if (bufs)
 			{
-				for (size_t ch = 1; ch <= numChannels; ++ch)
-				{
-					Sample* const buf = bufs[numChannels - ch];
-					for (size_t i = 1; i <= bufSize; ++i)
-						(buf + bufSize - i)->~Sample();
-				}
-				{
-					std::scoped_lock lock(allocmtx);
-					for (size_t ch = 1; ch <= numChannels; ++ch)
-						sfree(bufs[numChannels - ch]);
-					chfree(bufs);
-				}
+				std::scoped_lock lock(allocmtx);
+				bfree(bufs);
 				bufs = nullptr;
 			}
 			numChannels = 0;
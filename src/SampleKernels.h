@@ -0,0 +1,189 @@
+// Copyright Dan Price 2026.
+
+#pragma once
+
+#include "Sample.h"
+#include "FastExp2.h"
+#include <span>
+#include <bit>
+#include <cstring>
+#include <cstdint>
+
+// Kernels take raw float spans so the compiler can vectorize them; dst and src never alias
+#define ALBUMBOT_RESTRICT __restrict
+
+namespace json2wav::kernel
+{
+	inline void Copy(const std::span<float> dst, const std::span<const float> src) noexcept
+	{
+		const size_t n = (dst.size() < src.size()) ? dst.size() : src.size();
+		if (n > 0)
+			std::memcpy(dst.data(), src.data(), n * sizeof(float));
+	}
+
+	inline void Zero(const std::span<float> dst) noexcept
+	{
+		if (!dst.empty())
+			std::memset(dst.data(), 0, dst.size_bytes());
+	}
+
+	/** Whether every sample is zero, either sign */
+	inline bool IsZero(const std::span<const float> src) noexcept
+	{
+		const float* const ALBUMBOT_RESTRICT s = src.data();
+		const size_t n = src.size();
+		uint32_t bits = 0;
+		for (size_t i = 0; i < n; ++i)
+			bits |= std::bit_cast<uint32_t>(s[i]);
+		return (bits & 0x7fffffffu) == 0;
+	}
+
+	/** dst += src */
+	inline void Add(const std::span<float> dst, const std::span<const float> src) noexcept
+	{
+		float* const ALBUMBOT_RESTRICT d = dst.data();
+		const float* const ALBUMBOT_RESTRICT s = src.data();
+		const size_t n = (dst.size() < src.size()) ? dst.size() : src.size();
+		for (size_t i = 0; i < n; ++i)
+			d[i] += s[i];
+	}
+
+	/** dst *= gain */
+	inline void Gain(const std::span<float> dst, const float gain) noexcept
+	{
+		float* const ALBUMBOT_RESTRICT d = dst.data();
+		const size_t n = dst.size();
+		for (size_t i = 0; i < n; ++i)
+			d[i] *= gain;
+	}
+
+	/** dst *= gains */
+	inline void Gain(const std::span<float> dst, const std::span<const float> gains) noexcept
+	{
+		float* const ALBUMBOT_RESTRICT d = dst.data();
+		const float* const ALBUMBOT_RESTRICT g = gains.data();
+		const size_t n = (dst.size() < gains.size()) ? dst.size() : gains.size();
+		for (size_t i = 0; i < n; ++i)
+			d[i] *= g[i];
+	}
+
+	/** buf = 10^(buf/20), by FastDBToGain */
+	inline void DBToGain(const std::span<float> buf) noexcept
+	{
+		float* const ALBUMBOT_RESTRICT b = buf.data();
+		const size_t n = buf.size();
+		for (size_t i = 0; i < n; ++i)
+			b[i] = FastDBToGain(b[i]);
+	}
+
+	/** dst += src * gain */
+	inline void AddGain(const std::span<float> dst, const std::span<const float> src, const float gain) noexcept
+	{
+		float* const ALBUMBOT_RESTRICT d = dst.data();
+		const float* const ALBUMBOT_RESTRICT s = src.data();
+		const size_t n = (dst.size() < src.size()) ? dst.size() : src.size();
+		for (size_t i = 0; i < n; ++i)
+			d[i] += s[i] * gain;
+	}
+
+	/** Apply a constant stereo pan: left *= leftGain, right *= rightGain */
+	inline void Pan(const std::span<float> left, const std::span<float> right, const float leftGain, const float rightGain) noexcept
+	{
+		float* const ALBUMBOT_RESTRICT l = left.data();
+		float* const ALBUMBOT_RESTRICT r = right.data();
+		const size_t n = (left.size() < right.size()) ? left.size() : right.size();
+		for (size_t i = 0; i < n; ++i)
+		{
+			l[i] *= leftGain;
+			r[i] *= rightGain;
+		}
+	}
+
+	/** Apply a constant stereo matrix: (left, right) = (m00*left + m01*right, m10*left + m11*right) */
+	inline void Mix2x2(const std::span<float> left, const std::span<float> right, const float (&m)[2][2]) noexcept
+	{
+		float* const ALBUMBOT_RESTRICT l = left.data();
+		float* const ALBUMBOT_RESTRICT r = right.data();
+		const float m00 = m[0][0], m01 = m[0][1], m10 = m[1][0], m11 = m[1][1];
+		const size_t n = (left.size() < right.size()) ? left.size() : right.size();
+		for (size_t i = 0; i < n; ++i)
+		{
+			const float x = l[i];
+			const float y = r[i];
+			l[i] = m00*x + m01*y;
+			r[i] = m10*x + m11*y;
+		}
+	}
+
+	/** Mix2x2 after scaling both channels by gains, in one pass */
+	inline void Mix2x2(const std::span<float> left, const std::span<float> right, const std::span<const float> gains,
+		const float (&m)[2][2]) noexcept
+	{
+		float* const ALBUMBOT_RESTRICT l = left.data();
+		float* const ALBUMBOT_RESTRICT r = right.data();
+		const float* const ALBUMBOT_RESTRICT g = gains.data();
+		const float m00 = m[0][0], m01 = m[0][1], m10 = m[1][0], m11 = m[1][1];
+		size_t n = (left.size() < right.size()) ? left.size() : right.size();
+		n = (n < gains.size()) ? n : gains.size();
+		for (size_t i = 0; i < n; ++i)
+		{
+			const float x = g[i]*l[i];
+			const float y = g[i]*r[i];
+			l[i] = m00*x + m01*y;
+			r[i] = m10*x + m11*y;
+		}
+	}
+
+	/** Transposed direct form II biquad with fixed coefficients (a0 normalized to 1); z holds the two state values */
+	template<typename FloatType>
+	inline void Biquad(const std::span<float> buf, const FloatType (&b)[3], const FloatType (&a)[3], FloatType (&z)[2]) noexcept
+	{
+		float* const ALBUMBOT_RESTRICT d = buf.data();
+		const size_t n = buf.size();
+		const FloatType b0 = b[0], b1 = b[1], b2 = b[2], a1 = a[1], a2 = a[2];
+		FloatType z1 = z[0], z2 = z[1];
+		for (size_t i = 0; i < n; ++i)
+		{
+			const FloatType x = static_cast<FloatType>(d[i]);
+			const FloatType y = b0 * x + z1;
+			z1 = b1 * x - a1 * y + z2;
+			z2 = b2 * x - a2 * y;
+			d[i] = static_cast<float>(y);
+		}
+		z[0] = z1;
+		z[1] = z2;
+	}
+
+	/** Convert one channel to little-endian PCM/float bytes, writing every dstStride bytes (the frame size when interleaving) */
+	template<ESampleType eSampleType>
+	inline void Convert(const std::span<const float> src, uint8_t* const dst, const size_t dstStride) noexcept
+	{
+		uint8_t* out = dst;
+		for (const float value : src)
+		{
+			if constexpr (eSampleType == ESampleType::Int16)
+			{
+				const int16_t sample16 = Sample(value).AsInt16();
+				out[0] = sample16 & 0xff;
+				out[1] = (sample16 >> 8) & 0xff;
+			}
+			else if constexpr (eSampleType == ESampleType::Int24)
+			{
+				const int32_t sample24 = Sample(value).AsInt24();
+				out[0] = sample24 & 0xff;
+				out[1] = (sample24 >> 8) & 0xff;
+				out[2] = (sample24 >> 16) & 0xff;
+			}
+			else
+			{
+				uint32_t sample32;
+				std::memcpy(&sample32, &value, sizeof(sample32));
+				out[0] = sample32 & 0xff;
+				out[1] = (sample32 >> 8) & 0xff;
+				out[2] = (sample32 >> 16) & 0xff;
+				out[3] = (sample32 >> 24) & 0xff;
+			}
+			out += dstStride;
+		}
+	}
+}
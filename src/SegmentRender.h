@@ -0,0 +1,79 @@
+// Copyright Dan Price 2026.
+
+#pragma once
+
+#include "Sample.h"
+#include "Memory.h"
+#include <functional>
+#include <future>
+#include <utility>
+
+namespace json2wav
+{
+	/**
+	 * Renders a song as numSegments stretches of its timeline at once, each on its own copy of the song's graph. Copies
+	 * are built one inside the other: each copy but the last adds its segment and builds the next, and the last renders
+	 * every segment on its own thread. With bCheckSeams, one more copy then renders the whole song serially for comparison.
+	 */
+	class SegmentRender
+	{
+	public:
+		/** Renders its segment into bufs, which hold the whole song */
+		using RenderFunc = std::function<void(Sample* const* const bufs)>;
+
+		SegmentRender(const size_t numSegmentsInit, const bool bCheckSeamsInit, std::function<bool()> buildNextInit)
+			: numSegments(numSegmentsInit), bCheckSeams(bCheckSeamsInit), buildNext(std::move(buildNextInit))
+		{
+		}
+
+		SegmentRender(const SegmentRender&) = delete;
+		SegmentRender& operator=(const SegmentRender&) = delete;
+
+		size_t GetNumSegments() const noexcept { return numSegments; }
+		size_t GetNumCopies() const noexcept { return numSegments + (bCheckSeams ? 1 : 0); }
+
+		/** The copy whose Write is running now; copies numSegments and up are the serial reference */
+		size_t GetCurrentCopy() const noexcept { return renders.size(); }
+
+		/** Adds the current copy's render and builds the next copy; false if the next copy couldn't be built */
+		bool AddAndBuildNext(RenderFunc render)
+		{
+			renders.push_back(std::move(render));
+			return buildNext();
+		}
+
+		/** Renders every segment at once into segmentBufs; with bCheckSeams the current copy is the serial reference */
+		void RenderAll(RenderFunc render, Sample* const* const segmentBufs)
+		{
+			renders.push_back(std::move(render));
+			Vector<std::future<void>> futs;
+			futs.reserve(numSegments);
+			for (size_t copy = 0; copy < numSegments && copy < renders.size(); ++copy)
+				futs.emplace_back(std::async(std::launch::async, [&render = renders[copy], segmentBufs]() { render(segmentBufs); }));
+			for (std::future<void>& fut : futs)
+				fut.get();
+		}
+
+		/** Renders the whole song on the serial reference copy after RenderAll, alone so its time can be compared */
+		void RenderSerial(Sample* const* const serialBufs)
+		{
+			if (bCheckSeams && renders.size() > numSegments)
+				renders[numSegments](serialBufs);
+		}
+
+		/** Largest difference from the serial render that --check-seams accepts: 1 LSB of 16-bit output */
+		static constexpr float MaxSeamError = 1.0f / 32768.0f;
+
+		void SetSeamError(const float err) noexcept { seamError = err; }
+
+		/** False if the seams were checked and the segmented render strayed more than MaxSeamError */
+		bool SeamsOk() const noexcept { return !(seamError > MaxSeamError); }
+
+	private:
+		const size_t numSegments;
+		const bool bCheckSeams;
+		const std::function<bool()> buildNext;
+		Vector<RenderFunc> renders;
+		float seamError = 0.0f;
+	};
+}
@@ -29,12 +29,24 @@ namespace json2wav
 
 			Sample* const buf = bufs[0];
 			const double deltatime = 1.0 / static_cast<double>(samplerate);
-			GetSynthSamples(bufs, numChannels, numSamples, true, [this, buf, deltatime](const size_t i)
+			GetSynthSamples(bufs, numChannels, numSamples, true, deltatime, [this, buf, deltatime](const size_t i)
 				{
 					Increment(deltatime);
 					buf[i] = GetAmplitude() * FastSinusoid<bSine>::template call<5>(GetInstantaneousPhase() * vTau<double>::value);
 				});
 		}
+
+	private:
+		virtual bool SkipSamples(const size_t numSamples, const double deltaTime) noexcept override
+		{
+			this->ProcessEventSpans(numSamples, [this, deltaTime](const size_t start, size_t count)
+				{
+					for ( ; count > 0 && IsRamping(); --count)
+						Increment(deltaTime);
+					IncrementSteady(count);
+				});
+			return true;
+		}
 	};
 
 	using CosineSynth = SinusoidSynth<false>;
@@ -0,0 +1,363 @@
+// Copyright Dan Price 2026.
+
+#pragma once
+
+#include "IAudioObject.h"
+#include "Random.h"
+#include "RenderStats.h"
+#include "Memory.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <string>
+#include <cstring>
+#include <cstdint>
+
+namespace json2wav
+{
+	/**
+	 * Plays back a cached stem in place of its inputs, or passes its inputs through and records them. A playing stem
+	 * keeps its inputs connected so delay compensation above it is unchanged; they just never get pulled.
+	 */
+	class StemNode : public AudioSum<>
+	{
+	public:
+		struct Header
+		{
+			char magic[8];
+			uint32_t version;
+			uint32_t numChannels;
+			uint64_t numSamples;
+			uint64_t key;
+		};
+
+		static constexpr const char Magic[8] = { 'J', '2', 'W', 'S', 'T', 'E', 'M', '\0' };
+
+		explicit StemNode(const uint64_t keyInit) : key(keyInit) {}
+
+		virtual void GetSamples(
+			Sample* const* const bufs,
+			const size_t numChannels,
+			const size_t bufSize,
+			const unsigned long sampleRate,
+			IAudioObject* const requester) noexcept override
+		{
+			lastNumChannels = numChannels;
+
+			// A stem recorded for another channel count can only be swapped out before anything has been pulled
+			if (bPlaying && numSamples == 0 && playHeader.numChannels != numChannels)
+			{
+				bPlaying = false;
+				in.close();
+			}
+
+			if (bPlaying)
+			{
+				for (size_t ch = 0; ch < numChannels; ++ch)
+					if (!in.read(reinterpret_cast<char*>(bufs[ch]), bufSize * sizeof(Sample)))
+						kernel::Zero(AsSpan(bufs[ch], bufSize));
+				numSamples += bufSize;
+				return;
+			}
+
+			this->GetInputSamples(bufs, numChannels, bufSize, sampleRate);
+			if (out.is_open())
+				for (size_t ch = 0; ch < numChannels; ++ch)
+					out.write(reinterpret_cast<const char*>(bufs[ch]), bufSize * sizeof(Sample));
+			numSamples += bufSize;
+		}
+
+		virtual size_t GetNumChannels() const noexcept override
+		{
+			return lastNumChannels;
+		}
+
+		uint64_t GetKey() const noexcept { return key; }
+		bool IsPlaying() const noexcept { return bPlaying; }
+		bool IsRecording() const noexcept { return out.is_open(); }
+		size_t GetNumSamples() const noexcept { return numSamples; }
+
+		/** Plays the stem at path if it was recorded from this key for at least minSamples */
+		bool Play(const std::filesystem::path& path, const size_t minSamples)
+		{
+			in.open(path, std::ios::binary);
+			if (in.read(reinterpret_cast<char*>(&playHeader), sizeof(playHeader))
+				&& std::memcmp(playHeader.magic, Magic, sizeof(Magic)) == 0
+				&& playHeader.key == key
+				&& playHeader.numSamples >= minSamples)
+			{
+				bPlaying = true;
+				return true;
+			}
+			in.close();
+			return false;
+		}
+
+		/** Records into path, which gets its header once the recording is finished */
+		void Record(const std::filesystem::path& path, const uint32_t version)
+		{
+			out.open(path, std::ios::binary | std::ios::trunc);
+			Header header{};
+			std::memcpy(header.magic, Magic, sizeof(Magic));
+			header.version = version;
+			header.key = key;
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			recordHeader = header;
+		}
+
+		/** Finishes a recording of numSamplesExpected samples; false if the render stopped short or the file failed */
+		bool FinishRecording(const size_t numSamplesExpected)
+		{
+			if (!out.is_open())
+				return false;
+			recordHeader.numChannels = static_cast<uint32_t>(lastNumChannels);
+			recordHeader.numSamples = numSamples;
+			out.seekp(0);
+			out.write(reinterpret_cast<const char*>(&recordHeader), sizeof(recordHeader));
+			const bool bGood = out.good() && numSamples == numSamplesExpected;
+			out.close();
+			return bGood;
+		}
+
+	private:
+		const uint64_t key;
+		size_t lastNumChannels = 0;
+		size_t numSamples = 0;
+		bool bPlaying = false;
+		Header playHeader{};
+		Header recordHeader{};
+		std::ifstream in;
+		std::ofstream out;
+	};
+
+	/**
+	 * On-disk cache of rendered part and bus stems, keyed by a hash of everything that decides how they sound: the
+	 * JSON subtree that built them with any presets it pulled in, the song's meta, sample rate, seed and the engine
+	 * version. Stems are raw float blocks; files least recently used are evicted once the cache outgrows its limit.
+	 */
+	class StemCache
+	{
+	public:
+		// Bump whenever a change to rendering would make old stems sound different
+		static constexpr const uint32_t EngineVersion = 1;
+
+		/** Walker events, as hashed into subtrees */
+		enum EEvent : uint64_t
+		{
+			PushKey = 1, PushIndex, NextKey, NextIndex, Pop, String, Number, Bool, Null
+		};
+
+		StemCache(std::string dirInit, const uint64_t maxBytesInit, RenderStats* const statsInit = nullptr)
+			: dir(std::move(dirInit)), maxBytes(maxBytesInit), stats(statsInit)
+		{
+			std::error_code ec;
+			std::filesystem::create_directories(dir, ec);
+		}
+
+		StemCache(const StemCache&) = delete;
+		StemCache& operator=(const StemCache&) = delete;
+
+		/** Starts hashing the walker events that follow into a new subtree hash */
+		void BeginSubtree()
+		{
+			subtrees.push_back(HashMix(EngineVersion));
+		}
+
+		uint64_t EndSubtree() noexcept
+		{
+			if (subtrees.empty())
+				return 0;
+			const uint64_t hash = subtrees.back();
+			subtrees.pop_back();
+			return hash;
+		}
+
+		/** Folds one walker event into every open subtree */
+		void HashEvent(const uint64_t tag, const uint64_t value = 0) noexcept
+		{
+			const uint64_t event = HashMix(tag, value);
+			for (uint64_t& subtree : subtrees)
+				subtree = HashMix(subtree, event);
+		}
+
+		void HashEvent(const uint64_t tag, const std::string& value) noexcept
+		{
+			HashEvent(tag, HashString(value));
+		}
+
+		void HashEvent(const uint64_t tag, const double value) noexcept
+		{
+			uint64_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			HashEvent(tag, bits);
+		}
+
+		void SetMetaHash(const uint64_t hash) noexcept { metaHash = hash; }
+		void SetMixerHash(const uint64_t hash) noexcept { mixerHash = hash; }
+
+		/** What every stem of the song depends on besides its own subtree */
+		uint64_t SongKey(const unsigned long sampleRate) const noexcept
+		{
+			return HashMix(HashMix(HashMix(EngineVersion), sampleRate), HashMix(metaHash, SongSeed::GetSeed()));
+		}
+
+		/** Part stems depend on their subtree and on the path their random streams are seeded from */
+		uint64_t PartKey(const unsigned long sampleRate, const uint64_t subtreeHash) const noexcept
+		{
+			return HashMix(SongKey(sampleRate), HashMix(SongSeed::PathKey(), subtreeHash));
+		}
+
+		/** Bus stems depend on the whole mixer and where the bus sits in it; the caller mixes in what feeds the bus */
+		uint64_t BusKey(const unsigned long sampleRate, const uint64_t busId) const noexcept
+		{
+			return HashMix(HashMix(SongKey(sampleRate), mixerHash), busId);
+		}
+
+		/** Moves output's inputs under a stem node with the given key */
+		void Insert(AudioJoin<>& output, const uint64_t key)
+		{
+			const SharedPtr<StemNode> stem(MakeShared<StemNode>(key));
+			Vector<SharedPtr<IAudioObject>> inputs;
+			inputs.reserve(output.GetInputs().size());
+			for (const auto& input : output.GetInputs())
+				if (SharedPtr<IAudioObject> audioObject = Utility::Lock(input))
+					inputs.emplace_back(std::move(audioObject));
+			output.ClearInputs();
+			for (SharedPtr<IAudioObject>& input : inputs)
+				stem->AddInput(std::move(input));
+			output.AddInput(stem);
+			stems.emplace_back(stem);
+		}
+
+		/** Decides, before rendering numSamples, which stems play from the cache and which are recorded */
+		void Prepare(const size_t numSamples)
+		{
+			numSamplesExpected = numSamples;
+			const auto now = std::filesystem::file_time_type::clock::now();
+			for (const SharedPtr<StemNode>& stem : stems)
+			{
+				const std::filesystem::path path(StemPath(stem->GetKey()));
+				if (stem->Play(path, numSamples))
+				{
+					std::error_code ec;
+					std::filesystem::last_write_time(path, now, ec);
+				}
+				else
+				{
+					stem->Record(TempPath(stem->GetKey()), EngineVersion);
+				}
+			}
+		}
+
+		/** Keeps the stems that were recorded in full, evicts old ones and reports how the cache did */
+		void Commit()
+		{
+			size_t numHits = 0;
+			size_t numMisses = 0;
+			size_t numWritten = 0;
+			for (const SharedPtr<StemNode>& stem : stems)
+			{
+				if (stem->IsPlaying() && stem->GetNumSamples() > 0)
+					++numHits;
+				else if (stem->GetNumSamples() > 0)
+					++numMisses;
+
+				if (stem->IsRecording())
+				{
+					std::error_code ec;
+					if (stem->FinishRecording(numSamplesExpected))
+					{
+						std::filesystem::rename(TempPath(stem->GetKey()), StemPath(stem->GetKey()), ec);
+						if (!ec)
+							++numWritten;
+					}
+					else
+						std::filesystem::remove(TempPath(stem->GetKey()), ec);
+				}
+			}
+			stems.clear();
+
+			const size_t numEvicted = Evict();
+			if (stats)
+			{
+				stats->stemHits = numHits;
+				stats->stemMisses = numMisses;
+			}
+			else
+			{
+				std::cout << "Stem cache: " << numHits << " hits, " << numMisses << " misses, "
+					<< numWritten << " stems written, " << numEvicted << " evicted\n";
+			}
+		}
+
+	private:
+		std::filesystem::path StemPath(const uint64_t key) const
+		{
+			return std::filesystem::path(dir) / (KeyName(key) + ".stem");
+		}
+
+		std::filesystem::path TempPath(const uint64_t key) const
+		{
+			return std::filesystem::path(dir) / (KeyName(key) + ".stem.tmp");
+		}
+
+		static std::string KeyName(const uint64_t key)
+		{
+			static constexpr const char hex[] = "0123456789abcdef";
+			std::string name(16, '0');
+			for (size_t digit = 0; digit < 16; ++digit)
+				name[15 - digit] = hex[(key >> (4 * digit)) & 0xf];
+			return name;
+		}
+
+		/** Removes least recently used stems until the cache fits in maxBytes */
+		size_t Evict()
+		{
+			struct Entry
+			{
+				std::filesystem::path path;
+				std::filesystem::file_time_type time;
+				uint64_t size;
+			};
+
+			std::error_code ec;
+			Vector<Entry> entries;
+			uint64_t totalBytes = 0;
+			for (const auto& file : std::filesystem::directory_iterator(dir, ec))
+			{
+				if (!file.is_regular_file(ec) || file.path().extension() != ".stem")
+					continue;
+				const uint64_t size = file.file_size(ec);
+				if (ec)
+					continue;
+				entries.push_back({ file.path(), file.last_write_time(ec), size });
+				totalBytes += size;
+			}
+
+			std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) { return lhs.time < rhs.time; });
+			size_t numEvicted = 0;
+			for (const Entry& entry : entries)
+			{
+				if (totalBytes <= maxBytes)
+					break;
+				if (std::filesystem::remove(entry.path, ec))
+				{
+					totalBytes -= entry.size;
+					++numEvicted;
+				}
+			}
+			return numEvicted;
+		}
+
+	private:
+		const std::string dir;
+		const uint64_t maxBytes;
+		RenderStats* const stats;
+		Vector<uint64_t> subtrees;
+		uint64_t metaHash = 0;
+		uint64_t mixerHash = 0;
+		Vector<SharedPtr<StemNode>> stems;
+		size_t numSamplesExpected = 0;
+	};
+}
@@ -4,6 +4,8 @@
 
 #include "Instrument.h"
 #include "Ramp.h"
+#include "SampleKernels.h"
+#include "RenderRange.h"
 #include <utility>
 #include <cmath>
 
@@ -152,32 +154,55 @@ namespace json2wav
 			}
 		}
 
+		/** Whether any ramp would still move frequency, amplitude or phase offset */
+		bool IsRamping() const noexcept
+		{
+			return frequency_ramp.IsActive() || amplitude_ramp.IsActive() || phase_ramp.IsActive();
+		}
+
+		/** Does what numSamples calls to Increment would while nothing is ramping */
+		void IncrementSteady(const size_t numSamples) noexcept
+		{
+			const double nextphase(phase + static_cast<double>(numSamples) * deltaphase_cached);
+			phase = nextphase - std::floor(nextphase);
+		}
+
 		template<typename ProcSampFunc>
 		void GetSynthSamples(Sample* const* const bufs, const size_t numChannels, const size_t numSamples,
-			const bool bCopyFirstChannel, ProcSampFunc&& ProcessSample) noexcept
+			const bool bCopyFirstChannel, const double deltaTime, ProcSampFunc&& ProcessSample) noexcept
 		{
 			if (numChannels == 0)
 			{
 				return;
 			}
 
+			if (FastForward::IsActive() && SkipSamples(numSamples, deltaTime))
+			{
+				for (size_t ch = 0; ch < numChannels; ++ch)
+				{
+					kernel::Zero(AsSpan(bufs[ch], numSamples));
+				}
+				return;
+			}
+
 			this->ProcessEvents(numSamples, std::forward<ProcSampFunc>(ProcessSample));
 
 			if (bCopyFirstChannel)
 			{
-				Sample* const buf = bufs[0];
 				for (size_t ch = 1; ch < numChannels; ++ch)
 				{
-					Sample* const chbuf = bufs[ch];
-					for (size_t i = 0; i < numSamples; ++i)
-					{
-						chbuf[i] = buf[i];
-					}
+					kernel::Copy(AsSpan(bufs[ch], numSamples), AsSpan(bufs[0], numSamples));
 				}
 			}
 		}
 
 	private:
+		/**
+		 * Advances numSamples, events included, without synthesizing them, while FastForward is active. Synths that
+		 * can't do that any cheaper than rendering return false and render as usual.
+		 */
+		virtual bool SkipSamples(const size_t numSamples, const double deltaTime) noexcept { return false; }
+
 		virtual void OnFrequencyChange(const float freq, const double deltaTime) {}
 		virtual void OnAmplitudeChange(const float amp, const double deltaTime) {}
 		virtual void OnPhaseOffsetChange(const double phoffset, const double deltaTime) {}
@@ -0,0 +1,176 @@
+// Copyright Dan Price 2026.
+
+#pragma once
+
+#include "MemoryCommon.h"
+#include "Macros.h"
+#include <atomic>
+#include <shared_mutex>
+#include <thread>
+#include <cstdint>
+
+namespace json2wav
+{
+	/**
+	 * Allocator state owned by one thread at a time. Heaps are never freed: a thread that exits abandons its heap,
+	 * and the next thread that needs one adopts it along with whatever it had cached.
+	 */
+	struct ThreadHeapBase
+	{
+		static constexpr uint32_t SerialBatch = 256;
+
+		// Tracking indices freed by other threads; they push with CAS and the owner takes the whole list with exchange
+		alignas(64) std::atomic<uint32_t> RemoteTop = InvalidUint32();
+
+		// Written only by the owning thread; TearDown waits for every heap to read zero
+		alignas(64) std::atomic<uint32_t> Busy = 0;
+		std::atomic<uint32_t> bOwned = 0;
+		uint32_t HeapIndex = InvalidUint32();
+		uint32_t NextSerial = 0;
+		uint32_t SerialEnd = 0;
+
+		uint32_t TakeSerial(std::atomic<uint32_t>& GlobalSerial) noexcept
+		{
+			if (NextSerial == SerialEnd)
+			{
+				NextSerial = GlobalSerial.fetch_add(SerialBatch);
+				SerialEnd = NextSerial + SerialBatch;
+			}
+			const uint32_t Serial = NextSerial++;
+			return Serial != InvalidUint32() ? Serial : TakeSerial(GlobalSerial);
+		}
+
+		/** SetNext(Index, Next) links a freed index to the rest of the list, wherever the allocator keeps its links */
+		template<typename SetNextType>
+		void PushRemote(uint32_t Index, SetNextType&& SetNext) noexcept
+		{
+			uint32_t Top = RemoteTop.load(std::memory_order_relaxed);
+			do
+			{
+				SetNext(Index, Top);
+			} while (!RemoteTop.compare_exchange_weak(Top, Index, std::memory_order_release, std::memory_order_relaxed));
+		}
+
+		uint32_t TakeRemote() noexcept
+		{
+			if (RemoteTop.load(std::memory_order_relaxed) == InvalidUint32())
+			{
+				return InvalidUint32();
+			}
+			return RemoteTop.exchange(InvalidUint32(), std::memory_order_acquire);
+		}
+	};
+
+	/** Hands each thread a heap of HeapType, adopting abandoned heaps before creating new ones */
+	template<typename HeapType, uint32_t MaxHeaps>
+	class ThreadHeapRegistry
+	{
+	private:
+		class Owner
+		{
+		public:
+			Owner() noexcept : Heap(nullptr) {}
+			Owner(const Owner&) = delete;
+			Owner& operator=(const Owner&) = delete;
+			~Owner() noexcept
+			{
+				if (Heap)
+				{
+					Heap->bOwned.store(0, std::memory_order_release);
+				}
+			}
+			HeapType* Heap;
+		};
+
+		static std::atomic<HeapType*>* GetHeaps() noexcept
+		{
+			static std::atomic<HeapType*> Heaps[MaxHeaps] = {};
+			return &Heaps[0];
+		}
+
+		DEFINE_STATIC_PROPERTY(std::atomic<uint32_t>, NumHeaps, 0);
+		DEFINE_STATIC_PROPERTY(std::atomic<uint32_t>, TearingDown, 0);
+		DEFINE_THREADLOCAL_PROPERTY(Owner, ThreadOwner);
+
+		static HeapType* Acquire()
+		{
+			const uint32_t NumHeaps = GetNumHeaps().load(std::memory_order_acquire);
+			for (uint32_t HeapIndex = 0; HeapIndex < NumHeaps && HeapIndex < MaxHeaps; ++HeapIndex)
+			{
+				HeapType* Heap = GetHeaps()[HeapIndex].load(std::memory_order_acquire);
+				uint32_t bOwned = 0;
+				if (Heap && Heap->bOwned.load(std::memory_order_relaxed) == 0 && Heap->bOwned.compare_exchange_strong(bOwned, 1, std::memory_order_acquire))
+				{
+					return Heap;
+				}
+			}
+
+			const uint32_t HeapIndex = GetNumHeaps().fetch_add(1);
+			if (HeapIndex >= MaxHeaps)
+			{
+				GetNumHeaps().fetch_sub(1);
+				MemoryError("ThreadHeapRegistry::Acquire ran out of heaps; more than ", MaxHeaps, " threads are allocating at once");
+				return nullptr;
+			}
+
+			HeapType* Heap = new HeapType();
+			Heap->HeapIndex = HeapIndex;
+			Heap->bOwned.store(1, std::memory_order_relaxed);
+			GetHeaps()[HeapIndex].store(Heap, std::memory_order_release);
+			return Heap;
+		}
+
+	public:
+		/** The calling thread's heap, adopting or creating one on first use */
+		static HeapType& Get()
+		{
+			Owner& ThreadOwner = GetThreadOwner();
+			if (!ThreadOwner.Heap)
+			{
+				ThreadOwner.Heap = Acquire();
+			}
+			return *ThreadOwner.Heap;
+		}
+
+		/** A heap by index, for pushing remote frees to its owner; heaps are never freed, so the pointer stays valid */
+		static HeapType* At(uint32_t HeapIndex) noexcept
+		{
+			return HeapIndex < MaxHeaps ? GetHeaps()[HeapIndex].load(std::memory_order_acquire) : nullptr;
+		}
+
+		static ThreadHeapPin Pin(HeapType& Heap, std::shared_mutex& Mutex)
+		{
+			return ThreadHeapPin(Heap.Busy, GetTearingDown(), Mutex);
+		}
+
+		/**
+		 * Call with the allocator's mutex held exclusively. Waits for every pinned heap, then calls Reset on each heap so
+		 * nothing cached survives the arenas it points into.
+		 */
+		template<typename ResetType>
+		static void TearDown(ResetType&& Reset)
+		{
+			GetTearingDown().store(1);
+
+			const uint32_t NumHeaps = GetNumHeaps().load();
+			for (uint32_t HeapIndex = 0; HeapIndex < NumHeaps && HeapIndex < MaxHeaps; ++HeapIndex)
+			{
+				if (HeapType* Heap = GetHeaps()[HeapIndex].load())
+				{
+					// The current thread may be tearing down from inside one of its own allocations
+					const bool bCurrentThread = Heap == GetThreadOwner().Heap;
+					while (!bCurrentThread && Heap->Busy.load() != 0)
+					{
+						std::this_thread::yield();
+					}
+					Heap->RemoteTop.store(InvalidUint32());
+					Heap->NextSerial = 0;
+					Heap->SerialEnd = 0;
+					Reset(*Heap);
+				}
+			}
+
+			GetTearingDown().store(0);
+		}
+	};
+}
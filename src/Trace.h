@@ -0,0 +1,270 @@
+// Copyright Dan Price 2026.
+
+#pragma once
+
+#ifdef ALBUMBOT_TRACE
+#include "ThreadHeap.h"
+#include "NodeNames.h"
+#include "Macros.h"
+#include <unordered_map>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <typeinfo>
+#include <cstdint>
+
+// Events kept per thread; older events are overwritten once a thread's ring is full
+#ifndef ALBUMBOT_TRACE_EVENTS
+#define ALBUMBOT_TRACE_EVENTS (64 * 1024)
+#endif
+#endif
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace json2wav::trace
+{
+#ifdef ALBUMBOT_TRACE
+	static_assert((ALBUMBOT_TRACE_EVENTS & (ALBUMBOT_TRACE_EVENTS - 1)) == 0, "Trace rings must be a power of 2");
+
+	enum class EEventType : uint8_t
+	{
+		Span,
+		NodeSpan,
+		Counter
+	};
+
+	struct Event
+	{
+		const char* name;
+		const void* node;
+		const std::type_info* type;
+		uint64_t ts;
+		uint64_t dur;
+		int64_t value;
+		EEventType eType;
+	};
+
+	/**
+	 * One thread's events. Only the owning thread writes, so pushing is a store and a release; rings are read once every
+	 * thread that wrote to them has been joined. Render threads come and go every block, so rings are handed on like
+	 * allocator heaps and each ring shows up as one lane of the trace.
+	 */
+	struct Ring : ThreadHeapBase
+	{
+		static constexpr size_t Capacity = ALBUMBOT_TRACE_EVENTS;
+
+		Ring() : events(new Event[Capacity]) {}
+
+		void Push(const Event& event) noexcept
+		{
+			const uint64_t idx = head.load(std::memory_order_relaxed);
+			events[idx & (Capacity - 1)] = event;
+			head.store(idx + 1, std::memory_order_release);
+		}
+
+		std::unique_ptr<Event[]> events;
+		std::atomic<uint64_t> head = 0;
+	};
+
+	class Tracer
+	{
+	private:
+		static constexpr uint32_t MaxRings = 256;
+		using Registry = ThreadHeapRegistry<Ring, MaxRings>;
+
+		DEFINE_STATIC_PROPERTY(std::chrono::steady_clock::time_point, Epoch, std::chrono::steady_clock::now());
+		DEFINE_STATIC_PROPERTY(std::atomic<int64_t>, NumInFlight, 0);
+
+		static std::string Escape(const std::string& str)
+		{
+			std::string escaped;
+			for (const char c : str)
+			{
+				if (c == '"' || c == '\\')
+					escaped.push_back('\\');
+				escaped.push_back(c);
+			}
+			return escaped;
+		}
+
+		static void WriteTime(std::ostream& out, const uint64_t ns)
+		{
+			// Microseconds with nanosecond precision, without going through floating point
+			out << ns / 1000 << '.' << static_cast<char>('0' + (ns / 100) % 10) << static_cast<char>('0' + (ns / 10) % 10)
+				<< static_cast<char>('0' + ns % 10);
+		}
+
+	public:
+		static uint64_t Now() noexcept
+		{
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - GetEpoch()).count());
+		}
+
+		static void Push(const Event& event) noexcept
+		{
+			Registry::Get().Push(event);
+		}
+
+		static void Counter(const char* const name, const int64_t value) noexcept
+		{
+			Push(Event{ name, nullptr, nullptr, Now(), 0, value, EEventType::Counter });
+		}
+
+		static void AddInFlight(const int64_t delta) noexcept
+		{
+			Counter("inputs in flight", GetNumInFlight().fetch_add(delta) + delta);
+		}
+
+		/** Writes everything recorded so far to name.trace.json and empties the rings; call with no render running */
+		static void Flush(const std::string& name)
+		{
+			const std::string filename(name + ".trace.json");
+			std::ofstream out(filename);
+			out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+			out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"" << Escape(name) << "\"}}";
+
+			std::unordered_map<const void*, std::string> nodeNames;
+			for (uint32_t ringIndex = 0; Ring* const ring = Registry::At(ringIndex); ++ringIndex)
+			{
+				const uint64_t head = ring->head.load(std::memory_order_acquire);
+				const uint64_t first = (head > Ring::Capacity) ? head - Ring::Capacity : 0;
+				if (first > 0)
+					std::cerr << "Trace ring " << ringIndex << " dropped its " << first << " oldest events\n";
+				if (head == first)
+					continue;
+
+				out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ringIndex
+					<< ",\"args\":{\"name\":\"render thread " << ringIndex << "\"}}";
+				for (uint64_t idx = first; idx < head; ++idx)
+				{
+					const Event& event = ring->events[idx & (Ring::Capacity - 1)];
+					out << ",\n{\"pid\":1,\"tid\":" << ringIndex << ",\"ts\":";
+					WriteTime(out, event.ts);
+					switch (event.eType)
+					{
+					case EEventType::Span:
+						out << ",\"ph\":\"X\",\"cat\":\"render\",\"name\":\"" << event.name << "\",\"dur\":";
+						WriteTime(out, event.dur);
+						out << ",\"args\":{\"value\":" << event.value << "}}";
+						break;
+					case EEventType::NodeSpan:
+						{
+							auto found = nodeNames.find(event.node);
+							if (found == nodeNames.end())
+							{
+								std::string nodeName(NodeNames::Find(event.node));
+								if (nodeName.empty())
+									nodeName = NodeNames::ShortTypeName(*event.type);
+								found = nodeNames.emplace(event.node, Escape(nodeName)).first;
+							}
+							out << ",\"ph\":\"X\",\"cat\":\"node\",\"name\":\"" << found->second << "\",\"dur\":";
+							WriteTime(out, event.dur);
+							out << ",\"args\":{\"node\":\"" << event.node << "\",\"samples\":" << event.value << "}}";
+						} break;
+					case EEventType::Counter:
+						out << ",\"ph\":\"C\",\"name\":\"" << event.name << "\",\"args\":{\"value\":" << event.value << "}}";
+						break;
+					}
+				}
+				ring->head.store(0, std::memory_order_relaxed);
+			}
+
+			out << "\n]}\n";
+			std::cout << "Wrote " << filename << '\n';
+		}
+	};
+
+	/** A named span on the calling thread, e.g. one block of the render */
+	class Span
+	{
+	public:
+		Span(const char* const nameInit, const int64_t valueInit = 0) noexcept
+			: name(nameInit), value(valueInit), start(Tracer::Now())
+		{
+		}
+
+		Span(const Span&) = delete;
+		Span& operator=(const Span&) = delete;
+
+		~Span() noexcept
+		{
+			Tracer::Push(Event{ name, nullptr, nullptr, start, Tracer::Now() - start, value, EEventType::Span });
+		}
+
+	private:
+		const char* name;
+		int64_t value;
+		uint64_t start;
+	};
+
+	/** One GetSamples call of a node */
+	class NodeSpan
+	{
+	public:
+		template<typename NodeType>
+		NodeSpan(const NodeType& nodeInit, const size_t numSamplesInit) noexcept
+			: node(&nodeInit), type(&typeid(nodeInit)), numSamples(numSamplesInit), start(Tracer::Now())
+		{
+		}
+
+		NodeSpan(const NodeSpan&) = delete;
+		NodeSpan& operator=(const NodeSpan&) = delete;
+
+		~NodeSpan() noexcept
+		{
+			Tracer::Push(Event{ nullptr, node, type, start, Tracer::Now() - start, static_cast<int64_t>(numSamples), EEventType::NodeSpan });
+		}
+
+	private:
+		const void* node;
+		const std::type_info* type;
+		size_t numSamples;
+		uint64_t start;
+	};
+
+	/** Input renders handed to other threads and not finished yet: +1 when launching one, -1 as it finishes */
+	inline void AddInFlight(const int64_t delta) noexcept
+	{
+		Tracer::AddInFlight(delta);
+	}
+
+	inline void Counter(const char* const name, const int64_t value) noexcept
+	{
+		Tracer::Counter(name, value);
+	}
+
+	inline void Flush(const std::string& name)
+	{
+		Tracer::Flush(name);
+	}
+#else
+	class Span
+	{
+	public:
+		Span(const char*, int64_t = 0) noexcept {}
+		Span(const Span&) = delete;
+		Span& operator=(const Span&) = delete;
+	};
+
+	class NodeSpan
+	{
+	public:
+		template<typename NodeType>
+		NodeSpan(const NodeType&, size_t) noexcept {}
+		NodeSpan(const NodeSpan&) = delete;
+		NodeSpan& operator=(const NodeSpan&) = delete;
+	};
+
+	inline void AddInFlight(int64_t) noexcept {}
+
+	inline void Counter(const char*, int64_t) noexcept {}
+
+	inline void Flush(const std::string&) {}
+#endif
+}
@@ -2,8 +2,114 @@
 
 #include "JsonToWav.h"
 #include "Memory.h"
+#ifdef ALBUMBOT_DEBUGNEW
+#include "DebugNew.h"
+#endif
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
 #include <vector>
 #include <string>
+#include <iterator>
+#include <optional>
+#include <chrono>
+#include <iostream>
+#include <ctime>
+#include <cstdlib>
+#include <cstdint>
+
+namespace
+{
+	// Songs rendered by --bench when none are named; run from the repo root so their presets resolve
+	const char* const benchCorpus[] = { "songs/groovoove.json", "songs/hello.json" };
+
+	/** The most memory the process has had resident so far */
+	uint64_t GetPeakRssBytes() noexcept
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			return static_cast<uint64_t>(counters.PeakWorkingSetSize);
+		return 0;
+#else
+		struct rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) != 0)
+			return 0;
+#ifdef __APPLE__
+		return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+		return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+	}
+
+	std::string JsonEscape(const std::string& str)
+	{
+		std::string escaped;
+		for (const char c : str)
+		{
+			if (c == '"' || c == '\\')
+				escaped.push_back('\\');
+			escaped.push_back(c);
+		}
+		return escaped;
+	}
+
+	/**
+	 * Renders every song numRuns times without writing it, printing one JSON object per render. The keys and their
+	 * order are fixed so runs can be diffed or collected by scripts; heapAllocations is null unless ALBUMBOT_DEBUGNEW
+	 * replaces operator new.
+	 */
+	int Bench(const json2wav::Vector<std::string>& filenames, const size_t numRuns, const std::optional<uint64_t> seed,
+		const json2wav::StemCacheOptions* const stemCache)
+	{
+		for (const std::string& filename : filenames)
+		{
+			for (size_t run = 1; run <= numRuns; ++run)
+			{
+				json2wav::RenderStats stats;
+#ifdef ALBUMBOT_DEBUGNEW
+				json2wav::QueryNumAllocs();
+#endif
+				const std::clock_t cpuStart = std::clock();
+				const auto wallStart = std::chrono::steady_clock::now();
+				const int result = json2wav::JsonToWav(filename.c_str(), false, false, &stats, seed, stemCache);
+				const double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+				const double cpuSeconds = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+				if (result != 0)
+				{
+					std::cerr << "Couldn't render " << filename << " for benchmarking\n";
+					return result;
+				}
+
+				const double audioSeconds = (stats.sampleRate > 0) ? static_cast<double>(stats.numSamples) / stats.sampleRate : 0.0;
+				std::cout << "{\"song\":\"" << JsonEscape(filename) << "\",\"run\":" << run
+					<< ",\"audioSeconds\":" << audioSeconds
+					<< ",\"wallSeconds\":" << wallSeconds
+					<< ",\"renderSeconds\":" << stats.renderSeconds
+					<< ",\"cpuSeconds\":" << cpuSeconds
+					<< ",\"realtimeFactor\":" << ((wallSeconds > 0.0) ? audioSeconds / wallSeconds : 0.0)
+					<< ",\"blocksPerSecond\":" << ((stats.renderSeconds > 0.0) ? static_cast<double>(stats.numBlocks) / stats.renderSeconds : 0.0)
+					<< ",\"peakRssBytes\":" << GetPeakRssBytes()
+					<< ",\"arenaAllocations\":" << stats.arenaAllocations
+					<< ",\"arenaBytes\":" << stats.arenaBytes
+					<< ",\"stemHits\":" << stats.stemHits
+					<< ",\"stemMisses\":" << stats.stemMisses
+#ifdef ALBUMBOT_DEBUGNEW
+					<< ",\"heapAllocations\":" << json2wav::QueryNumAllocs()
+#else
+					<< ",\"heapAllocations\":null"
+#endif
+					<< "}" << std::endl;
+			}
+		}
+		return 0;
+	}
+}
 
 int main(int argc, char** argv)
 {
@@ -15,22 +121,83 @@ int main(int argc, char** argv)
 		return -1;
 	static const std::string logparam0("-l");
 	static const std::string logparam1("--log");
+	static const std::string fastexitparam("--fast-exit");
+	static const std::string benchparam("--bench");
+	static const std::string runsparam("--runs");
+	static const std::string seedparam("--seed");
+	static const std::string cacheparam("--cache");
+	static const std::string cachesizeparam("--cache-size");
+	static const std::string fromparam("--from");
+	static const std::string toparam("--to");
+	static const std::string warmupparam("--warmup");
+	static const std::string segmentsparam("--segments");
+	static const std::string checkseamsparam("--check-seams");
 	bool bLog = false;
+	bool bFastExit = false;
+	bool bBench = false;
+	size_t numBenchRuns = 3;
+	std::optional<uint64_t> seed;
+	std::optional<json2wav::StemCacheOptions> stemCache;
+	uint64_t stemCacheMegabytes = 1024;
+	json2wav::RenderRange range;
+	bool bRange = false;
+	std::optional<json2wav::SegmentOptions> segments;
 	json2wav::Vector<std::string> filenames;
 	for (int i = 1; i < argc; ++i)
 	{
 		if (logparam0 == argv[i] || logparam1 == argv[i])
 			bLog = true;
+		else if (fastexitparam == argv[i])
+			bFastExit = true;
+		else if (benchparam == argv[i])
+			bBench = true;
+		else if (runsparam == argv[i] && i + 1 < argc)
+			numBenchRuns = std::strtoul(argv[++i], nullptr, 10);
+		else if (seedparam == argv[i] && i + 1 < argc)
+			seed = std::strtoull(argv[++i], nullptr, 10);
+		else if (cacheparam == argv[i] && i + 1 < argc)
+			stemCache.emplace().dir = argv[++i];
+		else if (cachesizeparam == argv[i] && i + 1 < argc)
+			stemCacheMegabytes = std::strtoull(argv[++i], nullptr, 10);
+		else if (fromparam == argv[i] && i + 1 < argc)
+		{
+			range.fromSeconds = std::strtod(argv[++i], nullptr);
+			bRange = true;
+		}
+		else if (toparam == argv[i] && i + 1 < argc)
+		{
+			range.toSeconds = std::strtod(argv[++i], nullptr);
+			bRange = true;
+		}
+		else if (warmupparam == argv[i] && i + 1 < argc)
+			range.warmupSeconds = std::strtod(argv[++i], nullptr);
+		else if (segmentsparam == argv[i] && i + 1 < argc)
+			(segments ? *segments : segments.emplace()).numSegments = std::strtoul(argv[++i], nullptr, 10);
+		else if (checkseamsparam == argv[i])
+			(segments ? *segments : segments.emplace()).bCheckSeams = true;
 		else
 			filenames.push_back(argv[i]);
 	}
+	if (stemCache)
+		stemCache->maxBytes = stemCacheMegabytes * 1024 * 1024;
+	if (bBench)
+	{
+		if (numBenchRuns == 0)
+		{
+			std::cerr << "--runs needs a positive number of runs\n";
+			return -1;
+		}
+		if (filenames.empty())
+			filenames.assign(std::begin(benchCorpus), std::end(benchCorpus));
+		return Bench(filenames, numBenchRuns, seed, stemCache ? &*stemCache : nullptr);
+	}
 	int result = 0;
-	for (const std::string& filename : filenames)
+	for (size_t i = 0; i < filenames.size(); ++i)
 	{
-		result = json2wav::JsonToWav(filename.c_str(), bLog);
+		result = json2wav::JsonToWav(filenames[i].c_str(), bLog, bFastExit && i + 1 == filenames.size(), nullptr, seed,
+			stemCache ? &*stemCache : nullptr, bRange ? &range : nullptr, segments ? &*segments : nullptr);
 		if (result != 0)
 			return result;
 	}
 	return result;
 }
-
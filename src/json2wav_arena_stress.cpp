@@ -0,0 +1,128 @@
+// Copyright Dan Price 2026.
+
+// Stress benchmark for the arena allocators: every thread allocates event-sized objects, frees half of them itself and
+// hands the other half to the next thread to free, so both the thread-local and the remote-free paths stay busy.
+
+#include "ArenaBumpAllocator.h"
+#include "CachedArenaAllocator.h"
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+
+namespace
+{
+	struct Handle
+	{
+		uint32_t TrackingIndex;
+		uint32_t ObjectSerial;
+	};
+
+	struct Inbox
+	{
+		std::mutex mtx;
+		std::vector<Handle> handles;
+	};
+
+	// Sizes of typical event and control objects
+	constexpr uint32_t eventSizes[] = { 32, 48, 64, 96, 128 };
+	constexpr size_t numEventSizes = sizeof(eventSizes) / sizeof(eventSizes[0]);
+	constexpr size_t batchSize = 256;
+
+	template<typename AllocatorType>
+	void StressThread(const size_t threadIndex, const size_t numIterations, std::vector<Inbox>& inboxes)
+	{
+		std::vector<Handle> local;
+		std::vector<Handle> outgoing;
+		std::vector<Handle> incoming;
+		local.reserve(batchSize);
+		outgoing.reserve(batchSize);
+		Inbox& next = inboxes[(threadIndex + 1) % inboxes.size()];
+		Inbox& mine = inboxes[threadIndex];
+
+		for (size_t iteration = 0; iteration < numIterations; ++iteration)
+		{
+			for (size_t i = 0; i < batchSize; ++i)
+			{
+				const uint32_t numBytes = eventSizes[(i + iteration) % numEventSizes];
+				const json2wav::AllocationTransaction allocation = AllocatorType::Allocate(numBytes, 8);
+				std::memset(allocation.Storage, static_cast<int>(i), numBytes);
+				const Handle handle{ allocation.TrackingIndex, allocation.ObjectSerial };
+				if (i & 1)
+					outgoing.push_back(handle);
+				else
+					local.push_back(handle);
+			}
+
+			for (const Handle& handle : local)
+				AllocatorType::RecycleAllocation(handle.TrackingIndex, handle.ObjectSerial);
+			local.clear();
+
+			{
+				std::scoped_lock lock(next.mtx);
+				next.handles.insert(next.handles.end(), outgoing.begin(), outgoing.end());
+			}
+			outgoing.clear();
+
+			{
+				std::scoped_lock lock(mine.mtx);
+				incoming.swap(mine.handles);
+			}
+			for (const Handle& handle : incoming)
+				AllocatorType::RecycleAllocation(handle.TrackingIndex, handle.ObjectSerial);
+			incoming.clear();
+		}
+	}
+
+	template<typename AllocatorType>
+	void RunStress(const char* const name, const size_t numThreads, const size_t numIterations)
+	{
+		std::vector<Inbox> inboxes(numThreads);
+		std::vector<std::thread> threads;
+		threads.reserve(numThreads);
+
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t threadIndex = 0; threadIndex < numThreads; ++threadIndex)
+			threads.emplace_back(StressThread<AllocatorType>, threadIndex, numIterations, std::ref(inboxes));
+		for (std::thread& thread : threads)
+			thread.join();
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		// Whatever the last round handed off is still outstanding
+		size_t numOutstanding = 0;
+		for (Inbox& inbox : inboxes)
+		{
+			for (const Handle& handle : inbox.handles)
+				AllocatorType::RecycleAllocation(handle.TrackingIndex, handle.ObjectSerial);
+			numOutstanding += inbox.handles.size();
+		}
+
+		const double numAllocations = static_cast<double>(numThreads * numIterations * batchSize);
+		std::cout << name << ": " << numThreads << " threads, " << numIterations * batchSize << " allocations per thread, "
+			<< seconds << " s, " << numAllocations / seconds * 1.0e-6 << " M alloc+free/s ("
+			<< numOutstanding << " freed after join)" << std::endl;
+
+		AllocatorType::TearDown();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+	const size_t numThreads = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : (hardwareThreads > 0 ? hardwareThreads : 4);
+	const size_t numIterations = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 2000;
+	if (numThreads == 0 || numIterations == 0)
+	{
+		std::cerr << "Usage: json2wav_arena_stress [threads] [iterations]" << std::endl;
+		return -1;
+	}
+
+	RunStress<json2wav::CachedArenaAllocator>("CachedArenaAllocator", numThreads, numIterations);
+	RunStress<json2wav::ArenaBumpAllocator>("ArenaBumpAllocator", numThreads, numIterations);
+	return 0;
+}
@@ -0,0 +1,580 @@
+// Copyright Dan Price 2026.
+
+// Microbenchmarks for the render's hot kernels. Each kernel runs on its own, a block at a time, over the same
+// precomputed noise, with a warm-up pass and several timed repetitions; the best and median repetitions are reported.
+
+#include "Sample.h"
+#include "SampleKernels.h"
+#include "IAudioObject.h"
+#include "Oversampler.h"
+#include "Filter.h"
+#include "DrumHitSynth.h"
+#include "AdditiveHitSynth.h"
+#include "InfiniSaw.h"
+#include "NoiseSynth.h"
+#include "ChebyDist.h"
+#include "FDNVerb.h"
+#include "Compressor.h"
+#include "Delay.h"
+#include "Fader.h"
+#include "Panner.h"
+#include "MSProc.h"
+#include "FusedPointwise.h"
+#include "OversampledIsland.h"
+#include "Memory.h"
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <utility>
+#include <iostream>
+#include <iomanip>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+
+namespace
+{
+	using namespace json2wav;
+
+	constexpr unsigned long benchSampleRate = 44100;
+
+	struct Options
+	{
+		size_t blockSize = sampleChunkNum;
+		double seconds = 1.0;
+		size_t numReps = 5;
+		bool bJson = false;
+		std::string filter;
+	};
+
+	struct Result
+	{
+		std::string name;
+		size_t numSamples;
+		double bestNs;
+		double medianNs;
+	};
+
+	// Stores the compiler can't drop, for kernels whose output nothing else reads
+	volatile float sink = 0.0f;
+
+	/** Plays the same seeded noise on every channel offset, so effects see identical input from run to run */
+	class NoiseSource : public IAudioObject
+	{
+	public:
+		NoiseSource(const size_t numChannelsInit, const size_t lengthInit)
+			: noise(numChannelsInit, lengthInit), pos(0)
+		{
+			std::mt19937 mt(0x5eed);
+			std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+			for (size_t ch = 0; ch < noise.GetNumChannels(); ++ch)
+				for (float& value : noise.GetSpan(ch))
+					value = dist(mt);
+		}
+
+		virtual void GetSamples(
+			Sample* const* const bufs,
+			const size_t numChannels,
+			const size_t bufSize,
+			const unsigned long sampleRate,
+			IAudioObject* const requester) noexcept override
+		{
+			const size_t length = noise.GetBufSize();
+			const size_t numCopyChannels = (numChannels < noise.GetNumChannels()) ? numChannels : noise.GetNumChannels();
+			size_t done = 0;
+			while (done < bufSize)
+			{
+				const size_t numCopy = std::min(bufSize - done, length - pos);
+				for (size_t ch = 0; ch < numCopyChannels; ++ch)
+					std::memcpy(bufs[ch] + done, noise[ch] + pos, numCopy * sizeof(Sample));
+				done += numCopy;
+				pos = (pos + numCopy) % length;
+			}
+		}
+
+		virtual size_t GetNumChannels() const noexcept override
+		{
+			return noise.GetNumChannels();
+		}
+
+	private:
+		SampleBuf noise;
+		size_t pos;
+	};
+
+	class Bench
+	{
+	public:
+		explicit Bench(const Options& optionsInit)
+			: options(optionsInit),
+			numBlocks(std::max<size_t>(1, static_cast<size_t>(options.seconds * benchSampleRate) / options.blockSize))
+		{
+		}
+
+		const Options& GetOptions() const noexcept { return options; }
+
+		/** Samples one warm-up pass and every repetition render between them, for scheduling events up front */
+		size_t GetTotalSamples() const noexcept
+		{
+			return (options.numReps + 1) * numBlocks * options.blockSize;
+		}
+
+		bool IsSelected(const std::string& name) const
+		{
+			return options.filter.empty() || name.find(options.filter) != std::string::npos;
+		}
+
+		/** processBlock(numSamples) renders one block; a sample is one frame, however many channels the kernel has */
+		template<typename ProcessBlockType>
+		void Run(const std::string& name, ProcessBlockType&& processBlock)
+		{
+			if (!IsSelected(name))
+				return;
+
+			const auto pass = [this, &processBlock]()
+			{
+				const auto start = std::chrono::steady_clock::now();
+				for (size_t block = 0; block < numBlocks; ++block)
+					processBlock(options.blockSize);
+				return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+			};
+
+			pass();
+			std::vector<double> times;
+			for (size_t rep = 0; rep < options.numReps; ++rep)
+				times.push_back(pass());
+			std::sort(times.begin(), times.end());
+
+			const size_t numSamples = numBlocks * options.blockSize;
+			const Result& result = results.emplace_back(Result{ name, numSamples, times.front(), times[times.size() / 2] });
+			if (!options.bJson)
+			{
+				std::cout << std::left << std::setw(40) << result.name << std::right << std::fixed << std::setprecision(2)
+					<< std::setw(12) << SamplesPerSecond(result) * 1.0e-6 << " Msmp/s"
+					<< std::setw(10) << NsPerSample(result.bestNs, result) << " ns/smp"
+					<< std::setw(10) << NsPerSample(result.medianNs, result) << " median" << std::defaultfloat << std::endl;
+			}
+		}
+
+		void PrintJson() const
+		{
+			std::cout << "{\n\t\"blockSize\": " << options.blockSize << ",\n\t\"sampleRate\": " << benchSampleRate
+				<< ",\n\t\"reps\": " << options.numReps << ",\n\t\"results\": [";
+			for (size_t i = 0; i < results.size(); ++i)
+			{
+				const Result& result = results[i];
+				std::cout << ((i > 0) ? ",\n" : "\n") << std::setprecision(6)
+					<< "\t\t{ \"name\": \"" << result.name << "\", \"samples\": " << result.numSamples
+					<< ", \"samplesPerSecond\": " << SamplesPerSecond(result)
+					<< ", \"nsPerSample\": " << NsPerSample(result.bestNs, result)
+					<< ", \"medianNsPerSample\": " << NsPerSample(result.medianNs, result) << " }";
+			}
+			std::cout << "\n\t]\n}" << std::endl;
+		}
+
+	private:
+		static double NsPerSample(const double ns, const Result& result)
+		{
+			return ns / static_cast<double>(result.numSamples);
+		}
+
+		static double SamplesPerSecond(const Result& result)
+		{
+			return static_cast<double>(result.numSamples) * 1.0e9 / result.bestNs;
+		}
+
+		Options options;
+		size_t numBlocks;
+		std::vector<Result> results;
+	};
+
+	void BenchOversampling(Bench& bench)
+	{
+		const size_t blockSize = bench.GetOptions().blockSize;
+		NoiseSource source(1, 2 * blockSize);
+		SampleBuf noise(1, 2 * blockSize);
+		source.GetSamples(noise.get(), 1, 2 * blockSize, benchSampleRate, nullptr);
+		const float* const in = noise.GetSpan(0).data();
+		std::vector<float> out(2 * blockSize);
+
+		oversampling::upsampler441_x2<float> upsampler;
+		bench.Run("oversampling/interpolate2", [&](const size_t numSamples)
+			{
+				upsampler.process_unsafe(numSamples, in, out.data());
+				sink = out[0];
+			});
+
+		oversampling::downsampler441_x2<float> downsampler;
+		bench.Run("oversampling/decimate2", [&](const size_t numSamples)
+			{
+				downsampler.process_unsafe(numSamples, in, out.data());
+				sink = out[0];
+			});
+	}
+
+	/** Runs any effect on stereo noise */
+	template<typename EffectType>
+	void BenchEffect(Bench& bench, const std::string& name, const SharedPtr<EffectType>& effect)
+	{
+		if (!bench.IsSelected(name))
+			return;
+
+		const size_t blockSize = bench.GetOptions().blockSize;
+		SharedPtr<NoiseSource> source(MakeShared<NoiseSource>(2, 16 * blockSize));
+		effect->AddInput(source);
+		SampleBuf out(2, blockSize);
+		bench.Run(name, [&](const size_t numSamples)
+			{
+				effect->GetSamples(out.get(), 2, numSamples, benchSampleRate, nullptr);
+			});
+	}
+
+	template<Filter::ETopo eTopo, uint_fast8_t... orders>
+	void BenchFilters(Bench& bench, const char* const topoName, std::integer_sequence<uint_fast8_t, orders...>)
+	{
+		(BenchEffect(bench, std::string("Filter/") + topoName + "/order" + std::to_string(orders),
+			MakeShared<Filter::BesselLP<orders, false, 2, eTopo>>(2000.0f)), ...);
+	}
+
+	/** Bessel filters as float sections, and as the single direct-form polynomial they ran as before sections */
+	template<Filter::ETopo eTopo, uint_fast8_t... orders>
+	void BenchFilterForms(Bench& bench, const char* const topoName, std::integer_sequence<uint_fast8_t, orders...>)
+	{
+		(BenchEffect(bench, std::string("Filter/") + topoName + "/float/order" + std::to_string(orders),
+			MakeShared<Filter::BesselLP_Custom<orders, false, 2, eTopo, double, float>>(2000.0f)), ...);
+		(BenchEffect(bench, std::string("Filter/") + topoName + "/direct/order" + std::to_string(orders),
+			MakeShared<Filter::LaplaceFilter<orders, Filter::BesselLPLaplace<double, orders>, false, 2, double, eTopo>>(2000.0f)), ...);
+	}
+
+	/** The seven cookbook biquads, ladders at their usual orders, and a biquad swept by a ramp through its control path */
+	template<Filter::ETopo eTopo>
+	void BenchBiquads(Bench& bench, const char* const topoName)
+	{
+		const std::string prefix = std::string("Filter/") + topoName + "/";
+		BenchEffect(bench, prefix + "BiquadLP", MakeShared<Filter::BiquadLP<false, 2, eTopo>>(2000.0f, 0.7f));
+		BenchEffect(bench, prefix + "BiquadHP", MakeShared<Filter::BiquadHP<false, 2, eTopo>>(2000.0f, 0.7f));
+		BenchEffect(bench, prefix + "BiquadAP", MakeShared<Filter::BiquadAP<false, 2, eTopo>>(2000.0f, 0.7f));
+		BenchEffect(bench, prefix + "BiquadNotch", MakeShared<Filter::BiquadNotch<false, 2, eTopo>>(2000.0f, 0.7f));
+		BenchEffect(bench, prefix + "BiquadPeak", MakeShared<Filter::BiquadPeak<false, 2, eTopo>>(2000.0f, 0.7f, 6.0f));
+		BenchEffect(bench, prefix + "BiquadLoShelf", MakeShared<Filter::BiquadLoShelf<false, 2, eTopo>>(2000.0f, 0.7f, 6.0f));
+		BenchEffect(bench, prefix + "BiquadHiShelf", MakeShared<Filter::BiquadHiShelf<false, 2, eTopo>>(2000.0f, 0.7f, 6.0f));
+		BenchEffect(bench, prefix + "LadderLP/order2", MakeShared<Filter::LadderLP_Custom<false, 2, eTopo, 2>>(2000.0f, 0.5f));
+		BenchEffect(bench, prefix + "LadderLP/order4", MakeShared<Filter::LadderLP_Custom<false, 2, eTopo, 4>>(2000.0f, 0.5f));
+
+		// A ramp far longer than the run keeps every control update recalculating
+		for (const uint_fast16_t controlUpdate : { 1, 32 })
+		{
+			SharedPtr<Filter::BiquadLP<false, 2, eTopo>> sweep(MakeShared<Filter::BiquadLP<false, 2, eTopo>>(200.0f, 0.7f, 0.0f, controlUpdate));
+			sweep->SetFrequency(Ramp(8000.0f, 3600.0));
+			BenchEffect(bench, prefix + "BiquadLP/sweep" + std::to_string(controlUpdate), sweep);
+
+			SharedPtr<Filter::LadderLP<false, 2, eTopo>> ladderSweep(MakeShared<Filter::LadderLP<false, 2, eTopo>>(200.0f, 0.5f, 0.0f, controlUpdate));
+			ladderSweep->SetFrequency(Ramp(8000.0f, 3600.0));
+			BenchEffect(bench, prefix + "LadderLP/sweep" + std::to_string(controlUpdate), ladderSweep);
+		}
+	}
+
+	template<size_t... orders>
+	void BenchChebyDists(Bench& bench, std::index_sequence<orders...>)
+	{
+		constexpr EChebyDistWaveShaper eWaveShaper = EChebyDistWaveShaper::InverseSquareGaussianBoost;
+		(BenchEffect(bench, "ChebyDist/order" + std::to_string(orders),
+			MakeShared<ChebyDist<double, orders, sampleChunkNum/2, eWaveShaper>>()), ...);
+	}
+
+	void BenchCompressors(Bench& bench)
+	{
+		CompressorParams params;
+		params.threshold_db = -12.0;
+		params.ratio = 4.0;
+		params.knee_db = 1.0;
+		params.attackSamples = 5.0*44.1;
+		params.releaseSamples = 25.0*44.1;
+		params.dryVolume_db = -145.0f;
+		params.df2 = false;
+
+		SharedPtr<Compressor<>> lr(MakeShared<Compressor<>>());
+		lr->SetParams(params, false);
+		BenchEffect(bench, "Compressor/LR", lr);
+
+		SharedPtr<Compressor<>> m(MakeShared<Compressor<>>());
+		m->SetParams(params, true);
+		BenchEffect(bench, "Compressor/M", m);
+
+		CompressorParams sideParams(params);
+		sideParams.threshold_db = -18.0;
+		SharedPtr<Compressor<>> ms(MakeShared<Compressor<>>());
+		ms->SetParams(params, sideParams);
+		BenchEffect(bench, "Compressor/MS", ms);
+
+		// The same compressors with their envelopes at a control rate
+		params.controlDecimation = 8;
+		sideParams.controlDecimation = 8;
+
+		SharedPtr<Compressor<>> lrDecimated(MakeShared<Compressor<>>());
+		lrDecimated->SetParams(params, false);
+		BenchEffect(bench, "Compressor/LR/decimate8", lrDecimated);
+
+		SharedPtr<Compressor<>> mDecimated(MakeShared<Compressor<>>());
+		mDecimated->SetParams(params, true);
+		BenchEffect(bench, "Compressor/M/decimate8", mDecimated);
+
+		SharedPtr<Compressor<>> msDecimated(MakeShared<Compressor<>>());
+		msDecimated->SetParams(params, sideParams);
+		BenchEffect(bench, "Compressor/MS/decimate8", msDecimated);
+	}
+
+	void BenchDelays(Bench& bench)
+	{
+		// Shorter than a block, echoing within it, and longer, copying whole blocks through the ring
+		for (const float time : { 0.005f, 0.3f })
+		{
+			const std::string prefix = std::string("Delay/") + ((time < 0.01f) ? "short" : "long");
+			BenchEffect(bench, prefix, MakeShared<Delay<false>>(time, 0.6f));
+
+			SharedPtr<Delay<false, DelayFilter::BesselLP<2>>> filtered(MakeShared<Delay<false, DelayFilter::BesselLP<2>>>(time, 0.6f));
+			filtered->GetFeedbackFilter().Recalc(1.0f / static_cast<float>(benchSampleRate), 3000.0f);
+			BenchEffect(bench, prefix + "/bessel2", filtered);
+		}
+	}
+
+	/** The ring mod join on its own, multiplying channels of noise, since a RingMod node launches a thread per input */
+	void BenchRingMods(Bench& bench)
+	{
+		const size_t blockSize = bench.GetOptions().blockSize;
+		for (const size_t numInputs : { 2, 4 })
+		{
+			NoiseSource source(numInputs, 16 * blockSize);
+			SampleBuf in(numInputs, blockSize);
+			SampleBuf out(1, blockSize);
+			RingModJoin join;
+			bench.Run("RingModJoin/" + std::to_string(numInputs), [&](const size_t numSamples)
+				{
+					source.GetSamples(in.get(), numInputs, numSamples, benchSampleRate, nullptr);
+					join.JoinChannel(0, in.get(), out[0], numSamples, numInputs);
+					sink = out[0][0].AsFloat32();
+				});
+		}
+	}
+
+	/**
+	 * A fader and a panner on their own, then an M/S panning chain into a fader as separate nodes and fused into one; the
+	 * ramped runs sweep throughout
+	 */
+	void BenchPointwise(Bench& bench)
+	{
+		BenchEffect(bench, "Fader", MakeShared<Fader<>>(-3.0f));
+		SharedPtr<Fader<>> faderSweep(MakeShared<Fader<>>(-3.0f));
+		faderSweep->SetGainDB(Ramp(-24.0f, 3600.0));
+		BenchEffect(bench, "Fader/ramped", faderSweep);
+
+		BenchEffect(bench, "Panner", MakeShared<Panner<>>(0.3f));
+		SharedPtr<Panner<>> panSweep(MakeShared<Panner<>>(-0.9f));
+		panSweep->SetPan(Ramp(0.9f, 3600.0));
+		BenchEffect(bench, "Panner/ramped", panSweep);
+
+		for (const bool bRamped : { false, true })
+		{
+			for (const bool bFused : { false, true })
+			{
+				const std::string name = std::string("Pointwise/") + (bFused ? "fused" : "chain") + (bRamped ? "/ramped" : "");
+				if (!bench.IsSelected(name))
+					continue;
+
+				SharedPtr<Fader<>> fader(MakeShared<Fader<>>(-3.0f));
+				if (bRamped)
+					fader->SetGainDB(Ramp(-24.0f, 3600.0));
+
+				// Laid out like an interpreter chain: the last effect takes the input and the first is the output
+				Vector<SharedPtr<AudioJoin<>>> effects{ fader, MakeShared<LRConverter<>>(), MakeShared<Panner<>>(0.3f), MakeShared<MSConverter<>>() };
+				for (size_t idx = 0; idx + 1 < effects.size(); ++idx)
+					effects[idx]->AddInput(effects[idx + 1]);
+
+				const size_t blockSize = bench.GetOptions().blockSize;
+				SharedPtr<NoiseSource> source(MakeShared<NoiseSource>(2, 16 * blockSize));
+				effects.back()->AddInput(source);
+				if (bFused)
+					FusePointwiseChain(effects, nullptr);
+
+				SampleBuf out(2, blockSize);
+				bench.Run(name, [&](const size_t numSamples)
+					{
+						effects[0]->GetSamples(out.get(), 2, numSamples, benchSampleRate, nullptr);
+					});
+			}
+		}
+	}
+
+	/**
+	 * A bus ring modding two inputs into an order 2 distortion and an LR compressor, as separate nodes that each go up to
+	 * 2x and back and then as one oversampled island
+	 */
+	void BenchIslands(Bench& bench)
+	{
+		constexpr EChebyDistWaveShaper eWaveShaper = EChebyDistWaveShaper::InverseSquareGaussianBoost;
+		CompressorParams params;
+		params.threshold_db = -12.0;
+		params.ratio = 4.0;
+		params.knee_db = 1.0;
+		params.attackSamples = 5.0*44.1;
+		params.releaseSamples = 25.0*44.1;
+		params.dryVolume_db = -145.0f;
+		params.df2 = false;
+
+		for (const bool bIsland : { false, true })
+		{
+			const std::string name = std::string("Island/") + (bIsland ? "fused" : "separate");
+			if (!bench.IsSelected(name))
+				continue;
+
+			SharedPtr<Compressor<>> compressor(MakeShared<Compressor<>>());
+			compressor->SetParams(params, false);
+			// Laid out like an interpreter chain: the last effect takes the input and the first is the output. With the
+			// ring mod at the front, the island reports 128 samples less delay than the separate nodes
+			Vector<SharedPtr<AudioJoin<>>> effects{ compressor,
+				MakeShared<ChebyDist<double, 2, sampleChunkNum/2, eWaveShaper>>(), MakeShared<BasicRingMod<>>() };
+			for (size_t idx = 0; idx + 1 < effects.size(); ++idx)
+				effects[idx]->AddInput(effects[idx + 1]);
+
+			// The ring mod holds its inputs weakly, so the sources live here
+			const size_t blockSize = bench.GetOptions().blockSize;
+			const SharedPtr<NoiseSource> sources[2] = {
+				MakeShared<NoiseSource>(2, 16 * blockSize), MakeShared<NoiseSource>(2, 16 * blockSize + 1) };
+			for (const SharedPtr<NoiseSource>& source : sources)
+				effects.back()->AddInput(source);
+			if (bIsland)
+				FuseOversampledChain(effects, nullptr);
+
+			SampleBuf out(2, blockSize);
+			bench.Run(name, [&](const size_t numSamples)
+				{
+					effects[0]->GetSamples(out.get(), 2, numSamples, benchSampleRate, nullptr);
+				});
+		}
+	}
+
+	/** Renders a mono synth, calling schedule(synth) first to lay out its events for the whole run */
+	template<typename SynthType, typename ScheduleType>
+	void BenchSynth(Bench& bench, const std::string& name, SynthType& synth, ScheduleType&& schedule)
+	{
+		if (!bench.IsSelected(name))
+			return;
+
+		schedule(synth);
+		SampleBuf out(1, bench.GetOptions().blockSize);
+		bench.Run(name, [&](const size_t numSamples)
+			{
+				synth.GetSamples(out.get(), 1, numSamples, benchSampleRate, nullptr);
+			});
+	}
+
+	void BenchSynths(Bench& bench)
+	{
+		// A hit every quarter second keeps the hit synths busy attacking and decaying
+		const auto scheduleHits = [&bench](auto& synth)
+		{
+			for (size_t sampleNum = 0; sampleNum < bench.GetTotalSamples(); sampleNum += benchSampleRate / 4)
+				synth.AddEvent(sampleNum, 1.0f, 0.25f);
+		};
+		const auto scheduleNone = [](auto&) {};
+
+		DrumHitSynth drum(100.0f);
+		BenchSynth(bench, "DrumHitSynth", drum, scheduleHits);
+
+		AdditiveHitSynth additive(100.0f);
+		BenchSynth(bench, "AdditiveHitSynth", additive, scheduleHits);
+
+		static constexpr const char* precisionNames[] = {
+			"Precise", "Fast", "ExtraFast",
+			"MPrecise", "MFast", "MExtraFast",
+			"RPrecise", "RFast", "RExtraFast",
+			"HPrecise", "HFast", "HExtraFast"
+		};
+		static_assert(std::size(precisionNames) == static_cast<size_t>(EInfiniSawPrecision::Num), "Name every precision");
+		for (size_t precision = 0; precision < std::size(precisionNames); ++precision)
+		{
+			InfiniSaw saw(220.0f, 0.5f, 0.0, static_cast<EInfiniSawPrecision>(precision));
+			BenchSynth(bench, std::string("InfiniSaw/") + precisionNames[precision], saw, scheduleNone);
+		}
+
+		NoiseSynth noise(0.5f);
+		BenchSynth(bench, "NoiseSynth", noise, scheduleNone);
+	}
+
+	void BenchConversion(Bench& bench)
+	{
+		const size_t blockSize = bench.GetOptions().blockSize;
+		NoiseSource source(2, blockSize);
+		SampleBuf in(2, blockSize);
+		source.GetSamples(in.get(), 2, blockSize, benchSampleRate, nullptr);
+		std::vector<uint8_t> out(2 * blockSize * sizeof(float));
+
+		const auto run = [&]<ESampleType eSampleType>(const char* const name)
+		{
+			constexpr size_t frameSize = 2 * GetSampleSize(eSampleType);
+			bench.Run(name, [&](const size_t numSamples)
+				{
+					for (size_t ch = 0; ch < 2; ++ch)
+						kernel::Convert<eSampleType>(in.GetSpan(ch).first(numSamples), out.data() + ch * GetSampleSize(eSampleType), frameSize);
+					sink = static_cast<float>(out[0]);
+				});
+		};
+		run.operator()<ESampleType::Int16>("Convert/Int16");
+		run.operator()<ESampleType::Int24>("Convert/Int24");
+		run.operator()<ESampleType::Float32>("Convert/Float32");
+	}
+
+	int Usage()
+	{
+		std::cerr << "Usage: json2wav_bench [--json] [--block samples] [--seconds perRep] [--reps count] [name filter]" << std::endl;
+		return -1;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg(argv[i]);
+		const bool bHasValue = i + 1 < argc;
+		if (arg == "--json")
+			options.bJson = true;
+		else if (arg == "--block" && bHasValue)
+			options.blockSize = std::strtoul(argv[++i], nullptr, 10);
+		else if (arg == "--seconds" && bHasValue)
+			options.seconds = std::strtod(argv[++i], nullptr);
+		else if (arg == "--reps" && bHasValue)
+			options.numReps = std::strtoul(argv[++i], nullptr, 10);
+		else if (arg.starts_with("--") || !options.filter.empty())
+			return Usage();
+		else
+			options.filter = arg;
+	}
+	if (options.blockSize == 0 || options.numReps == 0 || !(options.seconds > 0.0))
+		return Usage();
+
+	Bench bench(options);
+	BenchOversampling(bench);
+	BenchFilters<Filter::ETopo::DF2>(bench, "DF2", std::integer_sequence<uint_fast8_t, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10>());
+	BenchFilters<Filter::ETopo::TDF2>(bench, "TDF2", std::integer_sequence<uint_fast8_t, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10>());
+	BenchFilterForms<Filter::ETopo::DF2>(bench, "DF2", std::integer_sequence<uint_fast8_t, 2, 4, 8, 10>());
+	BenchFilterForms<Filter::ETopo::TDF2>(bench, "TDF2", std::integer_sequence<uint_fast8_t, 2, 4, 8, 10>());
+	BenchBiquads<Filter::ETopo::DF2>(bench, "DF2");
+	BenchBiquads<Filter::ETopo::TDF2>(bench, "TDF2");
+	BenchSynths(bench);
+	BenchChebyDists(bench, std::index_sequence<2, 3, 4, 5, 6>());
+	BenchEffect(bench, "FDNVerb", MakeShared<FDNVerb<>>(1.5));
+	BenchCompressors(bench);
+	BenchDelays(bench);
+	BenchRingMods(bench);
+	BenchIslands(bench);
+	BenchPointwise(bench);
+	BenchConversion(bench);
+
+	if (options.bJson)
+		bench.PrintJson();
+	return 0;
+}